@@ -0,0 +1,382 @@
+/**
+ * @file doxy_bench.c
+ * @brief Per-stage benchmark of the doxy pipeline over a generated corpus.
+ * @details Times config indexing, per-file parsing (single thread and on the
+ *			worker pool), markdown generation (plain, with the symbol index
+ *			and links, and through a compiled template of the same layout), JSON
+ *			and HTML generation, output writing, and writing markdown alone
+ *			against markdown, JSON and HTML fanned out concurrently, separately and
+ *			prints one JSON object with files/s, MB/s, heap allocations and peak
+ *			RSS per stage, so runs can be diffed.
+ *			Usage: doxy_bench [-j jobs] [-o out.json] <corpus_dir>
+ */
+#define _POSIX_C_SOURCE 200809L
+#include "parser.h"
+#include "md_generator.h"
+#include "strmap.h"
+#include "symbols.h"
+#include "template.h"
+#include "formats.h"
+#include "json_generator.h"
+#include "html_generator.h"
+#include "writer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/*	the built-in markdown layout as a template: its output must match byte for byte */
+static const char BUILTIN_LAYOUT[] =
+	"{{#brief}}\n"
+	"#### {{#is_file}}File: {{file}}{{/is_file}}{{^is_file}}{{name}}{{^name}}File{{/name}}{{/is_file}}\n"
+	"{{brief}}\n"
+	"\n"
+	"{{/brief}}\n"
+	"{{#details}}\n"
+	"{{details}}\n"
+	"\n"
+	"{{/details}}\n"
+	"{{#see}}\n"
+	"{{#first}}**See also:** {{/first}}{{^first}}, {{/first}}{{text}}{{#last}}\n"
+	"\n"
+	"{{/last}}\n"
+	"{{/see}}\n"
+	"{{#signature}}\n"
+	"``` c\n"
+	"{{signature}}\n"
+	"```  \n"
+	"{{/signature}}\n";
+
+/*	walks of the parse results timed by the iterate stage */
+#define ITERATE_PASSES 20
+
+/* structure representing one measured stage */
+struct stage_s {
+	const char* name;	/**< Stage name */
+	double seconds;		/**< Wall time */
+	long files;			/**< Files handled */
+	size_t bytes;		/**< Bytes read or written */
+	long lines;			/**< Source lines handled (parse stages) */
+	long allocs;		/**< Heap allocations made */
+	long peak_rss_kb;	/**< Peak resident set during the stage */
+};
+
+//	heap allocations, counted by interposing the allocator (glibc)
+extern void* __libc_malloc(size_t);
+extern void* __libc_calloc(size_t, size_t);
+extern void* __libc_realloc(void*, size_t);
+extern void __libc_free(void*);
+static long ALLOCS = 0;
+
+void* malloc(size_t size) {
+	__atomic_add_fetch(&ALLOCS, 1, __ATOMIC_RELAXED);
+	return __libc_malloc(size);
+}
+void* calloc(size_t n, size_t size) {
+	__atomic_add_fetch(&ALLOCS, 1, __ATOMIC_RELAXED);
+	return __libc_calloc(n, size);
+}
+void* realloc(void* ptr, size_t size) {
+	__atomic_add_fetch(&ALLOCS, 1, __ATOMIC_RELAXED);
+	return __libc_realloc(ptr, size);
+}
+void free(void* ptr) {
+	__libc_free(ptr);
+}
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+/**
+ * @brief Resets the kernel's peak RSS counter (Linux clear_refs), if allowed.
+ */
+static void reset_peak(void) {
+	FILE* f = fopen("/proc/self/clear_refs", "w");
+	if (!f) return;
+	fputs("5", f);
+	fclose(f);
+}
+/**
+ * @brief Reads the peak RSS since the last reset, in KB.
+ */
+static long peak_rss(void) {
+	char line[256];
+	long kb = -1;
+	FILE* f = fopen("/proc/self/status", "r");
+	while (f && fgets(line, sizeof(line), f)) {
+		if (strncmp(line, "VmHWM:", 6) == 0) kb = strtol(line + 6, NULL, 10);
+	}
+	if (f) fclose(f);
+	if (kb < 0) {
+		struct rusage ru;
+		if (getrusage(RUSAGE_SELF, &ru) == 0) kb = ru.ru_maxrss;
+	}
+	return kb;
+}
+static void stage_begin(struct stage_s* st, const char* name) {
+	memset(st, 0, sizeof(*st));
+	st->name = name;
+	reset_peak();
+	st->allocs = __atomic_load_n(&ALLOCS, __ATOMIC_RELAXED);
+	st->seconds = now();
+}
+static void stage_end(struct stage_s* st) {
+	st->seconds = now() - st->seconds;
+	st->allocs = __atomic_load_n(&ALLOCS, __ATOMIC_RELAXED) - st->allocs;
+	st->peak_rss_kb = peak_rss();
+}
+static size_t file_size(const char* path) {
+	struct stat st;
+	return stat(path, &st) == 0 ? (size_t)st.st_size : 0;
+}
+/**
+ * @brief Counts the lines of a file.
+ */
+static long count_lines(const char* path) {
+	char block[65536];
+	long lines = 0;
+	size_t n;
+	FILE* f = fopen(path, "rb");
+	if (!f) return 0;
+	while ((n = fread(block, 1, sizeof(block), f)) > 0) {
+		for (const char* p = block; (p = memchr(p, '\n', block + n - p)); p++) lines++;
+	}
+	fclose(f);
+	return lines;
+}
+static void print_stage(FILE* out, const struct stage_s* st, int last) {
+	double s = st->seconds > 0 ? st->seconds : 1e-9;
+	fprintf(out, "    {\"name\": \"%s\", \"seconds\": %.6f, \"files\": %ld, \"bytes\": %zu, "
+	             "\"files_per_s\": %.1f, \"mb_per_s\": %.2f, ",
+	        st->name, st->seconds, st->files, st->bytes, st->files / s, st->bytes / s / (1024.0 * 1024.0));
+	if (st->lines) fprintf(out, "\"lines\": %ld, \"ns_per_line\": %.2f, ", st->lines, st->seconds * 1e9 / st->lines);
+	fprintf(out, "\"allocs\": %ld, \"peak_rss_kb\": %ld}%s\n", st->allocs, st->peak_rss_kb, last ? "" : ",");
+}
+
+int main(int argc, char** argv) {
+	doxy_config config = { .file = "Doxy2MD", .target = "default" };
+	const char* json = NULL;
+	const char* corpus = NULL;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+			config.jobs = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+			json = argv[++i];
+		} else {
+			corpus = argv[i];
+		}
+	}
+	//	the report path is relative to the caller, sources to the corpus
+	FILE* out = json ? fopen(json, "w") : stdout;
+	if (!out) {
+		fprintf(stderr, "doxy_bench: cannot write %s\n", json);
+		return 1;
+	}
+	if (!corpus || chdir(corpus) != 0) {
+		fprintf(stderr, "usage: doxy_bench [-j jobs] [-o out.json] <corpus_dir>\n");
+		return 1;
+	}
+
+	enum { INDEX, PARSE, PARSE_POOL, ITERATE, GENERATE, GENERATE_LINKS, GENERATE_TEMPLATE, GENERATE_JSON, GENERATE_HTML, WRITE, WRITE_UNCHANGED, WRITE_MD, WRITE_FORMATS, STAGES };
+	struct stage_s stages[STAGES];
+
+	//	config indexing: read Doxy2MD, resolve targets, expand wildcards
+	stage_begin(&stages[INDEX], "index");
+	list documents = Parser.resolveTargets(&config, NULL);
+	stage_end(&stages[INDEX]);
+	if (!documents) return 1;
+
+	list files = List.new(256);
+	strmap seen = StrMap.new(256);
+	for (int i = 0; i < List.count(documents); i++) {
+		document d = List.getAt(documents, i);
+		for (int j = 0; j < List.count(d->sources); j++) {
+			string path = List.getAt(d->sources, j);
+			if (StrMap.get(seen, path)) continue;
+			StrMap.put(seen, path, path);
+			List.add(files, path);
+		}
+	}
+	stages[INDEX].files = List.count(files);
+	stages[INDEX].bytes = file_size(config.file);
+	long lines = 0;
+	for (int i = 0; i < List.count(files); i++) lines += count_lines(List.getAt(files, i));
+
+	//	process_file, one file at a time on this thread
+	stage_begin(&stages[PARSE], "parse");
+	for (int i = 0; i < List.count(files); i++) {
+		unit u = NULL;
+		string path = List.getAt(files, i);
+		if (Parser.parseFile(&config, path, &u) != 0) return 1;
+		stages[PARSE].bytes += u ? u->src->size : file_size(path);
+		free_unit(u);
+	}
+	stage_end(&stages[PARSE]);
+	stages[PARSE].files = List.count(files);
+	stages[PARSE].lines = lines;
+
+	//	the whole parse as the CLI runs it: index, worker pool, shared units
+	stage_begin(&stages[PARSE_POOL], "parse_pool");
+	list parsed = Parser.parseTargets(&config, NULL);
+	stage_end(&stages[PARSE_POOL]);
+	if (!parsed) return 1;
+	stages[PARSE_POOL].files = stages[PARSE].files;
+	stages[PARSE_POOL].bytes = stages[PARSE].bytes;
+	stages[PARSE_POOL].lines = lines;
+	arena_stats held = Arena.stats();
+	long comments = 0;
+	for (int i = 0; i < List.count(parsed); i++) {
+		document d = List.getAt(parsed, i);
+		for (int j = 0; j < List.count(d->units); j++) comments += ((unit)List.getAt(d->units, j))->count;
+	}
+
+	//	walk the parse results the way generators do: comments, sections, lines
+	stage_begin(&stages[ITERATE], "iterate");
+	size_t walked = 0;
+	for (int pass = 0; pass < ITERATE_PASSES; pass++) {
+		for (int i = 0; i < List.count(parsed); i++) {
+			document d = List.getAt(parsed, i);
+			for (int j = 0; j < List.count(d->units); j++) {
+				unit u = List.getAt(d->units, j);
+				for (int k = 0; k < u->count; k++) {
+					comment c = &u->comments[k];
+					walked += c->signature.length + c->func_name.length;
+					for (int t = 0; t < c->tags.count; t++) {
+						const tag* g = &c->tags.items[t];
+						for (int l = 0; l < g->count; l++) walked += c->lines.items[g->first + l].length;
+					}
+					for (int p = 0; p < c->params.count; p++) walked += c->params.items[p].length;
+				}
+			}
+			stages[ITERATE].files += List.count(d->units);
+		}
+	}
+	stage_end(&stages[ITERATE]);
+	stages[ITERATE].bytes = walked;
+
+	//	md_generate into memory, one document per target
+	list outputs = List.new(List.count(parsed));
+	stage_begin(&stages[GENERATE], "generate");
+	for (int i = 0; i < List.count(parsed); i++) {
+		document d = List.getAt(parsed, i);
+		string_builder sb = StringBuilder.new(1 << 20);
+		MDGenerator.generate(sb, d->units, NULL, NULL);
+		string md = StringBuilder.toString(sb);
+		StringBuilder.free(sb);
+		stages[GENERATE].bytes += strlen(md);
+		stages[GENERATE].files += List.count(d->units);
+		List.add(outputs, md);
+	}
+	stage_end(&stages[GENERATE]);
+	
+	//	the same with --links: build each document's symbol index, then link
+	stage_begin(&stages[GENERATE_LINKS], "generate_links");
+	for (int i = 0; i < List.count(parsed); i++) {
+		document d = List.getAt(parsed, i);
+		symtab st = Symbols.build(d->units);
+		string_builder sb = StringBuilder.new(1 << 20);
+		MDGenerator.generate(sb, d->units, st, NULL);
+		string md = StringBuilder.toString(sb);
+		StringBuilder.free(sb);
+		Symbols.free(st);
+		stages[GENERATE_LINKS].bytes += strlen(md);
+		stages[GENERATE_LINKS].files += List.count(d->units);
+		Mem.free(md);
+	}
+	stage_end(&stages[GENERATE_LINKS]);
+
+	//	the same layout through the template interpreter
+	stage_begin(&stages[GENERATE_TEMPLATE], "generate_template");
+	tmpl layout = Template.compile("builtin", BUILTIN_LAYOUT, sizeof(BUILTIN_LAYOUT) - 1);
+	if (!layout) return 1;
+	for (int i = 0; i < List.count(parsed); i++) {
+		document d = List.getAt(parsed, i);
+		string_builder sb = StringBuilder.new(1 << 20);
+		MDGenerator.generate(sb, d->units, NULL, layout);
+		string md = StringBuilder.toString(sb);
+		StringBuilder.free(sb);
+		if (strcmp(md, List.getAt(outputs, i)) != 0) fprintf(stderr, "generate_template: output differs for '%s'\n", d->name);
+		stages[GENERATE_TEMPLATE].bytes += strlen(md);
+		stages[GENERATE_TEMPLATE].files += List.count(d->units);
+		Mem.free(md);
+	}
+	Template.free(layout);
+	stage_end(&stages[GENERATE_TEMPLATE]);
+
+	//	the other generators, into memory
+	for (int g = GENERATE_JSON; g <= GENERATE_HTML; g++) {
+		const IGenerator* gen = g == GENERATE_JSON ? &JSONGenerator : &HTMLGenerator;
+		stage_begin(&stages[g], g == GENERATE_JSON ? "generate_json" : "generate_html");
+		for (int i = 0; i < List.count(parsed); i++) {
+			document d = List.getAt(parsed, i);
+			string_builder sb = StringBuilder.new(1 << 20);
+			gen->generate(sb, d->units, NULL, NULL);
+			string text = StringBuilder.toString(sb);
+			StringBuilder.free(sb);
+			stages[g].bytes += strlen(text);
+			stages[g].files += List.count(d->units);
+			Mem.free(text);
+		}
+		stage_end(&stages[g]);
+	}
+
+	//	FileWriter.write: fresh files, then again with nothing changed
+	for (int i = 0; i < List.count(parsed); i++) unlink(((document)List.getAt(parsed, i))->output);
+	for (int pass = WRITE; pass <= WRITE_UNCHANGED; pass++) {
+		stage_begin(&stages[pass], pass == WRITE ? "write" : "write_unchanged");
+		for (int i = 0; i < List.count(parsed); i++) {
+			string md = List.getAt(outputs, i);
+			if (FileWriter.write(md, ((document)List.getAt(parsed, i))->output) != 0) return 1;
+			stages[pass].bytes += strlen(md);
+			stages[pass].files++;
+		}
+		stage_end(&stages[pass]);
+	}
+
+	//	render and write markdown alone, then markdown, JSON and HTML on one thread each
+	list md_only = Formats.parse("md");
+	list fanned = Formats.parse("md,json,html");
+	for (int pass = WRITE_MD; pass <= WRITE_FORMATS; pass++) {
+		list formats = pass == WRITE_MD ? md_only : fanned;
+		stage_begin(&stages[pass], pass == WRITE_MD ? "write_md" : "write_formats");
+		for (int i = 0; i < List.count(parsed); i++) {
+			document d = List.getAt(parsed, i);
+			if (Formats.writeAll(formats, d->units, d->output, NULL, NULL, NULL) != 0) return 1;
+			for (int f = 0; f < List.count(formats); f++) {
+				string path = Formats.path(d->output, List.getAt(formats, f));
+				stages[pass].bytes += file_size(path);
+				stages[pass].files++;
+				if (f > 0) unlink(path);
+				Mem.free(path);
+			}
+			unlink(d->output);
+		}
+		stage_end(&stages[pass]);
+	}
+	List.free(md_only);
+	List.free(fanned);
+
+	long workers = config.jobs > 0 ? config.jobs : sysconf(_SC_NPROCESSORS_ONLN);
+	fprintf(out, "{\n  \"corpus\": \"%s\",\n  \"targets\": %d,\n  \"sources\": %d,\n  \"source_bytes\": %zu,\n"
+	             "  \"jobs\": %ld,\n  \"comments\": %ld,\n  \"ir_bytes\": %zu,\n  \"ir_bytes_per_comment\": %.1f,\n"
+	             "  \"stages\": [\n",
+	        corpus, List.count(parsed), List.count(files), stages[PARSE].bytes, workers,
+	        comments, held.used, comments ? (double)held.used / comments : 0.0);
+	for (int i = 0; i < STAGES; i++) print_stage(out, &stages[i], i == STAGES - 1);
+	fprintf(out, "  ]\n}\n");
+	if (json) fclose(out);
+
+	for (int i = 0; i < List.count(outputs); i++) Mem.free(List.getAt(outputs, i));
+	List.free(outputs);
+	Parser.releaseDocuments(parsed);
+	StrMap.free(seen);
+	List.free(files);
+	Parser.releaseDocuments(documents);
+	return 0;
+}
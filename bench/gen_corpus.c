@@ -0,0 +1,231 @@
+/**
+ * @file gen_corpus.c
+ * @brief Deterministic synthetic corpus generator for the doxy benchmarks.
+ * @details Writes N C headers with M Doxygen blocks each, plus a Doxy2MD
+ *			configuration, into a directory. The same arguments always produce
+ *			the same bytes.
+ *			Usage: gen_corpus <dir> [small|large|deep] [-n files] [-m blocks]
+ *			       [-f filler] [-d depth] [-w fanout] [-s seed]
+ *			- small: many small headers in one wildcard directory
+ *			- large: a few ~50k-line files
+ *			- deep:  headers spread over a directory tree, one `dir/` wildcard per leaf
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define MAX_PATH 1024
+
+/* structure representing the corpus shape */
+struct shape_s {
+	int files;			/**< Files per leaf directory */
+	int blocks;			/**< Doxygen blocks per file */
+	int filler;			/**< Code lines between blocks */
+	int depth;			/**< Directory depth (0 = flat) */
+	int fanout;			/**< Subdirectories per directory */
+	uint64_t seed;		/**< Generator seed */
+};
+
+static uint64_t STATE;
+
+static const char* WORDS[] = {
+	"buffer", "index", "parse", "token", "stream", "cache", "target", "source",
+	"render", "symbol", "offset", "length", "block", "entry", "table", "node",
+	"value", "count", "flags", "state", "queue", "worker", "arena", "span",
+};
+static const char* TYPES[] = {
+	"int", "size_t", "const char*", "void*", "list", "string", "unit", "double",
+};
+#define WORD_COUNT (sizeof(WORDS) / sizeof(WORDS[0]))
+#define TYPE_COUNT (sizeof(TYPES) / sizeof(TYPES[0]))
+
+/**
+ * @brief xorshift64* step.
+ */
+static uint64_t next_rand(void) {
+	STATE ^= STATE >> 12;
+	STATE ^= STATE << 25;
+	STATE ^= STATE >> 27;
+	return STATE * 0x2545F4914F6CDD1DULL;
+}
+static int pick(int n) {
+	return (int)(next_rand() % (uint64_t)n);
+}
+static const char* word(void) {
+	return WORDS[pick(WORD_COUNT)];
+}
+
+/**
+ * @brief Writes a sentence of 4-12 words.
+ */
+static void sentence(FILE* f) {
+	int n = 4 + pick(9);
+	for (int i = 0; i < n; i++) fprintf(f, i ? " %s" : "%s", word());
+	fputc('.', f);
+}
+/**
+ * @brief Writes one documented declaration.
+ */
+static void block(FILE* f, int file, int index) {
+	int params = pick(5);
+	int details = pick(4);
+
+	fprintf(f, "/**\n * @brief ");
+	sentence(f);
+	fputc('\n', f);
+	if (details) {
+		fprintf(f, " * @details ");
+		sentence(f);
+		fputc('\n', f);
+		for (int i = 1; i < details; i++) {
+			fprintf(f, " *\t\t\t");
+			sentence(f);
+			fputc('\n', f);
+		}
+	}
+	for (int i = 0; i < params; i++) {
+		fprintf(f, " * @param %s%d ", word(), i);
+		sentence(f);
+		fputc('\n', f);
+	}
+	fprintf(f, " * @return ");
+	sentence(f);
+	fprintf(f, "\n */\n%s %s_%s_%d_%d(", TYPES[pick(TYPE_COUNT)], word(), word(), file, index);
+	for (int i = 0; i < params; i++) {
+		fprintf(f, "%s%s %s%d", i ? ", " : "", TYPES[pick(TYPE_COUNT)], word(), i);
+	}
+	fprintf(f, params ? ");\n" : "void);\n");
+}
+/**
+ * @brief Writes undocumented code lines between blocks.
+ */
+static void filler(FILE* f, int lines) {
+	for (int i = 0; i < lines; i++) {
+		switch (pick(4)) {
+			case 0: fprintf(f, "\t%s = %s + %d; // %s\n", word(), word(), pick(1000), word()); break;
+			case 1: fprintf(f, "\tif (!%s) return %s(%s, %d);\n", word(), word(), word(), pick(64)); break;
+			case 2: fprintf(f, "static %s %s_%s;\n", TYPES[pick(TYPE_COUNT)], word(), word()); break;
+			default: fputc('\n', f); break;
+		}
+	}
+}
+/**
+ * @brief Writes one header file.
+ * @return 0 on success.
+ */
+static int write_file(const char* path, int file, const struct shape_s* shape) {
+	FILE* f = fopen(path, "w");
+	if (!f) {
+		fprintf(stderr, "gen_corpus: cannot write %s\n", path);
+		return 1;
+	}
+	fprintf(f, "/**\n * @file %s\n * @brief ", strrchr(path, '/') + 1);
+	sentence(f);
+	fprintf(f, "\n */\n#ifndef BENCH_%d_H\n#define BENCH_%d_H\n\n", file, file);
+	for (int i = 0; i < shape->blocks; i++) {
+		block(f, file, i);
+		filler(f, shape->filler);
+	}
+	fprintf(f, "\n#endif\n");
+	return fclose(f) != 0;
+}
+/**
+ * @brief Creates a directory (and accepts an existing one).
+ */
+static int make_dir(const char* path) {
+	if (mkdir(path, 0755) != 0 && errno != EEXIST) {
+		fprintf(stderr, "gen_corpus: cannot create %s\n", path);
+		return 1;
+	}
+	return 0;
+}
+/**
+ * @brief Fills a directory tree; leaves get files and a `dir/` wildcard entry.
+ * @param rel Directory relative to the corpus root.
+ * @param level Remaining depth.
+ * @param cfg Config file receiving the wildcard entries.
+ * @param file In/out: running file number.
+ * @return 0 on success.
+ */
+static int fill_tree(const char* rel, int level, const struct shape_s* shape, FILE* cfg, int* file) {
+	char path[MAX_PATH];
+	if (make_dir(rel) != 0) return 1;
+
+	if (level == 0) {
+		for (int i = 0; i < shape->files; i++, (*file)++) {
+			snprintf(path, sizeof(path), "%s/bench_%d.h", rel, *file);
+			if (write_file(path, *file, shape) != 0) return 1;
+		}
+		fprintf(cfg, " \\\n\t%s/*", rel);
+		return 0;
+	}
+
+	for (int i = 0; i < shape->fanout; i++) {
+		snprintf(path, sizeof(path), "%s/d%d", rel, i);
+		if (fill_tree(path, level - 1, shape, cfg, file) != 0) return 1;
+	}
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		fprintf(stderr, "usage: gen_corpus <dir> [small|large|deep] [-n files] [-m blocks] "
+		                "[-f filler] [-d depth] [-w fanout] [-s seed]\n");
+		return 1;
+	}
+
+	const char* dir = argv[1];
+	const char* profile = argc > 2 && argv[2][0] != '-' ? argv[2] : "small";
+	struct shape_s shape = { 500, 20, 4, 0, 1, 42 };
+	if (strcmp(profile, "large") == 0) {
+		shape = (struct shape_s){ 4, 500, 90, 0, 1, 42 };
+	} else if (strcmp(profile, "deep") == 0) {
+		shape = (struct shape_s){ 8, 10, 4, 4, 3, 42 };
+	} else if (strcmp(profile, "small") != 0) {
+		fprintf(stderr, "gen_corpus: unknown profile '%s'\n", profile);
+		return 1;
+	}
+
+	for (int i = 2; i < argc; i++) {
+		if (argv[i][0] != '-' || i + 1 >= argc) continue;
+		long v = strtol(argv[i + 1], NULL, 10);
+		switch (argv[i][1]) {
+			case 'n': shape.files = (int)v; break;
+			case 'm': shape.blocks = (int)v; break;
+			case 'f': shape.filler = (int)v; break;
+			case 'd': shape.depth = (int)v; break;
+			case 'w': shape.fanout = (int)v; break;
+			case 's': shape.seed = (uint64_t)v; break;
+			default: continue;
+		}
+		i++;
+	}
+	STATE = shape.seed ? shape.seed : 42;
+
+	char path[MAX_PATH];
+	if (make_dir(dir) != 0) return 1;
+	snprintf(path, sizeof(path), "%s/Doxy2MD", dir);
+	FILE* cfg = fopen(path, "w");
+	if (!cfg) {
+		fprintf(stderr, "gen_corpus: cannot write %s\n", path);
+		return 1;
+	}
+	fprintf(cfg, "# generated by gen_corpus: %s\ndefault: bench\nbench: outdir=out", profile);
+
+	//	sources are addressed relative to the corpus root, like a real tree
+	if (chdir(dir) != 0) return 1;
+	int file = 0;
+	int ret = fill_tree("src", shape.depth, &shape, cfg, &file);
+	fprintf(cfg, "\n");
+	fclose(cfg);
+	make_dir("out");
+
+	if (ret == 0) printf("%s: %d files (%s)\n", dir, file, profile);
+	return ret;
+}
@@ -0,0 +1,159 @@
+/**
+ * @file scan_bench.c
+ * @brief Micro-benchmark for the comment-block locator.
+ * @details Compares the legacy per-line path (fgets, trim, strncmp, strstr) with
+ *			the Scan prefilter for each available kernel and reports GB/s.
+ *			Usage: scan_bench [<file> ...]; with no files a synthetic buffer is used.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include "scan.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_LINE 1024
+#define SYNTH_SIZE (64u << 20)
+#define ROUNDS 5
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char* trim(char* str) {
+	while (*str == ' ' || *str == '\t') str++;
+	char* end = str + strlen(str) - 1;
+	while (end > str && (*end == ' ' || *end == '\t' || *end == '\n')) end--;
+	*(end + 1) = '\0';
+	return str;
+}
+
+/**
+ * @brief Builds a C-like buffer with one doc block every ~100 lines.
+ */
+static char* synthesize(size_t size) {
+	static const char* code[] = {
+		"\tfor (int i = 0; i < count; i++) total += items[i] * 2; // accumulate\n",
+		"\tif (!ptr) { fprintf(stderr, \"failed: %s\\n\", name); return -1; }\n",
+		"static int helper_function(const char* name, size_t len, int flags);\n",
+		"\n",
+	};
+	static const char* block =
+		"/**\n * @brief Does a thing.\n * @param x Input.\n * @return Result.\n */\n"
+		"int thing(int x);\n";
+	char* buf = malloc(size + 1);
+	size_t len = 0, n = 0;
+	while (len < size) {
+		const char* line = (++n % 100 == 0) ? block : code[n % 4];
+		size_t l = strlen(line);
+		if (len + l > size) break;
+		memcpy(buf + len, line, l);
+		len += l;
+	}
+	memset(buf + len, '\n', size - len);
+	buf[size] = '\0';
+	return buf;
+}
+
+/**
+ * @brief The per-line path process_file() used before the prefilter.
+ */
+static long per_line(char* buf, size_t size) {
+	FILE* in = fmemopen(buf, size, "r");
+	char line[MAX_LINE];
+	long blocks = 0;
+	int in_comment = 0;
+	while (fgets(line, MAX_LINE, in)) {
+		char* trimmed = trim(line);
+		if (strncmp(trimmed, "/**", 3) == 0) { in_comment = 1; ++blocks; continue; }
+		if (in_comment && strstr(trimmed, "*/")) in_comment = 0;
+	}
+	fclose(in);
+	return blocks;
+}
+
+/**
+ * @brief Visits every opener and its closer through the Scan prefilter.
+ */
+static long prefilter(char* buf, size_t size) {
+	const char* p = buf;
+	const char* end = buf + size;
+	long blocks = 0;
+	while ((p = Scan.findOpen(p, end)) < end) {
+		++blocks;
+		p = Scan.findClose(p + 3, end);
+	}
+	return blocks;
+}
+
+/**
+ * @brief Visits every live block through the lexer, then skips to its closer.
+ */
+static long lexer(char* buf, size_t size) {
+	const char* p = buf;
+	const char* end = buf + size;
+	scan_state st = { .base = buf };
+	long blocks = 0;
+	while ((p = Scan.nextBlock(p, end, &st)) < end) {
+		++blocks;
+		p = Scan.findClose(p + 3, end);
+		p = p < end ? p + 2 : end;
+	}
+	return blocks;
+}
+
+static void report(const char* name, long (*fn)(char*, size_t), char* buf, size_t size) {
+	double best = 1e9;
+	long blocks = 0;
+	for (int r = 0; r < ROUNDS; r++) {
+		double t = now();
+		blocks = fn(buf, size);
+		t = now() - t;
+		if (t < best) best = t;
+	}
+	printf("%-10s %8.2f GB/s  %8.3f ms  blocks=%ld\n", name, size / best / 1e9, best * 1e3, blocks);
+}
+
+static void run(const char* label, char* buf, size_t size) {
+	printf("== %s (%zu bytes)\n", label, size);
+	report("per-line", per_line, buf, size);
+	SCANISA isas[] = { SCAN_SCALAR, SCAN_SSE2, SCAN_AVX2 };
+	for (int i = 0; i < 3; i++) {
+		if (Scan.select(isas[i]) != isas[i]) continue;
+		char name[16];
+		report(Scan.name(isas[i]), prefilter, buf, size);
+		snprintf(name, sizeof(name), "%s-lex", Scan.name(isas[i]));
+		report(name, lexer, buf, size);
+	}
+	Scan.select(SCAN_AUTO);
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		char* buf = synthesize(SYNTH_SIZE);
+		run("synthetic", buf, SYNTH_SIZE);
+		free(buf);
+		return 0;
+	}
+
+	for (int i = 1; i < argc; i++) {
+		FILE* f = fopen(argv[i], "rb");
+		if (!f) {
+			fprintf(stderr, "Failed to open '%s'\n", argv[i]);
+			continue;
+		}
+		fseek(f, 0, SEEK_END);
+		size_t size = ftell(f);
+		rewind(f);
+		char* buf = malloc(size + 1);
+		size = fread(buf, 1, size, f);
+		buf[size] = '\0';
+		fclose(f);
+		run(argv[i], buf, size);
+		free(buf);
+	}
+	return 0;
+}
@@ -0,0 +1,37 @@
+// arena.h
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <sigcore.h>
+#include <stddef.h>
+
+typedef struct arena_s* arena;
+
+/**
+ * @brief Process-wide arena counters.
+ */
+typedef struct arena_stats {
+	long arenas;		/**< Arenas created */
+	long blocks;		/**< Blocks requested from Mem */
+	long allocs;		/**< Allocations served from blocks */
+	size_t reserved;	/**< Bytes currently held in blocks */
+	size_t used;		/**< Bytes currently handed out, alignment included */
+	size_t peak;		/**< High-water mark of reserved */
+} arena_stats;
+
+/**
+ * @brief Interface for bump arenas.
+ * @details An arena hands out memory from large blocks and releases everything
+ *			it handed out in a single call. Arenas are not shared between threads;
+ *			the counters are.
+ */
+typedef struct IArena {
+	arena (*new)(size_t);							/**< Creates an arena with the given block size. */
+	object (*alloc)(arena, size_t);					/**< Returns zeroed memory owned by the arena. */
+	void (*free)(arena);							/**< Releases the arena and all of its blocks. */
+	arena_stats (*stats)(void);						/**< Returns a snapshot of the process-wide counters. */
+} IArena;
+
+extern const IArena Arena;
+
+#endif // ARENA_H
@@ -0,0 +1,50 @@
+// cache.h
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <sigcore.h>
+#include "parser.h"
+
+/**
+ * @brief Process-wide cache counters.
+ */
+typedef struct cache_stats {
+	long hits;			/**< Entries reused (including rehashed) */
+	long rehashed;		/**< Hits confirmed by content hash after an mtime change */
+	long misses;		/**< Sources that had to be parsed */
+	long stored;		/**< Entries written */
+} cache_stats;
+
+/**
+ * @brief Interface for the on-disk parse cache.
+ * @details One entry per source file holds its comment records and the text
+ *			they reference. Entries are keyed by path and validated by size and
+ *			mtime, with a content hash to confirm files whose mtime changed.
+ */
+typedef struct ICache {
+	/**
+	 * @brief Loads the cached unit of a source if its entry is current.
+	 * @param dir Cache directory.
+	 * @param path Source path.
+	 * @param stamp Current stamp of the source.
+	 * @param out Output: cached unit, or NULL if the source has no comments.
+	 * @return 1 on a hit, 0 on a miss.
+	 */
+	int (*load)(const string, const string, const source_stamp*, unit*);
+	/**
+	 * @brief Stores the parse results of a source.
+	 * @param dir Cache directory (created if missing).
+	 * @param stamp Stamp of the source when it was parsed.
+	 * @param s Parsed source (hashed for the entry).
+	 * @param u Parse results, or NULL if the source has no comments.
+	 */
+	void (*store)(const string, const source_stamp*, source, unit);
+	/**
+	 * @brief Returns a snapshot of the process-wide counters.
+	 */
+	cache_stats (*stats)(void);
+} ICache;
+
+extern const ICache Cache;
+
+#endif // CACHE_H
@@ -0,0 +1,75 @@
+// decl.h
+#ifndef DECL_H
+#define DECL_H
+
+#include <stddef.h>
+
+/** @brief Most parameters kept for one declaration; later ones are dropped. */
+#define DECL_MAX_PARAMS 64
+
+/**
+ * @brief Kind of the declaration that follows a comment block.
+ */
+typedef enum decl_kind {
+	DECL_NONE,			/**< Nothing recognized */
+	DECL_FUNCTION,		/**< Function definition (ends at its body) */
+	DECL_PROTOTYPE,		/**< Function declaration ending in ';' */
+	DECL_STRUCT,		/**< struct, union or enum */
+	DECL_TYPEDEF,		/**< typedef, including function-pointer types */
+	DECL_FNPTR,			/**< Function-pointer member or variable */
+	DECL_MACRO,			/**< #define */
+	DECL_VARIABLE		/**< Variable, member or enumerator */
+} decl_kind;
+
+/**
+ * @brief A piece of declaration text: a pointer into the lexed buffer.
+ */
+typedef struct decl_view {
+	const char* p;		/**< First byte */
+	size_t len;			/**< Length in bytes */
+} decl_view;
+
+/**
+ * @brief Result of lexing one declaration; all views point into the buffer.
+ */
+typedef struct decl_s {
+	decl_kind kind;		/**< What was declared */
+	decl_view text;		/**< Declaration up to its terminator, possibly several lines */
+	decl_view name;		/**< Declared name (typedef name, member, macro, ...) */
+	decl_view type;		/**< Return type, or the type of a variable */
+	int params;			/**< Number of parameters kept; (void) has none */
+	decl_view param[DECL_MAX_PARAMS];	/**< Parameters as written */
+} decl;
+
+/**
+ * @brief Interface for lexing the C declaration after a comment block.
+ * @details One forward pass over tokens up to the terminating `{`, `;`, `=`
+ *			or `,`, across lines. Comments and literals are skipped,
+ *			`__attribute__((...))` and similar annotations are ignored, macro
+ *			prefixes such as `API int f(void)` or `DEPRECATED("x") int f(void)`
+ *			end up in the type, and K&R parameter declarations are read up to
+ *			the body. Lexing stops early at a blank line, a preprocessor line or
+ *			the next comment block.
+ */
+typedef struct IDecl {
+	/**
+	 * @brief Lexes the declaration starting at a position.
+	 * @param p Start of the text after a comment block (leading blank lines are skipped).
+	 * @param end End of the buffer.
+	 * @param d Output declaration; kind is DECL_NONE if nothing was found.
+	 * @return Start of the line after the declaration's terminator, where
+	 *			scanning for comment blocks resumes; a preprocessor line other
+	 *			than #define is not consumed.
+	 */
+	const char* (*lex)(const char*, const char*, decl*);
+	/**
+	 * @brief Names a declaration kind (e.g. "prototype").
+	 * @param kind Kind to name.
+	 * @return Static name string.
+	 */
+	const char* (*name)(decl_kind);
+} IDecl;
+
+extern const IDecl Decl;
+
+#endif // DECL_H
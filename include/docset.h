@@ -0,0 +1,81 @@
+// docset.h
+#ifndef DOCSET_H
+#define DOCSET_H
+
+#include <sigcore.h>
+#include "parser.h"
+
+/* structure representing a source of the resident targets */
+struct docset_source_s {
+	string path;		/**< Source path as written in the targets (held by a document of the set) */
+	unit u;				/**< Parsed unit (one reference), or NULL without comments */
+	string text;		/**< Rendered markdown of the unit, or NULL */
+	size_t length;		/**< Length of text */
+	list documents;		/**< Documents that include the source */
+};
+typedef struct docset_source_s* docset_source;
+
+/** @brief Resident targets (see IDocSet). */
+typedef struct docset_s* docset;
+
+/**
+ * @brief Interface for targets kept in memory between regenerations.
+ * @details Each source is parsed once and rendered once to markdown, however
+ *			many targets include it; a document is written by concatenating the
+ *			text of its sources, so regenerating it costs no parsing. Replacing
+ *			one source re-parses and re-renders only that source. Used by
+ *			`--watch` and `--serve`; markdown only, without links.
+ *			A set is not locked: callers serialize refresh against other calls.
+ */
+typedef struct IDocSet {
+	/**
+	 * @brief Parses the targets and renders every source.
+	 * @param config Configuration (file, workers, cache, template, debug).
+	 * @param names Target names, or NULL for every target except `default`.
+	 * @return Set, or NULL if the targets cannot be built.
+	 */
+	docset (*load)(doxy_config*, list);
+	/**
+	 * @brief Releases a set, its documents and units.
+	 * @param set Set, or NULL.
+	 */
+	void (*free)(docset);
+	/**
+	 * @brief Returns the documents, in the order requested.
+	 */
+	list (*documents)(docset);
+	/**
+	 * @brief Returns the sources (docset_source), each once.
+	 */
+	list (*sources)(docset);
+	/**
+	 * @brief Finds a document by target name.
+	 * @return Document, or NULL if the set does not hold the target.
+	 */
+	document (*target)(docset, const char*);
+	/**
+	 * @brief Finds a source by path, as written in the targets.
+	 * @return Source, or NULL if no target includes the path.
+	 */
+	docset_source (*find)(docset, const char*);
+	/**
+	 * @brief Re-parses a source and renders it again.
+	 * @param set Set.
+	 * @param ds Source of the set.
+	 * @return 0 on success; non-zero if parsing failed (the old unit is kept).
+	 */
+	int (*refresh)(docset, docset_source);
+	/**
+	 * @brief Writes documents from the rendered text of their sources; split
+	 *			documents are written as pages.
+	 * @param set Set.
+	 * @param documents Documents of the set to write.
+	 * @param failed Output, may be NULL: per document, non-zero if writing failed.
+	 * @return 0 on success, non-zero if any document failed.
+	 */
+	int (*write)(docset, list, int*);
+} IDocSet;
+
+extern const IDocSet DocSet;
+
+#endif // DOCSET_H
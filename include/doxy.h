@@ -0,0 +1,108 @@
+// doxy.h
+#ifndef DOXY_H
+#define DOXY_H
+
+#include <sigcore.h>
+#include "parser.h"
+#include "sink.h"
+#include "formats.h"
+
+/** @brief Version of doxy2md and its library. */
+#define DOXY2MD_VERSION "1.0"
+
+/** @brief Library context (see IDoxy). */
+typedef struct doxy_ctx_s* doxy_ctx;
+
+/**
+ * @brief Interface for libdoxy2md: parsing targets and rendering documents
+ *			through an explicit context.
+ * @details A context holds its own copy of a configuration and the compiled
+ *			template, and nothing else; it is not modified once created, so any
+ *			number of threads may call parse, stream, render and write on one
+ *			context, or on a context each, at the same time. The library keeps
+ *			no per-run global state: only the diagnostic counters
+ *			(FileWriter.stats, Cache.stats, Arena.stats) and the profiler
+ *			(stats.h) are process-wide. Results are returned and errors
+ *			written to stderr; only debug output goes to stdout.
+ *
+ *			Ownership: Doxy.new copies everything it keeps, so the caller's
+ *			configuration may be released right after. Lists of documents
+ *			belong to the caller and are released with Doxy.release, which may
+ *			happen after the context is freed. Sinks belong to the caller, who
+ *			closes them. A document is read by render and write; it must not be
+ *			released while another thread uses it.
+ */
+typedef struct IDoxy {
+	/**
+	 * @brief Creates a context.
+	 * @param config Configuration to copy; its layout is ignored and the
+	 *			template, if any, is compiled for the context.
+	 * @return Context, or NULL if the template cannot be loaded.
+	 */
+	doxy_ctx (*new)(const doxy_config*);
+	/**
+	 * @brief Frees a context.
+	 * @param ctx Context, or NULL.
+	 */
+	void (*free)(doxy_ctx);
+	/**
+	 * @brief Returns the context's configuration (read only).
+	 */
+	doxy_config* (*config)(doxy_ctx);
+	/**
+	 * @brief Resolves targets into documents without parsing their sources.
+	 * @param ctx Context.
+	 * @param names Target names, or NULL for every target except `default`.
+	 * @return List of documents with no units, empty if the configuration
+	 *			has no targets, or NULL on failure.
+	 */
+	list (*resolve)(doxy_ctx, list);
+	/**
+	 * @brief Parses targets, each unique source once; documents share units.
+	 * @param ctx Context.
+	 * @param names Target names, or NULL for every target except `default`.
+	 * @return List of documents in the order requested, empty if the
+	 *			configuration has no targets, or NULL on failure.
+	 */
+	list (*parse)(doxy_ctx, list);
+	/**
+	 * @brief Parses a resolved document's sources, handing each unit with
+	 *			comments to a callback in source order.
+	 * @param ctx Context.
+	 * @param d Document from resolve.
+	 * @param emit Callback receiving each unit; it takes a reference to keep one.
+	 * @param arg Callback context.
+	 * @return 0 on success, non-zero on failure.
+	 */
+	int (*stream)(doxy_ctx, document, unit_fn, object);
+	/**
+	 * @brief Renders a parsed document into a sink, header and footer included.
+	 * @details A split document is rendered as one document.
+	 * @param ctx Context.
+	 * @param d Document with units.
+	 * @param f Format, or NULL for markdown.
+	 * @param out Empty sink (e.g. Sink.toCallback); left open.
+	 * @return 0 on success, non-zero on failure.
+	 */
+	int (*render)(doxy_ctx, document, const output_format*, sink);
+	/**
+	 * @brief Writes a parsed document's files: one per configured format, or
+	 *			the pages and index of a split document. Unchanged files are not
+	 *			rewritten.
+	 * @param ctx Context.
+	 * @param d Document with units.
+	 * @param failed Output, may be NULL: per format (one entry for a split
+	 *			document), non-zero if writing failed.
+	 * @return 0 if every file was written, non-zero otherwise.
+	 */
+	int (*write)(doxy_ctx, document, int*);
+	/**
+	 * @brief Releases documents and their shared units.
+	 * @param documents List of documents, or NULL; freed as well.
+	 */
+	void (*release)(list);
+} IDoxy;
+
+extern const IDoxy Doxy;
+
+#endif // DOXY_H
@@ -0,0 +1,58 @@
+// formats.h
+#ifndef FORMATS_H
+#define FORMATS_H
+
+#include <sigcore.h>
+#include "md_generator.h"
+
+/** @brief Number of output formats known. */
+#define FORMATS_MAX 3
+
+/**
+ * @brief An output format: a generator and the extension of its files.
+ */
+typedef struct output_format_s {
+	const char* name;			/**< Name on the command line ("md", "json", "html") */
+	const char* label;			/**< Name in messages ("markdown", ...) */
+	const char* ext;			/**< File extension, with the dot */
+	const IGenerator* gen;		/**< Generator writing the format */
+} output_format;
+
+/**
+ * @brief Interface for choosing output formats and writing a document in
+ *			several of them at once.
+ */
+typedef struct IFormats {
+	/**
+	 * @brief Parses a comma-separated format list (e.g. "md,json").
+	 * @param spec Format names; repeats are dropped.
+	 * @return List of const output_format* (free with List.free), or NULL
+	 *			after printing an error for an unknown name.
+	 */
+	list (*parse)(const string);
+	/**
+	 * @brief Builds the output path of a format: markdown keeps the document's
+	 *			path, other formats replace a `.md` extension or append theirs.
+	 * @param output Document output path.
+	 * @param f Format, or NULL for markdown.
+	 * @return Allocated path (caller frees).
+	 */
+	string (*path)(const string, const output_format*);
+	/**
+	 * @brief Writes a document in every format, each on its own thread.
+	 * @details All formats render the same parsed units and symbol index, which
+	 *			are only read; the template is passed to markdown only.
+	 * @param formats List of formats, or NULL for markdown only.
+	 * @param units Units in source order.
+	 * @param output Document output path.
+	 * @param st Symbol index, or NULL.
+	 * @param t Compiled template, or NULL.
+	 * @param failed Output, may be NULL: per format, non-zero if writing failed.
+	 * @return 0 if every format was written, non-zero otherwise.
+	 */
+	int (*writeAll)(list, list, const string, symtab, tmpl, int*);
+} IFormats;
+
+extern const IFormats Formats;
+
+#endif // FORMATS_H
@@ -0,0 +1,16 @@
+// html_generator.h
+#ifndef HTML_GENERATOR_H
+#define HTML_GENERATOR_H
+
+#include "md_generator.h"
+
+/**
+ * @brief Generator writing a document as a standalone HTML page.
+ * @details One `<section>` per comment with the brief, details, parameters,
+ *			return value, see-also lines and signature; with a symbol index each
+ *			section carries its name as id, names in text are linked and a
+ *			referenced-by line is added. Templates do not apply.
+ */
+extern const IGenerator HTMLGenerator;
+
+#endif // HTML_GENERATOR_H
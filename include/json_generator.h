@@ -0,0 +1,16 @@
+// json_generator.h
+#ifndef JSON_GENERATOR_H
+#define JSON_GENERATOR_H
+
+#include "md_generator.h"
+
+/**
+ * @brief Generator writing a document as one JSON object.
+ * @details `{"comments": [...], "title": ...}`: one object per comment with
+ *			its file, declaration (kind, name, type, signature, parameters),
+ *			sections in source order and, with a symbol index, the names
+ *			referencing it. Templates do not apply.
+ */
+extern const IGenerator JSONGenerator;
+
+#endif // JSON_GENERATOR_H
@@ -0,0 +1,61 @@
+// lines.h
+#ifndef LINES_H
+#define LINES_H
+
+#include <sigcore.h>
+#include "source.h"
+
+/** @brief Initial size of a streaming reader's block; grows only for longer lines. */
+#define LINE_BLOCK 65536
+
+/** @brief Line reader (see ILines). */
+typedef struct line_reader_s* line_reader;
+
+/**
+ * @brief Interface for reading lines of any length.
+ * @details Lines are handed out as views, without a copy per line. A regular
+ *			file is mapped and walked in place; anything else (pipes, process
+ *			substitution, procfs) is read into one reusable block. A line that
+ *			straddles the end of the block is moved to its front, and the block
+ *			only grows when a single line is longer than it.
+ */
+typedef struct ILines {
+	/**
+	 * @brief Opens a file for reading lines.
+	 * @param path File to read.
+	 * @return Reader, or NULL if the file cannot be opened.
+	 */
+	line_reader (*open)(const string);
+	/**
+	 * @brief Reads the lines of a mapped source.
+	 * @param s Source; the reader takes a reference.
+	 * @return Reader, or NULL on failure.
+	 */
+	line_reader (*fromSource)(source);
+	/**
+	 * @brief Returns the next line, without its '\\n'.
+	 * @param r Reader.
+	 * @param len Output: length of the line.
+	 * @return Start of the line, valid until the next call; NULL at the end or
+	 *			on a read error.
+	 */
+	const char* (*next)(line_reader, size_t*);
+	/**
+	 * @brief Returns the number of the last line handed out (1-based).
+	 */
+	long (*number)(line_reader);
+	/**
+	 * @brief Tests whether reading stopped on an error.
+	 * @return Non-zero after a read or allocation failure.
+	 */
+	int (*error)(line_reader);
+	/**
+	 * @brief Closes a reader.
+	 * @param r Reader, or NULL.
+	 */
+	void (*close)(line_reader);
+} ILines;
+
+extern const ILines Lines;
+
+#endif // LINES_H
@@ -4,9 +4,54 @@
 
 #include <sigcore.h>
 #include "parser.h"
+#include "sink.h"
+#include "template.h"
 
+/**
+ * @brief Interface for documentation generators.
+ */
 typedef struct IGenerator {
-    void (*generate)(string_builder, list, const string);
+    /**
+     * @brief Renders a whole document into a StringBuilder, header and footer included.
+     * @param sb StringBuilder to append to.
+     * @param units Units in source order.
+     * @param st Symbol index for anchors and links (see symbols.h), or NULL.
+     * @param t Compiled template, or NULL for the built-in layout.
+     */
+    void (*generate)(string_builder, list, symtab, tmpl);
+    /**
+     * @brief Renders the comments of one source unit; used to stream a document.
+     * @param out Sink to write to.
+     * @param u Unit to render.
+     * @param st Symbol index of the whole document, or NULL.
+     * @param t Compiled template, or NULL for the built-in layout.
+     */
+    void (*render)(sink, unit, symtab, tmpl);
+    /**
+     * @brief Renders a document straight to a file, header and footer included;
+     *          unchanged files are not rewritten.
+     * @param units Units in source order.
+     * @param path Output file path.
+     * @param st Symbol index for anchors and links, or NULL.
+     * @param t Compiled template, or NULL for the built-in layout.
+     * @return 0 on success, non-zero on failure.
+     */
+    int (*writeFile)(list, const string, symtab, tmpl);
+    /**
+     * @brief Writes the start of a document: the template's header, if any.
+     * @param out Sink to write to.
+     * @param path Output path; `{{title}}` is its file name without the
+     *          extension. NULL gives an empty title.
+     * @param t Compiled template, or NULL.
+     */
+    void (*begin)(sink, const string, tmpl);
+    /**
+     * @brief Writes the end of a document: the template's footer, if any.
+     * @param out Sink to write to.
+     * @param path Output path, or NULL.
+     * @param t Compiled template, or NULL.
+     */
+    void (*end)(sink, const string, tmpl);
 } IGenerator;
 
 extern const IGenerator MDGenerator;
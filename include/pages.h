@@ -0,0 +1,43 @@
+// pages.h
+#ifndef PAGES_H
+#define PAGES_H
+
+#include <sigcore.h>
+#include "md_generator.h"
+
+/**
+ * @brief Interface for split documents (`outmode=split`): one markdown page per
+ *			source plus an index page linking to them.
+ * @details Pages go to a directory named after the index without its `.md`
+ *			(`docs/api.md` -> `docs/api/`), where the source tree is mirrored
+ *			(`src/parser.c` -> `docs/api/src/parser.c.md`); `%`, `..` and a
+ *			leading `/` are escaped, so distinct sources never share a page.
+ *			Every page is written through the sink, so a page whose source did
+ *			not change is left untouched. The directory's `.pages` manifest
+ *			lists the pages written; pages of sources that left the document
+ *			are removed on the next write.
+ */
+typedef struct IPages {
+	/**
+	 * @brief Builds the page path of a source.
+	 * @param output Index path.
+	 * @param source Source path.
+	 * @return Allocated path (caller frees).
+	 */
+	string (*path)(const string, const string);
+	/**
+	 * @brief Writes one page per unit on a pool of workers, then the index, and
+	 *			removes the pages of the previous write that were not rewritten.
+	 * @param units Units in source order; sources without comments get no page.
+	 * @param output Index path.
+	 * @param t Compiled template for the pages, or NULL for the built-in layout.
+	 * @param jobs Workers; 0 for the number of online CPUs.
+	 * @param pages Output, may be NULL: number of pages written.
+	 * @return 0 if every page and the index were written, non-zero otherwise.
+	 */
+	int (*write)(list, const string, tmpl, int, int*);
+} IPages;
+
+extern const IPages Pages;
+
+#endif // PAGES_H
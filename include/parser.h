@@ -5,48 +5,202 @@
 #include <sigcore.h>
 #include <stdio.h>
 #include <string.h>
+#include "source.h"
+#include "arena.h"
+#include "decl.h"
 
-#define MAX_LINE 1024
 #define MAX_TARGET 256
 
+/** @brief Compiled output template (see template.h). */
+typedef struct tmpl_s* tmpl;
+
 /**
  * @brief Configuration for doxy execution.
+ * @details Read-only to the parser and generators, so one configuration may
+ *			serve calls on several threads.
  */
 typedef struct doxy_config {
 	string file;		/**< Doxy2MD config file (e.g., "Doxy2MD") */
-	string output;		/**< Output override (e.g., "custom.md") */
+	string output;		/**< Output override: documents are written to [outdir/]output (e.g., "custom.md") */
 	string target;		/**< Target to process (e.g., "default") */
 	int is_debug;		/**< Set a debug flag */
-	string template;	/**< Markdown formatting template */
+	string template;	/**< Output template file (--template), or NULL for the built-in layout */
 	list sources;		/**< Source files for comment extraction */
+	int jobs;			/**< Parse workers; 0 for the number of online CPUs */
+	string cache_dir;	/**< Parse cache directory; NULL to disable the cache */
+	int cache_stats;	/**< Print cache hit/miss counts after the run (the command, not the library) */
+	int links;			/**< Index symbols and link references between them */
+	tmpl layout;		/**< Compiled template, or NULL */
+	list formats;		/**< Output formats (const output_format*, see formats.h), or NULL for markdown */
 } doxy_config;
 
+/**
+ * @brief Doxygen section commands recognized in a comment block.
+ * @details Commands are written `@name` or `\\name`; inline commands (`@c`,
+ *			`@ref`, ...) and unknown ones are plain text.
+ */
+typedef enum tag_kind {
+	TAG_NONE,			/**< Not a section command */
+	TAG_BRIEF,			/**< @brief, @short */
+	TAG_DETAILS,		/**< @details, @detail */
+	TAG_PARAM,			/**< @param[in,out] name text */
+	TAG_TPARAM,			/**< @tparam name text */
+	TAG_RETURN,			/**< @return, @returns, @result */
+	TAG_RETVAL,			/**< @retval value text */
+	TAG_THROWS,			/**< @throws, @throw, @exception */
+	TAG_NOTE,			/**< @note, @remark, @remarks */
+	TAG_WARNING,		/**< @warning, @attention */
+	TAG_SEE,			/**< @see, @sa */
+	TAG_AUTHOR,			/**< @author, @authors */
+	TAG_SINCE,			/**< @since */
+	TAG_VERSION,		/**< @version */
+	TAG_DEPRECATED,		/**< @deprecated */
+	TAG_TODO,			/**< @todo, @bug */
+	TAG_PRE,			/**< @pre */
+	TAG_POST,			/**< @post */
+	TAG_FILE			/**< @file (marks a file comment; not kept as a tag) */
+} tag_kind;
+
+/** @brief Direction bits of `@param[in]`, `@param[out]` and `@param[in,out]`. */
+#define PARAM_IN 1
+#define PARAM_OUT 2
+
+/**
+ * @brief One section of a comment: a tag line and its continuation lines.
+ */
+typedef struct tag_s {
+	tag_kind kind;		/**< Section kind */
+	int dir;			/**< PARAM_IN/PARAM_OUT bits; 0 when not given */
+	span name;			/**< Command as written (e.g. "returns") */
+	span arg;			/**< First word for param, tparam, retval and throws; not part of the text */
+	int first;			/**< Index of the first text line in the comment's lines */
+	int count;			/**< Number of text lines */
+} tag;
+
+/**
+ * @brief Array of tags; a comment's tags are a view into its unit's tag pool.
+ */
+typedef struct tag_list_s {
+	tag* items;			/**< Tag storage */
+	int count;			/**< Number of tags in use */
+	int capacity;		/**< Allocated tag slots */
+} tag_list;
+
 /**
  * @brief Structure representing the full comment
+ * @details Text fields are views into the mapped source; bytes are copied only
+ *			when a generator emits them. Every tagged section owns a run of
+ *			lines; empty lines are not kept. The lines, tags and params arrays
+ *			are views into pools shared by every comment of the unit.
  */
 struct comment_s {
-	string brief;		/**< Short description */
-	string_builder details;	/**< Detailed description */
-	list params;		/**< List of param descriptions */
-	string ret;			/**< Return value description */
-	string signature;	/**< Function signature */
-	string func_name; /**< Function name */
-	string ret_type;	/**< Return type */
+	source src;			/**< Source the spans below view into */
+	span_list lines;	/**< Text lines of all tags, in source order */
+	tag_list tags;		/**< Sections in source order */
+	span signature;		/**< Declaration after the block, up to its terminator */
+	span func_name;		/**< Declared name */
+	span ret_type;		/**< Return type, or the type of a variable */
+	decl_kind kind;		/**< What the declaration declares */
+	span_list params;	/**< Parameters of a function, function pointer or macro */
 	int is_file;		/**< Flag for file-level comments */
-	string filename;	/**< Source file name for @file metadata */
 };
 typedef struct comment_s* comment;
 
+/**
+ * @brief Parse results of one source file.
+ * @details Flat: one array of comments and one pool each of lines, tags and
+ *			parameters, all sized exactly in the unit's arena and laid out in
+ *			source order. A unit is released as a whole, never comment by comment.
+ */
+struct unit_s {
+	source src;			/**< Mapped source the comment spans view into */
+	arena mem;			/**< Owns the unit, its comments and their pools */
+	struct comment_s* comments;	/**< Comments in source order */
+	int count;			/**< Number of comments */
+	int refs;			/**< References held (parse results, documents) */
+};
+typedef struct unit_s* unit;
+
+/** @brief Symbol index of a document (see symbols.h). */
+typedef struct symtab_s* symtab;
+
+/**
+ * @brief A resolved target ready for rendering.
+ */
+struct document_s {
+	string name;		/**< Target name */
+	string output;		/**< Output path ([outdir/]name.md) */
+	list units;			/**< Units of the target's sources, in source order; shared */
+	list sources;		/**< Source paths of the target, in order (owned) */
+	symtab symbols;		/**< Symbol index when config links is set, else NULL */
+	int split;			/**< outmode=split: one page per source plus an index */
+};
+typedef struct document_s* document;
+
+/**
+ * @brief Receives a parsed unit; the unit is released after the call unless retained.
+ * @return 0 to continue, non-zero to stop parsing.
+ */
+typedef int (*unit_fn)(unit, object);
+
 /**
  * @brief Interface for parsing Doxy2MD files.
  */
 typedef struct IParser {
 	/**
-	 * @brief Parses a Doxy2MD file and processes its targets.
-	 * @param config Configuration for parsing and output.
-	 * @return 0 on SUCCESS; otherwise non-0.
+	 * @brief Parses the configured target of a Doxy2MD file (config->target,
+	 *			or config->sources when given).
+	 * @param config Configuration for parsing.
+	 * @return List of units in source order, or NULL on failure.
 	 */
 	list (*parseDoxy)(doxy_config*);
+	/**
+	 * @brief Parses a document's sources, handing each unit with comments to a
+	 *			callback in source order.
+	 * @param config Configuration for parsing.
+	 * @param d Document from resolveTargets (its units are not touched).
+	 * @param emit Callback receiving each unit.
+	 * @param ctx Callback context.
+	 * @return 0 on success, non-zero on failure.
+	 */
+	int (*streamDocument)(doxy_config*, document, unit_fn, object);
+	/**
+	 * @brief Parses a single source file, using the parse cache.
+	 * @param config Configuration (debug flag, cache).
+	 * @param path Source file to parse.
+	 * @param out Output: unit with one reference, or NULL if the file has no comments.
+	 * @return 0 on success, non-zero on failure.
+	 */
+	int (*parseFile)(doxy_config*, const string, unit*);
+	/**
+	 * @brief Parses several targets, parsing each unique source exactly once.
+	 * @param config Configuration for parsing.
+	 * @param names Target names, or NULL for every target except `default`.
+	 * @return List of documents in the order requested, empty if the
+	 *			configuration has no targets, or NULL on failure (including
+	 *			when none of the named targets exists).
+	 */
+	list (*parseTargets)(doxy_config*, list);
+	/**
+	 * @brief Resolves targets into documents without parsing their sources.
+	 * @details config->sources, when given, form one document named after
+	 *			config->target; config->output replaces each document's file name.
+	 * @param config Configuration (file, output, sources).
+	 * @param names Target names, or NULL for every target except `default`.
+	 * @return List of documents with no units (release with releaseDocuments),
+	 *			empty if the configuration has no targets, or NULL on failure.
+	 */
+	list (*resolveTargets)(doxy_config*, list);
+	/**
+	 * @brief Releases the units returned by parseDoxy in one call.
+	 * @param units List of units; freed as well.
+	 */
+	void (*release)(list);
+	/**
+	 * @brief Releases the documents returned by parseTargets and their shared units.
+	 * @param documents List of documents; freed as well.
+	 */
+	void (*releaseDocuments)(list);
 } IParser;
 
 extern const IParser Parser;
@@ -58,9 +212,15 @@ extern const IParser Parser;
  */
 string trim(string str);
 /**
- * @brief Frees a Comment and its resources.
- * @param c Comment to free.
+ * @brief Creates an empty unit for a source.
+ * @param s Source the unit's spans view into; the unit takes a reference.
+ * @return Unit with its own arena, or NULL on failure.
+ */
+unit new_unit(source s);
+/**
+ * @brief Drops a reference to a unit; releases it when none remain.
+ * @param u Unit to release.
  */
-void free_comment(comment);
+void free_unit(unit u);
 
 #endif // PARSER_H
@@ -0,0 +1,92 @@
+// scan.h
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <stddef.h>
+
+/**
+ * @brief Instruction set used by the block locator.
+ */
+typedef enum scan_isa {
+	SCAN_AUTO,		/**< Best available, chosen by CPUID */
+	SCAN_SCALAR,	/**< Portable memchr-based fallback */
+	SCAN_SSE2,		/**< 16-byte vectors */
+	SCAN_AVX2		/**< 32-byte vectors */
+} SCANISA;
+
+/** @brief Conditional groups whose `#else` is tracked; deeper ones are treated as live. */
+#define SCAN_DEPTH 64
+
+/**
+ * @brief Lexer state carried from one block search to the next in a buffer.
+ * @details Literals and comments never outlive a search, so only the
+ *			preprocessor conditionals are kept. Initialize with the buffer start
+ *			and everything else zero: `scan_state st = { .base = data };`
+ */
+typedef struct scan_state {
+	const char* base;	/**< Start of the buffer; bounds the look-behind for line starts */
+	int level;			/**< Conditional groups open in live code */
+	unsigned long long taken;	/**< Bit per level: a constant-true branch was live (`#if 1`) */
+	int off;			/**< Nesting depth inside a disabled group; 0 in live code */
+	int dead;			/**< The disabled group has no live branch left */
+} scan_state;
+
+/**
+ * @brief Interface for locating Doxygen comment delimiters in a buffer.
+ * @details Used as a prefilter so the line-oriented tag parser only runs inside
+ *			comment blocks. The kernel is picked once at runtime.
+ *
+ *			findOpen and findClose match bytes only; nextBlock lexes C in one pass
+ *			so openers inside string and character literals, `//` and `/ *`
+ *			comments and `#if 0` groups are not taken for blocks.
+ */
+typedef struct IScan {
+	/**
+	 * @brief Finds the next "/ **" opener.
+	 * @param p Start of the range to search.
+	 * @param end End of the range.
+	 * @return Pointer to the opener, or end if there is none.
+	 */
+	const char* (*findOpen)(const char*, const char*);
+	/**
+	 * @brief Finds the next "* /" closer.
+	 * @param p Start of the range to search.
+	 * @param end End of the range.
+	 * @return Pointer to the closer, or end if there is none.
+	 */
+	const char* (*findClose)(const char*, const char*);
+	/**
+	 * @brief Finds the next live Doxygen block: a "/ **" that starts a comment
+	 *			in code the preprocessor keeps, preceded only by indentation on
+	 *			its line. A "/ **" followed by '/' or '*' (an empty comment or a
+	 *			banner) is a plain comment.
+	 * @details Between blocks the kernel jumps to the next slash, quote,
+	 *			apostrophe or '#'; everything else is code. Literals end at their
+	 *			unescaped quote or newline, so a stray apostrophe cannot run past
+	 *			its line.
+	 *			`#if 0` (and the `#else` of `#if 1`) is skipped up to the matching
+	 *			`#else`, `#elif` or `#endif`; other conditions count as true.
+	 * @param p Start of the range: at a line start, or just after a block or
+	 *			declaration (never inside a literal or comment).
+	 * @param end End of the range.
+	 * @param st Lexer state of the buffer.
+	 * @return Pointer to the opener, or end if there is none.
+	 */
+	const char* (*nextBlock)(const char*, const char*, scan_state*);
+	/**
+	 * @brief Selects the kernel; unsupported requests fall back to the best available.
+	 * @param isa Requested instruction set.
+	 * @return Instruction set now in use.
+	 */
+	SCANISA (*select)(SCANISA);
+	/**
+	 * @brief Names an instruction set (e.g. "avx2").
+	 * @param isa Instruction set to name.
+	 * @return Static name string.
+	 */
+	const char* (*name)(SCANISA);
+} IScan;
+
+extern const IScan Scan;
+
+#endif // SCAN_H
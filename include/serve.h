@@ -0,0 +1,70 @@
+// serve.h
+#ifndef SERVE_H
+#define SERVE_H
+
+#include <sigcore.h>
+#include "parser.h"
+
+/** @brief Largest request frame the server accepts, in bytes. */
+#define SERVE_MAX_REQUEST 65536
+/** @brief Largest response frame a client accepts, in bytes. */
+#define SERVE_MAX_RESPONSE (256u << 20)
+/** @brief Pending connections the listening socket queues. */
+#define SERVE_BACKLOG 64
+/** @brief Milliseconds a started request or its response may stall before the connection is dropped. */
+#define SERVE_TIMEOUT_MS 5000
+
+/**
+ * @brief Interface for the documentation server (`--serve`) and its client
+ *			(`--connect`).
+ * @details The server loads the targets once and keeps them resident (see
+ *			docset.h), then answers requests on a Unix domain socket. Idle
+ *			connections wait in the accepting thread's poll set; once a request
+ *			arrives, its connection is queued for a pool of worker threads,
+ *			which answers it and returns the connection to the poll set. A
+ *			connection may carry any number of requests, answered in order, and
+ *			holds no worker between them.
+ *
+ *			Every message is a frame: a 4-byte length in network byte order,
+ *			then that many bytes. A request is a command and an optional
+ *			argument separated by a space; a response is a status line, `ok`
+ *			or `error: <reason>`, a '\\n' and the body:
+ *
+ *			- `ping`: body `pong`.
+ *			- `targets`: one `<name> <output>` line per target.
+ *			- `render <target>`: writes the target's document from the resident
+ *			  text (unchanged files are not touched); body is the output path.
+ *			- `symbol <name>`: the markdown of the comment documenting a name.
+ *			- `invalidate <path>`: re-parses one source; body lists the targets
+ *			  that include it, one per line. Their documents are rewritten by
+ *			  the next `render`. A removed source reloads every target.
+ *			- `reload`: reads the configuration again and rebuilds every target.
+ *			- `stop`: stops the server once the response is sent.
+ *
+ *			render and symbol requests run concurrently; invalidate and reload
+ *			wait for them and hold the targets alone.
+ */
+typedef struct IServe {
+	/**
+	 * @brief Loads the targets and serves requests until stopped.
+	 * @param config Configuration (file, workers, cache, template, debug);
+	 *			jobs also sizes the worker pool.
+	 * @param names Target names, or NULL for every target except `default`.
+	 * @param path Socket path; a stale socket left by a dead server is replaced.
+	 * @return 0 on a clean stop (`stop`, SIGINT or SIGTERM), non-zero if
+	 *			serving failed.
+	 */
+	int (*run)(doxy_config*, list, const string);
+	/**
+	 * @brief Sends one request to a server and prints the response body to
+	 *			stdout, or its error to stderr.
+	 * @param path Socket path.
+	 * @param request Request text (e.g. "render doxy").
+	 * @return 0 if the server answered `ok`, non-zero otherwise.
+	 */
+	int (*request)(const string, const string);
+} IServe;
+
+extern const IServe Serve;
+
+#endif // SERVE_H
@@ -0,0 +1,94 @@
+// sink.h
+#ifndef SINK_H
+#define SINK_H
+
+#include <sigcore.h>
+#include <stddef.h>
+
+/** @brief Bytes buffered by a sink before they are flushed. */
+#define SINK_BUFFER 65536
+
+typedef struct sink_s* sink;
+
+/**
+ * @brief Receives output flushed by a callback sink.
+ * @param data Bytes (not NUL-terminated).
+ * @param len Number of bytes.
+ * @param arg Context given to Sink.toCallback.
+ * @return 0 on success; non-zero fails the sink, which stops further calls.
+ */
+typedef int (*sink_fn)(const char*, size_t, object);
+
+/**
+ * @brief Interface for buffered output sinks.
+ * @details Generators write through a sink so a document can be streamed to a
+ *			file as it is rendered, collected in a StringBuilder, or handed to a
+ *			caller's function in buffer-sized pieces. A file sink
+ *			writes to a temporary file that FileWriter commits on close (skipped
+ *			when unchanged), so an aborted document leaves the previous file
+ *			untouched.
+ */
+typedef struct ISink {
+	/**
+	 * @brief Opens a sink writing to a file.
+	 * @param path Destination file path.
+	 * @return Sink, or NULL if the temporary file cannot be created.
+	 */
+	sink (*open)(const string);
+	/**
+	 * @brief Opens a sink appending to a StringBuilder.
+	 * @param sb StringBuilder to append to (not owned).
+	 * @return Sink, or NULL on failure.
+	 */
+	sink (*toBuilder)(string_builder);
+	/**
+	 * @brief Opens a sink handing its output to a function.
+	 * @param fn Function receiving the bytes, at most SINK_BUFFER at a time
+	 *			unless a larger block is written at once; called on the writing
+	 *			thread, and last by close.
+	 * @param arg Context passed to fn (not owned).
+	 * @return Sink, or NULL on failure.
+	 */
+	sink (*toCallback)(sink_fn, object);
+	/**
+	 * @brief Writes bytes to a sink.
+	 * @param s Sink to write to.
+	 * @param data Bytes to write.
+	 * @param len Number of bytes.
+	 */
+	void (*write)(sink, const char*, size_t);
+	/**
+	 * @brief Writes a NUL-terminated string to a sink.
+	 * @param s Sink to write to.
+	 * @param str String to write.
+	 */
+	void (*append)(sink, const char*);
+	/**
+	 * @brief Writes printf-style formatted text to a sink.
+	 * @param s Sink to write to.
+	 * @param format Format string.
+	 */
+	void (*appendf)(sink, const char*, ...);
+	/**
+	 * @brief Flushes and closes a sink; a file sink replaces its destination
+	 *			unless the content is unchanged.
+	 * @param s Sink to close.
+	 * @return 0 on success, non-zero if any write (or callback) failed.
+	 */
+	int (*close)(sink);
+	/**
+	 * @brief Closes a sink and discards its output.
+	 * @param s Sink to abort.
+	 */
+	void (*abort)(sink);
+	/**
+	 * @brief Returns the number of bytes written so far.
+	 * @param s Sink to query.
+	 * @return Byte count.
+	 */
+	size_t (*length)(sink);
+} ISink;
+
+extern const ISink Sink;
+
+#endif // SINK_H
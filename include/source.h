@@ -0,0 +1,95 @@
+// source.h
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <sigcore.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Largest source a span can view into (offsets are 32-bit). */
+#define SPAN_MAX UINT32_MAX
+
+/**
+ * @brief A view into a source buffer: (offset, length).
+ */
+typedef struct span_s {
+	uint32_t offset;	/**< Byte offset into the owning buffer */
+	uint32_t length;	/**< Length of the view in bytes */
+} span;
+
+/**
+ * @brief Array of spans (e.g. detail lines, params); a comment's lists are
+ *			views into its unit's pools.
+ */
+typedef struct span_list_s {
+	span* items;		/**< Span storage */
+	int count;			/**< Number of spans in use */
+	int capacity;		/**< Allocated span slots */
+} span_list;
+
+/**
+ * @brief A source file mapped read-only into memory.
+ */
+struct source_s {
+	string path;		/**< Source path as given by the target (stored with the source) */
+	const char* data;	/**< Mapped bytes (not NUL-terminated) */
+	size_t size;		/**< Number of mapped bytes */
+	int is_mapped;		/**< 1 if data is an mmap, 0 if a heap copy */
+	int refs;			/**< Holders of views into data */
+};
+typedef struct source_s* source;
+
+/**
+ * @brief File identity used to detect unchanged sources.
+ */
+typedef struct source_stamp {
+	uint64_t size;		/**< File size in bytes */
+	int64_t mtime_sec;	/**< Modification time, seconds */
+	int64_t mtime_nsec;	/**< Modification time, nanoseconds */
+} source_stamp;
+
+/** @brief Pointer to the first byte of a span within its source. */
+#define SPAN_PTR(s, sp) ((s)->data + (sp).offset)
+
+/**
+ * @brief Interface for mapping source files.
+ */
+typedef struct ISource {
+	/**
+	 * @brief Maps a source file into memory.
+	 * @param path Source file to map.
+	 * @return Source with one reference, or NULL on failure (including sources
+	 *			larger than SPAN_MAX bytes).
+	 */
+	source (*open)(const string);
+	/**
+	 * @brief Wraps a heap buffer as a source; the source takes ownership of data.
+	 * @param path Path reported for the source.
+	 * @param data Buffer allocated with Mem.alloc.
+	 * @param size Number of bytes in data.
+	 * @return Source with one reference, or NULL on failure.
+	 */
+	source (*fromBuffer)(const string, char*, size_t);
+	/**
+	 * @brief Reads the size and modification time of a file.
+	 * @param path File to stat.
+	 * @param stamp Output stamp.
+	 * @return 0 on success, non-zero on failure.
+	 */
+	int (*stat)(const string, source_stamp*);
+	/**
+	 * @brief Adds a reference to a source.
+	 * @param s Source to retain.
+	 * @return The same source.
+	 */
+	source (*retain)(source);
+	/**
+	 * @brief Drops a reference; unmaps the source when none remain.
+	 * @param s Source to release.
+	 */
+	void (*release)(source);
+} ISource;
+
+extern const ISource Source;
+
+#endif // SOURCE_H
@@ -0,0 +1,58 @@
+// stats.h
+#ifndef STATS_H
+#define STATS_H
+
+#include <sigcore.h>
+#include <stddef.h>
+
+/** @brief Spans kept for the summary and trace; later ones are only counted,
+ *			which bounds the memory of a long --watch or --serve run. */
+#define STATS_MAX_EVENTS (1 << 18)
+
+/**
+ * @brief Interface for pipeline timing (--stats, --trace).
+ * @details Stages record spans on the thread that ran them: `index` (reading
+ *			Doxy2MD), `parse` (one per source file), `generate` (one per rendered
+ *			unit) and `write` (committing an output file). Recording is off until
+ *			start is called and then costs one clock read and one locked append
+ *			per span.
+ */
+typedef struct IStats {
+	/**
+	 * @brief Turns recording on.
+	 * @param summary Print a summary from finish.
+	 * @param trace Chrome trace-event file written by finish, or NULL.
+	 */
+	void (*start)(int, const string);
+	/**
+	 * @brief Returns the current time for a span start.
+	 * @return Microseconds since start, or 0 when recording is off.
+	 */
+	long (*now)(void);
+	/**
+	 * @brief Records a stage span from begin until now on the calling thread.
+	 * @param stage Stage name (static string).
+	 * @param file File the span worked on, or NULL.
+	 * @param begin Value of now at the start of the span.
+	 */
+	void (*span)(const char*, const char*, long);
+	/**
+	 * @brief Records the parse of one source file (a `parse` span).
+	 * @param path Source file.
+	 * @param bytes Bytes read.
+	 * @param kept Comment blocks kept.
+	 * @param dropped Comment blocks dropped (empty or unterminated).
+	 * @param cached 1 if the parse cache served the file.
+	 * @param begin Value of now at the start of the parse.
+	 */
+	void (*file)(const char*, size_t, int, int, int, long);
+	/**
+	 * @brief Prints the summary and writes the trace, then turns recording off.
+	 * @return 0 on success, non-zero if the trace file cannot be written.
+	 */
+	int (*finish)(void);
+} IStats;
+
+extern const IStats Stats;
+
+#endif // STATS_H
@@ -0,0 +1,27 @@
+// strmap.h
+#ifndef STRMAP_H
+#define STRMAP_H
+
+#include <sigcore.h>
+#include <stddef.h>
+
+typedef struct strmap_s* strmap;
+
+/**
+ * @brief Interface for hash maps keyed by byte strings.
+ * @details Open addressing with linear probing. Keys are not copied: the caller
+ *			keeps them alive for the lifetime of the map.
+ */
+typedef struct IStrMap {
+	strmap (*new)(int);									/**< Creates a map sized for the given number of entries. */
+	void (*free)(strmap);								/**< Frees the map (not the keys or values). */
+	void (*put)(strmap, const char*, object);			/**< Inserts or replaces the value of a NUL-terminated key. */
+	object (*get)(strmap, const char*);					/**< Returns the value of a NUL-terminated key, or NULL. */
+	void (*putn)(strmap, const char*, size_t, object);	/**< Inserts or replaces the value of a (pointer, length) key. */
+	object (*getn)(strmap, const char*, size_t);		/**< Returns the value of a (pointer, length) key, or NULL. */
+	int (*count)(strmap);								/**< Returns the number of entries. */
+} IStrMap;
+
+extern const IStrMap StrMap;
+
+#endif // STRMAP_H
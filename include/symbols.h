@@ -0,0 +1,78 @@
+// symbols.h
+#ifndef SYMBOLS_H
+#define SYMBOLS_H
+
+#include <sigcore.h>
+#include <stddef.h>
+#include "parser.h"
+
+/**
+ * @brief A documented name: the first comment declaring it in a document.
+ */
+typedef struct symbol_s {
+	const char* name;			/**< Declared name (view into the source) */
+	size_t length;				/**< Length of the name */
+	comment c;					/**< Comment documenting the declaration */
+	struct symbol_s** refs;		/**< Symbols whose text mentions this one, in document order */
+	int ref_count;				/**< Number of refs */
+	int last;					/**< Index + 1 of the last referrer recorded (build only) */
+} symbol;
+
+/**
+ * @brief Interface for the symbol index of a document (--links).
+ * @details Built from parsed units: every named declaration is entered in a
+ *			hash map keyed by a view of its name, so each identifier costs one
+ *			lookup; length tables by first and last byte and a Bloom filter,
+ *			hashed while the word is scanned, turn away most words that name
+ *			nothing before the map is probed. The briefs, details, `@see`
+ *			lines and signatures of every symbol are then scanned once to fill
+ *			the "referenced by" lists.
+ *			Names view into the units' sources; the units must outlive the index.
+ */
+typedef struct ISymbols {
+	/**
+	 * @brief Indexes the named declarations of a document.
+	 * @param units Units in source order.
+	 * @return Index, or NULL on failure.
+	 */
+	symtab (*build)(list);
+	/**
+	 * @brief Frees an index (not the units).
+	 * @param st Index to free; NULL is ignored.
+	 */
+	void (*free)(symtab);
+	/**
+	 * @brief Looks up a name.
+	 * @param st Index.
+	 * @param name Name bytes.
+	 * @param len Length of the name.
+	 * @return Symbol, or NULL if the name is not documented.
+	 */
+	symbol* (*find)(symtab, const char*, size_t);
+	/**
+	 * @brief Returns the symbol a comment defines.
+	 * @param st Index.
+	 * @param c Comment.
+	 * @return Symbol, or NULL if the comment declares no name or repeats one.
+	 */
+	symbol* (*of)(symtab, comment);
+	/**
+	 * @brief Finds the next identifier in a text that names a symbol.
+	 * @details Identifiers inside `code` spans and command words (`@brief`)
+	 *			are skipped.
+	 * @param st Index.
+	 * @param p In/out: scan position; moved past the identifier found.
+	 * @param end End of the text.
+	 * @param at Output: start of the identifier found.
+	 * @return Symbol, or NULL when the rest of the text names none.
+	 */
+	symbol* (*next)(symtab, const char**, const char*, const char**);
+	/**
+	 * @brief Returns the number of symbols.
+	 */
+	int (*count)(symtab);
+} ISymbols;
+
+extern const ISymbols Symbols;
+
+#endif // SYMBOLS_H
@@ -0,0 +1,113 @@
+// template.h
+#ifndef TEMPLATE_H
+#define TEMPLATE_H
+
+#include <sigcore.h>
+#include <stddef.h>
+#include "parser.h"
+
+/**
+ * @brief Instruction of a compiled template.
+ */
+typedef enum tmpl_opcode {
+	TOP_TEXT,			/**< Copy literal text */
+	TOP_FIELD,			/**< Write a field */
+	TOP_SECTION,		/**< Enter when the field is not empty, else jump past END */
+	TOP_INVERTED,		/**< Enter when the field or list is empty, else jump past END */
+	TOP_LOOP,			/**< Repeat up to END once per list item; jump past END if none */
+	TOP_END				/**< Close a section; a loop's END jumps back for the next item */
+} tmpl_opcode;
+
+/**
+ * @brief Value an instruction reads; item fields exist inside a loop only.
+ */
+typedef enum tmpl_field {
+	TF_NAME,			/**< Declared name */
+	TF_FILE,			/**< Source path */
+	TF_KIND,			/**< Declaration kind ("function", "struct", ...) */
+	TF_TYPE,			/**< Return type, or the type of a variable */
+	TF_SIGNATURE,		/**< Declaration text */
+	TF_IS_FILE,			/**< Set for `@file` comments (sections only) */
+	TF_TAG,				/**< Text of every section of a tag kind, lines joined by newlines */
+	TF_TITLE,			/**< Document title (header and footer only) */
+	TF_ITEM_NAME,		/**< Item name: parameter, retval or referrer */
+	TF_ITEM_TEXT,		/**< Item text, lines joined by spaces */
+	TF_ITEM_DIR,		/**< `@param` direction: "in", "out" or "in,out" */
+	TF_FIRST,			/**< Set on the first item (sections only) */
+	TF_LAST,			/**< Set on the last item (sections only) */
+	TL_TAG,				/**< List: sections of a tag kind */
+	TL_ARGS,			/**< List: parameters of the declaration */
+	TL_REFS				/**< List: symbols referencing this one (--links) */
+} tmpl_field;
+
+/**
+ * @brief One instruction: literal spans point into the template text.
+ */
+typedef struct tmpl_op_s {
+	tmpl_opcode op;		/**< What to do */
+	tmpl_field field;	/**< Field or list read (not TOP_TEXT) */
+	tag_kind tag;		/**< Tag kind of TF_TAG and TL_TAG */
+	const char* text;	/**< Literal bytes (TOP_TEXT) */
+	size_t len;			/**< Literal length */
+	int jump;			/**< Opening ops: index of the matching END; END: index of its opening op */
+} tmpl_op;
+
+/**
+ * @brief Parts of a template: the body is rendered per comment, the header
+ *			and footer once per document.
+ */
+typedef enum tmpl_part {
+	TMPL_BODY,
+	TMPL_HEADER,
+	TMPL_FOOTER
+} tmpl_part;
+
+/** @brief Deepest nesting of sections in a template. */
+#define TMPL_MAX_DEPTH 16
+
+/**
+ * @brief Interface for output templates.
+ * @details Templates are compiled once into a flat list of instructions, so a
+ *			generator renders each comment with a loop over literal copies and
+ *			field writes, without reparsing any format.
+ *
+ *			`{{field}}` writes a field, `{{#field}}...{{/field}}` renders its
+ *			content when the field is not empty (once per item for a list),
+ *			`{{^field}}...{{/field}}` when it is empty, and `{{! text}}` is a
+ *			comment. A line holding only a section tag or a comment is dropped
+ *			from the output. `{{#header}}` and `{{#footer}}` blocks at the top
+ *			level are rendered once at the start and end of each document.
+ */
+typedef struct ITemplate {
+	/**
+	 * @brief Compiles template text.
+	 * @param name Name used in error messages (e.g. the file path).
+	 * @param text Template text; must outlive the template.
+	 * @param len Length of the text.
+	 * @return Template, or NULL after printing an error to stderr.
+	 */
+	tmpl (*compile)(const string, const char*, size_t);
+	/**
+	 * @brief Reads and compiles a template file.
+	 * @param path Template file.
+	 * @return Template owning the file's text, or NULL after printing an error.
+	 */
+	tmpl (*load)(const string);
+	/**
+	 * @brief Returns the instructions of a template part.
+	 * @param t Template.
+	 * @param part Body, header or footer.
+	 * @param count Output: number of instructions (0 if the part is absent).
+	 * @return Instructions, valid while the template lives.
+	 */
+	const tmpl_op* (*program)(tmpl, tmpl_part, int*);
+	/**
+	 * @brief Frees a template.
+	 * @param t Template; NULL is ignored.
+	 */
+	void (*free)(tmpl);
+} ITemplate;
+
+extern const ITemplate Template;
+
+#endif // TEMPLATE_H
@@ -0,0 +1,46 @@
+// walk.h
+#ifndef WALK_H
+#define WALK_H
+
+#include <sigcore.h>
+
+/** @brief Most threads used to enumerate a recursive pattern. */
+#define WALK_THREADS 8
+
+/**
+ * @brief Interface for expanding source path patterns.
+ * @details Patterns are paths whose components may hold `*`, `?` and `[...]`
+ *			(matched per component; hidden names only match a leading `.`) or be
+ *			`**`, which matches any number of directories. A last component of
+ *			exactly `*` keeps its Doxy2MD meaning: every C source and header
+ *			(`.c`, `.h`) of the directory. Directories of a recursive pattern are
+ *			read in parallel; symbolic links to directories are not followed.
+ */
+typedef struct IWalk {
+	/**
+	 * @brief Tests whether a path token is a pattern.
+	 * @param token Path from a target line.
+	 * @return 1 if it holds `*`, `?` or `[`, 0 otherwise.
+	 */
+	int (*isPattern)(const string);
+	/**
+	 * @brief Expands a pattern into the files it matches.
+	 * @param pattern Pattern; any component may be a glob or `**`.
+	 * @param out List receiving allocated paths, sorted (caller frees).
+	 * @return Number of paths added, or -1 if the pattern's base directory
+	 *			cannot be read.
+	 */
+	int (*expand)(const string, list);
+	/**
+	 * @brief Matches a path against a pattern.
+	 * @details A pattern without `/` matches the last component at any depth.
+	 * @param pattern Pattern (same syntax as expand).
+	 * @param path Path to test.
+	 * @return 1 on a match, 0 otherwise.
+	 */
+	int (*match)(const string, const string);
+} IWalk;
+
+extern const IWalk Walk;
+
+#endif // WALK_H
@@ -0,0 +1,33 @@
+// watch.h
+#ifndef WATCH_H
+#define WATCH_H
+
+#include <sigcore.h>
+#include "parser.h"
+
+/** @brief Quiet time that ends a burst of changes, in milliseconds. */
+#define WATCH_DEBOUNCE_MS 10
+/** @brief Longest a burst may delay regeneration, in milliseconds. */
+#define WATCH_MAX_DELAY_MS 500
+
+/**
+ * @brief Interface for regenerating documentation as sources change.
+ * @details Targets and their parsed units stay in memory. The directories of
+ *			all sources and of the configuration are watched with inotify; an
+ *			edited source is re-parsed on its own and only the targets that
+ *			include it are rendered again. Files appearing or disappearing and
+ *			edits to the configuration reload every target.
+ */
+typedef struct IWatch {
+	/**
+	 * @brief Builds the targets, then regenerates them on change until interrupted.
+	 * @param config Configuration (file, workers, cache, debug).
+	 * @param names Target names, or NULL for every target except `default`.
+	 * @return 0 on a clean stop (SIGINT/SIGTERM), non-zero if watching failed.
+	 */
+	int (*run)(doxy_config*, list);
+} IWatch;
+
+extern const IWatch Watch;
+
+#endif // WATCH_H
@@ -3,9 +3,22 @@
 #define WRITER_H
 
 #include <sigcore.h>
+#include <stdio.h>
+
+/**
+ * @brief Process-wide output counters.
+ */
+typedef struct writer_stats {
+	long written;		/**< Files replaced or created */
+	long skipped;		/**< Files left alone because their content was unchanged */
+} writer_stats;
 
 /**
  * @brief Interface for writing generated output.
+ * @details Output is written to a temporary file in the destination's
+ *			directory, synced to disk and renamed into place, so a crash never
+ *			leaves a partial file; a replaced file keeps its mode. A destination
+ *			whose content would not change is not touched (its mtime is kept).
  */
 typedef struct IWriter {
 	/**
@@ -15,6 +28,26 @@ typedef struct IWriter {
 	* @return 0 on success, non-zero on failure.
 	*/
     int (*write)(const string, const string);
+	/**
+	 * @brief Creates a temporary file next to a destination.
+	 * @param filepath Destination file path.
+	 * @param temp Output: allocated temporary file path (caller frees).
+	 * @return Stream open for writing, or NULL on failure.
+	 */
+	FILE* (*begin)(const string, string*);
+	/**
+	 * @brief Moves a finished temporary file into place unless the destination
+	 *			already has the same content, in which case it is discarded.
+	 * @param temp Temporary file path (closed).
+	 * @param filepath Destination file path.
+	 * @return 0 on success, non-zero on failure.
+	 */
+	int (*commit)(const string, const string);
+	/**
+	 * @brief Returns a snapshot of the written/skipped counters.
+	 * @return Counters.
+	 */
+	writer_stats (*stats)(void);
 } IWriter;
 
 extern const IWriter FileWriter;
@@ -0,0 +1,119 @@
+// arena.c
+#include "arena.h"
+#include <stdint.h>
+#include <string.h>
+
+#define ARENA_ALIGN 16
+
+/* structure representing one block of an arena */
+struct block_s {
+	struct block_s* next;	/**< Previously filled block */
+	size_t size;			/**< Usable bytes in data */
+	size_t used;			/**< Bytes handed out */
+	char data[];			/**< Block storage */
+};
+/* structure representing an arena */
+struct arena_s {
+	struct block_s* head;	/**< Block allocations are served from */
+	size_t block_size;		/**< Default size of new blocks */
+	size_t reserved;		/**< Bytes held in blocks */
+	size_t used;			/**< Bytes handed out, alignment included */
+};
+
+static arena_stats STATS = { 0 };
+
+/**
+ * @brief Adds to a shared counter and tracks the reserved high-water mark.
+ */
+static void count_block(size_t bytes, long blocks) {
+	__atomic_add_fetch(&STATS.blocks, blocks, __ATOMIC_RELAXED);
+	size_t reserved = __atomic_add_fetch(&STATS.reserved, bytes, __ATOMIC_RELAXED);
+	size_t peak = __atomic_load_n(&STATS.peak, __ATOMIC_RELAXED);
+	while (reserved > peak && 
+	       !__atomic_compare_exchange_n(&STATS.peak, &peak, reserved, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+/**
+ * @brief Creates an arena.
+ * @param block_size Default size of each block.
+ * @return Allocated arena or NULL on failure.
+ */
+static arena arena_new(size_t block_size) {
+	arena a = Mem.alloc(sizeof(struct arena_s));
+	if (a) {
+		a->head = NULL;
+		a->block_size = block_size ? block_size : 16384;
+		a->reserved = 0;
+		a->used = 0;
+		__atomic_add_fetch(&STATS.arenas, 1, __ATOMIC_RELAXED);
+	}
+	return a;
+}
+/**
+ * @brief Returns zeroed memory owned by the arena.
+ * @param a Arena to allocate from.
+ * @param size Bytes requested.
+ * @return Pointer aligned to ARENA_ALIGN, or NULL on failure.
+ */
+static object arena_alloc(arena a, size_t size) {
+	struct block_s* b = a->head;
+	size_t pad = 0;
+	if (b) pad = -(uintptr_t)(b->data + b->used) & (ARENA_ALIGN - 1);
+	
+	if (!b || b->used + pad + size > b->size) {
+		size_t bytes = size + ARENA_ALIGN > a->block_size ? size + ARENA_ALIGN : a->block_size;
+		b = Mem.alloc(sizeof(struct block_s) + bytes);
+		if (!b) return NULL;
+		b->next = a->head;
+		b->size = bytes;
+		b->used = 0;
+		a->head = b;
+		a->reserved += bytes;
+		count_block(bytes, 1);
+		pad = -(uintptr_t)b->data & (ARENA_ALIGN - 1);
+	}
+	
+	char* p = b->data + b->used + pad;
+	b->used += pad + size;
+	a->used += pad + size;
+	__atomic_add_fetch(&STATS.allocs, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&STATS.used, pad + size, __ATOMIC_RELAXED);
+	
+	memset(p, 0, size);
+	return p;
+}
+/**
+ * @brief Releases the arena and all of its blocks.
+ * @param a Arena to release.
+ */
+static void arena_free(arena a) {
+	if (!a) return;
+	struct block_s* b = a->head;
+	while (b) {
+		struct block_s* next = b->next;
+		Mem.free(b);
+		b = next;
+	}
+	__atomic_sub_fetch(&STATS.reserved, a->reserved, __ATOMIC_RELAXED);
+	__atomic_sub_fetch(&STATS.used, a->used, __ATOMIC_RELAXED);
+	Mem.free(a);
+}
+/**
+ * @brief Returns a snapshot of the process-wide counters.
+ */
+static arena_stats arena_get_stats(void) {
+	arena_stats s;
+	s.arenas = __atomic_load_n(&STATS.arenas, __ATOMIC_RELAXED);
+	s.blocks = __atomic_load_n(&STATS.blocks, __ATOMIC_RELAXED);
+	s.allocs = __atomic_load_n(&STATS.allocs, __ATOMIC_RELAXED);
+	s.reserved = __atomic_load_n(&STATS.reserved, __ATOMIC_RELAXED);
+	s.used = __atomic_load_n(&STATS.used, __ATOMIC_RELAXED);
+	s.peak = __atomic_load_n(&STATS.peak, __ATOMIC_RELAXED);
+	return s;
+}
+
+const IArena Arena = {
+	.new = arena_new,
+	.alloc = arena_alloc,
+	.free = arena_free,
+	.stats = arena_get_stats
+};
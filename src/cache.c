@@ -0,0 +1,367 @@
+// cache.c
+#define _POSIX_C_SOURCE 200809L
+#include "cache.h"
+#include "strmap.h"
+#include <errno.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CACHE_VERSION 6
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+/*	span lies inside a pool of the given size (summed in 64 bits, so it cannot wrap) */
+#define IN_POOL(sp, size) ((uint64_t)(sp).offset + (sp).length <= (size))
+
+static const char CACHE_MAGIC[4] = { 'D', 'X', 'C', '1' };
+
+/* structure representing the fixed head of a cache entry */
+struct cache_header {
+	char magic[4];			/**< CACHE_MAGIC */
+	uint32_t version;		/**< CACHE_VERSION */
+	uint64_t size;			/**< Source size when parsed */
+	int64_t mtime_sec;		/**< Source mtime when parsed */
+	int64_t mtime_nsec;
+	uint64_t hash;			/**< Content hash of the source */
+	uint32_t path_len;		/**< Bytes of source path that follow the header */
+	uint32_t comments;		/**< Number of cache_record entries */
+	uint32_t spans;			/**< Number of text line and parameter spans */
+	uint32_t tags;			/**< Number of tags */
+	uint64_t pool;			/**< Bytes of text the spans view into */
+};
+/* structure representing one comment in a cache entry */
+struct cache_record {
+	span signature;
+	span func_name;
+	span ret_type;
+	uint32_t lines;			/**< Line spans of this comment */
+	uint32_t tags;			/**< Tags of this comment */
+	uint32_t params;		/**< Parameter spans, after the line spans */
+	uint32_t kind;			/**< decl_kind */
+	uint32_t is_file;
+	uint32_t reserved;
+};
+
+/* structure representing the text pool of an entry being written */
+struct pool_s {
+	FILE* f;			/**< Entry, positioned in the pool */
+	source s;			/**< Source the spans view into */
+	uint64_t size;		/**< Bytes of pool written so far */
+	strmap strings;		/**< Text already in the pool (views into s) -> offset + 1 */
+};
+
+static cache_stats STATS = { 0 };
+static long TEMP_SEQ = 0;
+
+/**
+ * @brief Hashes a buffer 8 bytes at a time with FNV-1a style mixing.
+ */
+static uint64_t hash_bytes(const char* p, size_t n) {
+	uint64_t h = FNV_OFFSET;
+	uint64_t w;
+	for (; n >= 8; p += 8, n -= 8) {
+		memcpy(&w, p, 8);
+		h = (h ^ w) * FNV_PRIME;
+	}
+	while (n--) h = (h ^ (unsigned char)*p++) * FNV_PRIME;
+	return h;
+}
+/**
+ * @brief Builds the entry path for a source: <dir>/<hash of path>.dxc
+ * @return Allocated path (caller frees).
+ */
+static string entry_path(const string dir, const string path) {
+	size_t len = strlen(dir) + 22;
+	string entry = Mem.alloc(len);
+	snprintf(entry, len, "%s/%016llx.dxc", dir, (unsigned long long)hash_bytes(path, strlen(path)));
+	return entry;
+}
+/**
+ * @brief Hashes the current content of a source file.
+ * @return 0 on success, non-zero if the file cannot be read.
+ */
+static int hash_file(const string path, uint64_t* hash) {
+	source s = Source.open(path);
+	if (!s) return 1;
+	*hash = hash_bytes(s->data, s->size);
+	Source.release(s);
+	return 0;
+}
+/**
+ * @brief Reads the records of an entry into a new unit.
+ * @details Every span is checked against the pool, so a stale or corrupt
+ *			entry is a miss rather than a read outside the buffer.
+ * @param f Entry positioned after the source path.
+ * @param h Entry header.
+ * @param path Source path.
+ * @return Unit, or NULL on a short or corrupt entry.
+ */
+static unit read_unit(FILE* f, const struct cache_header* h, const string path) {
+	char* pool = Mem.alloc(h->pool ? h->pool : 1);
+	source s = pool ? Source.fromBuffer(path, pool, h->pool) : NULL;
+	unit u = s ? new_unit(s) : NULL;
+	if (s) Source.release(s);		//	the unit holds its own reference
+	if (!u) return NULL;
+	
+	struct cache_record* records = Mem.alloc((h->comments ? h->comments : 1) * sizeof(struct cache_record));
+	u->comments = Arena.alloc(u->mem, (h->comments ? h->comments : 1) * sizeof(struct comment_s));
+	span* spans = Arena.alloc(u->mem, (h->spans ? h->spans : 1) * sizeof(span));
+	tag* tags = Arena.alloc(u->mem, (h->tags ? h->tags : 1) * sizeof(tag));
+	if (!records || !u->comments || !spans || !tags ||
+	    fread(records, sizeof(struct cache_record), h->comments, f) != h->comments ||
+	    fread(spans, sizeof(span), h->spans, f) != h->spans ||
+	    fread(tags, sizeof(tag), h->tags, f) != h->tags ||
+	    fread(pool, 1, h->pool, f) != h->pool) {
+		goto fail;
+	}
+	for (uint32_t i = 0; i < h->spans; i++) {
+		if (!IN_POOL(spans[i], h->pool)) goto fail;
+	}
+	for (uint32_t i = 0; i < h->tags; i++) {
+		if (!IN_POOL(tags[i].name, h->pool) || !IN_POOL(tags[i].arg, h->pool)) goto fail;
+	}
+	
+	//	comments view straight into the line and tag arrays
+	uint32_t next = 0;
+	uint32_t next_tag = 0;
+	for (uint32_t i = 0; i < h->comments; i++) {
+		struct cache_record* r = &records[i];
+		comment c = &u->comments[i];
+		if ((uint64_t)next + r->lines + r->params > h->spans || (uint64_t)next_tag + r->tags > h->tags || r->kind > DECL_VARIABLE ||
+		    !IN_POOL(r->signature, h->pool) || !IN_POOL(r->func_name, h->pool) || !IN_POOL(r->ret_type, h->pool)) {
+			goto fail;
+		}
+		c->src = u->src;
+		c->signature = r->signature;
+		c->func_name = r->func_name;
+		c->ret_type = r->ret_type;
+		c->kind = r->kind;
+		c->is_file = r->is_file;
+		c->lines.items = spans + next;
+		c->lines.count = c->lines.capacity = r->lines;
+		next += r->lines;
+		c->params.items = spans + next;
+		c->params.count = c->params.capacity = r->params;
+		next += r->params;
+		c->tags.items = tags + next_tag;
+		c->tags.count = c->tags.capacity = r->tags;
+		next_tag += r->tags;
+		for (uint32_t j = 0; j < r->tags; j++) {
+			tag* t = &c->tags.items[j];
+			if (t->first < 0 || t->count < 0 || (long long)t->first + t->count > c->lines.count) {
+				goto fail;
+			}
+		}
+		u->count++;
+	}
+	Mem.free(records);
+	return u;
+
+fail:
+	if (records) Mem.free(records);
+	free_unit(u);
+	return NULL;
+}
+/**
+ * @brief Loads the cached unit of a source if its entry is current.
+ * @param dir Cache directory.
+ * @param path Source path.
+ * @param stamp Current stamp of the source.
+ * @param out Output: cached unit, or NULL if the source has no comments.
+ * @return 1 on a hit, 0 on a miss.
+ */
+static int cache_load(const string dir, const string path, const source_stamp* stamp, unit* out) {
+	string entry = entry_path(dir, path);
+	FILE* f = fopen(entry, "r+b");
+	struct cache_header h;
+	int hit = 0;
+	*out = NULL;
+	
+	if (!f || fread(&h, sizeof(h), 1, f) != 1 || memcmp(h.magic, CACHE_MAGIC, 4) != 0 || 
+	    h.version != CACHE_VERSION || h.path_len != strlen(path) || h.size != stamp->size) {
+		goto cleanup;
+	}
+	
+	string stored = Mem.alloc(h.path_len + 1);
+	int same_path = fread(stored, 1, h.path_len, f) == h.path_len && memcmp(stored, path, h.path_len) == 0;
+	Mem.free(stored);
+	if (!same_path) goto cleanup;
+	
+	if (h.mtime_sec != stamp->mtime_sec || h.mtime_nsec != stamp->mtime_nsec) {
+		//	touched: confirm by content, then refresh the stamp
+		uint64_t hash;
+		if (hash_file(path, &hash) != 0 || hash != h.hash) goto cleanup;
+		
+		long records = ftell(f);
+		h.mtime_sec = stamp->mtime_sec;
+		h.mtime_nsec = stamp->mtime_nsec;
+		rewind(f);
+		fwrite(&h, sizeof(h), 1, f);
+		fseek(f, records, SEEK_SET);
+		__atomic_add_fetch(&STATS.rehashed, 1, __ATOMIC_RELAXED);
+	}
+	
+	if (h.comments > 0) {
+		*out = read_unit(f, &h, path);
+		hit = *out != NULL;
+	} else {
+		hit = 1;
+	}
+	
+cleanup:
+	__atomic_add_fetch(hit ? &STATS.hits : &STATS.misses, 1, __ATOMIC_RELAXED);
+	if (f) fclose(f);
+	Mem.free(entry);
+	return hit;
+}
+/**
+ * @brief Rebases a span into the pool, writing its text only on first sight.
+ * @details Text is interned by content: tag names, types and repeated lines
+ *			are stored once per entry and shared by every span that has them.
+ * @param pool Pool being written.
+ * @param sp Span to rebase.
+ * @return The rebased span.
+ */
+static span pool_span(struct pool_s* pool, span sp) {
+	span rebased = { 0, sp.length };
+	if (!sp.length) return rebased;
+	const char* text = SPAN_PTR(pool->s, sp);
+	intptr_t at = (intptr_t)StrMap.getn(pool->strings, text, sp.length);
+	if (at) {
+		rebased.offset = (uint32_t)(at - 1);
+		return rebased;
+	}
+	rebased.offset = (uint32_t)pool->size;
+	fwrite(text, 1, sp.length, pool->f);
+	StrMap.putn(pool->strings, text, sp.length, (object)(intptr_t)(pool->size + 1));
+	pool->size += sp.length;
+	return rebased;
+}
+/**
+ * @brief Rebases a span that lies within another, already pooled, span.
+ * @details A declaration's name, type and parameters are part of its text, so they view
+ *			into the pooled signature instead of being stored again.
+ * @param pool Pool being written.
+ * @param outer Span as parsed.
+ * @param pooled The outer span rebased.
+ * @param sp Span to rebase.
+ * @return The rebased span.
+ */
+static span pool_inner(struct pool_s* pool, span outer, span pooled, span sp) {
+	if (!sp.length || sp.offset < outer.offset || sp.offset + sp.length > outer.offset + outer.length) {
+		return pool_span(pool, sp);
+	}
+	span rebased = { pooled.offset + (sp.offset - outer.offset), sp.length };
+	return rebased;
+}
+/**
+ * @brief Stores the parse results of a source.
+ * @param dir Cache directory (created if missing).
+ * @param stamp Stamp of the source when it was parsed.
+ * @param s Parsed source (hashed for the entry).
+ * @param u Parse results, or NULL if the source has no comments.
+ */
+static void cache_store(const string dir, const source_stamp* stamp, source s, unit u) {
+	if (mkdir(dir, 0755) != 0 && errno != EEXIST) return;
+	
+	struct cache_header h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, CACHE_MAGIC, 4);
+	h.version = CACHE_VERSION;
+	h.size = stamp->size;
+	h.mtime_sec = stamp->mtime_sec;
+	h.mtime_nsec = stamp->mtime_nsec;
+	h.hash = hash_bytes(s->data, s->size);
+	h.path_len = strlen(s->path);
+	
+	int count = u ? u->count : 0;
+	h.comments = count;
+	for (int i = 0; i < count; i++) {
+		comment c = &u->comments[i];
+		h.spans += c->lines.count + c->params.count;
+		h.tags += c->tags.count;
+	}
+	
+	string entry = entry_path(dir, s->path);
+	size_t len = strlen(entry) + 32;
+	string temp = Mem.alloc(len);
+	snprintf(temp, len, "%s.%ld.%ld.tmp", entry, (long)getpid(), 
+				__atomic_add_fetch(&TEMP_SEQ, 1, __ATOMIC_RELAXED));
+	FILE* f = fopen(temp, "wb");
+	if (!f) goto cleanup;
+	
+	//	header and records first (pool size is patched last), then spans and tags, then pool
+	fwrite(&h, sizeof(h), 1, f);
+	fwrite(s->path, 1, h.path_len, f);
+	long records = ftell(f);
+	long text = records + count * sizeof(struct cache_record) + h.spans * sizeof(span) + h.tags * sizeof(tag);
+	struct pool_s pool = { f, s, 0, StrMap.new(count * 8 + 16) };
+	
+	span* spans = Mem.alloc((h.spans ? h.spans : 1) * sizeof(span));
+	tag* tags = Mem.alloc((h.tags ? h.tags : 1) * sizeof(tag));
+	struct cache_record* recs = Mem.alloc((count ? count : 1) * sizeof(struct cache_record));
+	uint32_t next = 0;
+	uint32_t next_tag = 0;
+	fseek(f, text, SEEK_SET);
+	for (int i = 0; i < count; i++) {
+		comment c = &u->comments[i];
+		struct cache_record* r = &recs[i];
+		memset(r, 0, sizeof(*r));
+		r->signature = pool_span(&pool, c->signature);
+		r->func_name = pool_inner(&pool, c->signature, r->signature, c->func_name);
+		r->ret_type = pool_inner(&pool, c->signature, r->signature, c->ret_type);
+		r->kind = c->kind;
+		r->is_file = c->is_file;
+		r->lines = c->lines.count;
+		r->params = c->params.count;
+		r->tags = c->tags.count;
+		for (int j = 0; j < c->lines.count; j++) spans[next++] = pool_span(&pool, c->lines.items[j]);
+		for (int j = 0; j < c->params.count; j++) spans[next++] = pool_inner(&pool, c->signature, r->signature, c->params.items[j]);
+		for (int j = 0; j < c->tags.count; j++) {
+			tag t = c->tags.items[j];
+			t.name = pool_span(&pool, t.name);
+			t.arg = pool_span(&pool, t.arg);
+			tags[next_tag++] = t;
+		}
+	}
+	
+	h.pool = pool.size;
+	StrMap.free(pool.strings);
+	fseek(f, 0, SEEK_SET);
+	fwrite(&h, sizeof(h), 1, f);
+	fseek(f, records, SEEK_SET);
+	fwrite(recs, sizeof(struct cache_record), count, f);
+	fwrite(spans, sizeof(span), h.spans, f);
+	fwrite(tags, sizeof(tag), h.tags, f);
+	Mem.free(spans);
+	Mem.free(tags);
+	Mem.free(recs);
+	
+	//	a pool past SPAN_MAX cannot be viewed by the rebased spans: not cached
+	if (fclose(f) == 0 && pool.size <= SPAN_MAX && rename(temp, entry) == 0) {
+		__atomic_add_fetch(&STATS.stored, 1, __ATOMIC_RELAXED);
+	} else {
+		unlink(temp);
+	}
+	
+cleanup:
+	Mem.free(temp);
+	Mem.free(entry);
+}
+/**
+ * @brief Returns a snapshot of the process-wide counters.
+ */
+static cache_stats cache_get_stats(void) {
+	cache_stats s;
+	s.hits = __atomic_load_n(&STATS.hits, __ATOMIC_RELAXED);
+	s.rehashed = __atomic_load_n(&STATS.rehashed, __ATOMIC_RELAXED);
+	s.misses = __atomic_load_n(&STATS.misses, __ATOMIC_RELAXED);
+	s.stored = __atomic_load_n(&STATS.stored, __ATOMIC_RELAXED);
+	return s;
+}
+
+const ICache Cache = {
+	.load = cache_load,
+	.store = cache_store,
+	.stats = cache_get_stats
+};
@@ -0,0 +1,508 @@
+// decl.c
+#include "decl.h"
+#include <string.h>
+
+/* structure representing the token reader over a buffer */
+struct lexer_s {
+	const char* p;		/**< Read position */
+	const char* begin;	/**< Start of the declaration (bound for line starts) */
+	const char* end;	/**< End of the buffer */
+	int stops;			/**< Stop at blank lines, preprocessor lines and comment blocks */
+	int started;		/**< A token was read */
+};
+/* structure representing one token */
+struct token_s {
+	int type;			/**< TOK_* */
+	const char* p;		/**< First byte (line start for TOK_STOP) */
+	size_t len;			/**< Length in bytes */
+};
+
+enum { TOK_END, TOK_STOP, TOK_IDENT, TOK_PUNCT, TOK_OTHER };
+
+/*	token equals a string literal; the length is compared first */
+#define IS_WORD(t, w) ((t)->len == sizeof(w) - 1 && memcmp((t)->p, w, sizeof(w) - 1) == 0)
+/*	identifier byte: letter, digit or underscore (a macro; called per byte) */
+#define IS_IDENT(c) ((unsigned)(((c) | 0x20) - 'a') < 26 || (unsigned)((c) - '0') < 10 || (c) == '_')
+
+static const char* KIND_NAMES[] = {
+	"none", "function", "prototype", "struct", "typedef", "function pointer", "macro", "variable"
+};
+
+//	Forward declarations / Function prototypes
+static const char* decl_lex(const char*, const char*, decl*);
+static const char* decl_name(decl_kind);
+static const char* lex_macro(const char*, const char*, decl*);
+static void next_token(struct lexer_s*, struct token_s*);
+static int lex_params(struct lexer_s*, decl*, int*);
+static void lex_fnptr(struct lexer_s*, decl*, int*);
+static void skip_group(struct lexer_s*, char, char);
+static decl_view typedef_name(const struct lexer_s*);
+static const char* skip_blank(const char*, const char*);
+static const char* skip_comment(const char*, const char*);
+static const char* skip_literal(const char*, const char*);
+static const char* line_after(const char*, const char*);
+static decl_view view(const char*, const char*);
+static int is_annotation(const struct token_s*);
+
+/**
+ * @brief Lexes the declaration starting at a position.
+ * @param p Start of the text after a comment block.
+ * @param end End of the buffer.
+ * @param d Output declaration.
+ * @return Start of the line after the declaration's terminator.
+ */
+static const char* decl_lex(const char* p, const char* end, decl* d) {
+	d->kind = DECL_NONE;
+	d->text = d->name = d->type = view(NULL, NULL);
+	d->params = 0;
+
+	p = skip_blank(p, end);
+	if (p < end && *p == '#') return lex_macro(p, end, d);
+
+	struct lexer_s lx = { p, p, end, 1, 0 };
+	struct token_s t;
+	const char* start = NULL;		//	first token
+	const char* last = NULL;		//	end of the text kept so far
+	const char* type_start = NULL;	//	first token of the type ("typedef" excluded)
+	const char* params_end = NULL;	//	end of the parameter list
+	const char* resume = end;
+	struct token_s cand = { 0 };	//	latest plain identifier: the name so far
+	const char* cand_prev = NULL;	//	end of the text before cand
+	decl_view tag = view(NULL, NULL);
+	int is_typedef = 0, record = 0, want_tag = 0, fnptr = 0, inner_fn = 0;
+	int have_params = 0, plain = 0, knr = 0;
+	char term = 0;
+
+	for (;;) {
+		next_token(&lx, &t);
+		if (t.type == TOK_END || t.type == TOK_STOP) {
+			resume = t.p;
+			break;
+		}
+		if (!start) start = t.p;
+		const char* prev = last;
+
+		if (t.type == TOK_IDENT) {
+			if (is_annotation(&t)) {
+				//	__attribute__((...)) and friends: skipped, kept in the text
+				struct lexer_s peek = lx;
+				struct token_s open;
+				next_token(&peek, &open);
+				if (open.type == TOK_PUNCT && *open.p == '(') {
+					lx = peek;
+					skip_group(&lx, '(', ')');
+				}
+				last = lx.p;
+				continue;
+			}
+			if (IS_WORD(&t, "typedef") && !is_typedef) {
+				is_typedef = 1;
+				last = t.p + t.len;
+				continue;
+			}
+			if (!type_start) type_start = t.p;
+			if (!have_params && (IS_WORD(&t, "struct") || IS_WORD(&t, "union") || IS_WORD(&t, "enum"))) {
+				record = 1;
+				want_tag = 1;
+			} else if (want_tag) {
+				tag = view(t.p, t.p + t.len);
+				want_tag = 0;
+			} else {
+				//	identifiers after a list of bare names declare K&R parameters
+				if (have_params && plain && !fnptr && !is_typedef) knr = 1;
+				cand = t;
+				cand_prev = prev;
+			}
+			last = t.p + t.len;
+			continue;
+		}
+
+		if (!type_start) type_start = t.p;
+		want_tag = 0;
+		if (t.type == TOK_PUNCT) {
+			char c = *t.p;
+			if (c == '(') {
+				const char* star = lx.p;
+				while (star < end && (*star == ' ' || *star == '\t' || *star == '\r' || *star == '\n')) star++;
+				if (!have_params && !fnptr && star < end && (*star == '*' || *star == '^')) {
+					//	ret (*name)(params): the name is inside the first group
+					d->type = view(type_start, prev);
+					lex_fnptr(&lx, d, &inner_fn);
+					fnptr = 1;
+				} else if (fnptr && !have_params) {
+					if (inner_fn) {
+						skip_group(&lx, '(', ')');		//	parameters of the returned function
+					} else {
+						lex_params(&lx, d, &plain);
+					}
+					have_params = 1;
+				} else if (cand.p && (!have_params || cand.p >= params_end)) {
+					//	first list, or a later one after a macro prefix such as DEPRECATED("x")
+					d->name = view(cand.p, cand.p + cand.len);
+					d->type = view(type_start, cand_prev);
+					d->params = 0;
+					lex_params(&lx, d, &plain);
+					have_params = 1;
+					knr = 0;
+				} else {
+					skip_group(&lx, '(', ')');
+				}
+				params_end = lx.p;
+				last = lx.p;
+				continue;
+			}
+			if (c == '[') {
+				skip_group(&lx, '[', ']');
+				last = lx.p;
+				continue;
+			}
+			if (knr && (c == ';' || c == ',')) {
+				last = t.p + t.len;
+				continue;
+			}
+			if (c == '{' || c == ';' || c == '=' || c == ',' || c == '}' || c == ')' || c == ']') {
+				term = c;
+				resume = line_after(t.p, end);
+				break;
+			}
+		}
+		last = t.p + t.len;
+	}
+
+	if (!start) return resume;
+	d->text = view(start, last);
+	if (is_typedef) {
+		d->kind = DECL_TYPEDEF;
+		if (fnptr || have_params) {
+			//	name and type were set with the parameter list
+		} else if (record && term == '{') {
+			d->name = typedef_name(&lx);
+			if (!d->name.len) d->name = tag;
+		} else if (cand.p) {
+			d->name = view(cand.p, cand.p + cand.len);
+			d->type = view(type_start, cand_prev);
+		}
+	} else if (fnptr) {
+		d->kind = !inner_fn ? DECL_FNPTR : term == '{' ? DECL_FUNCTION : DECL_PROTOTYPE;
+	} else if (have_params) {
+		d->kind = term == '{' ? DECL_FUNCTION : DECL_PROTOTYPE;
+	} else if (cand.p) {
+		d->kind = DECL_VARIABLE;
+		d->name = view(cand.p, cand.p + cand.len);
+		d->type = view(type_start, cand_prev);
+	} else if (record) {
+		d->kind = DECL_STRUCT;
+		d->name = tag;
+	}
+	return resume;
+}
+/**
+ * @brief Names a declaration kind.
+ */
+static const char* decl_name(decl_kind kind) {
+	return kind <= DECL_VARIABLE ? KIND_NAMES[kind] : "unknown";
+}
+/**
+ * @brief Lexes a preprocessor line; only #define declares anything.
+ * @details The text of a function-like macro ends at its parameter list,
+ *			that of an object-like macro at the end of its logical line.
+ * @return After a #define, the line after it; any other directive is left
+ *			to the block scanner (conditionals change what it skips), so the
+ *			directive itself is returned.
+ */
+static const char* lex_macro(const char* p, const char* end, decl* d) {
+	const char* q = p + 1;
+	while (q < end && (*q == ' ' || *q == '\t')) q++;
+	if (end - q < 6 || memcmp(q, "define", 6) != 0 || (q + 6 < end && IS_IDENT(q[6]))) return p;
+
+	const char* eol = p;
+	while (eol < end && *eol != '\n') {
+		if (*eol == '\\' && eol + 1 < end && (eol[1] == '\n' || (eol[1] == '\r' && eol + 2 < end && eol[2] == '\n'))) {
+			eol += eol[1] == '\r' ? 3 : 2;		//	continued line
+			continue;
+		}
+		eol++;
+	}
+	const char* resume = eol < end ? eol + 1 : end;
+	d->text = view(p, eol);
+
+	q += 6;
+	while (q < eol && (*q == ' ' || *q == '\t')) q++;
+	const char* name = q;
+	while (q < eol && IS_IDENT(*q)) q++;
+	if (q == name) return resume;
+	d->kind = DECL_MACRO;
+	d->name = view(name, q);
+	if (q >= eol || *q != '(') return resume;
+
+	struct lexer_s lx = { q + 1, p, eol, 0, 1 };
+	int plain;
+	if (lex_params(&lx, d, &plain) == 0) d->text = view(p, lx.p);
+	return resume;
+}
+/**
+ * @brief Reads the next token, skipping whitespace, comments and literals.
+ * @details With stops set, a blank line, a preprocessor line or a "/ **"
+ *			comment yields TOK_STOP positioned at the start of its line.
+ */
+static void next_token(struct lexer_s* lx, struct token_s* t) {
+	const char* p = lx->p;
+	const char* end = lx->end;
+	const char* line = NULL;		//	start of the line p is on, after a newline
+	int newlines = 0;
+
+	for (;;) {
+		while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == '\f' || *p == '\v')) {
+			if (*p == '\n') {
+				newlines++;
+				line = p + 1;
+			}
+			p++;
+		}
+		if (p >= end) {
+			t->type = TOK_END;
+			t->p = end;
+			t->len = 0;
+			lx->p = end;
+			return;
+		}
+		if (lx->stops && lx->started && line && (newlines > 1 || *p == '#')) {
+			t->type = TOK_STOP;
+			t->p = line;
+			t->len = 0;
+			lx->p = line;
+			return;
+		}
+		if (*p != '/' || p + 1 >= end || (p[1] != '/' && p[1] != '*')) break;
+		if (lx->stops && p[1] == '*' && p + 3 < end && p[2] == '*' && p[3] != '/') {
+			const char* bol = p;
+			while (bol > lx->begin && bol[-1] != '\n') bol--;
+			t->type = TOK_STOP;
+			t->p = bol;
+			t->len = 0;
+			lx->p = bol;
+			return;
+		}
+		p = skip_comment(p, end);
+		newlines = 0;				//	a line holding a comment is not blank
+		line = NULL;
+	}
+
+	const char* q = p;
+	if (IS_IDENT(*q) && !(*q >= '0' && *q <= '9')) {
+		while (q < end && IS_IDENT(*q)) q++;
+		t->type = TOK_IDENT;
+	} else if (*q >= '0' && *q <= '9') {
+		while (q < end && (IS_IDENT(*q) || *q == '.')) q++;
+		t->type = TOK_OTHER;
+	} else if (*q == '"' || *q == '\'') {
+		q = skip_literal(q, end);
+		t->type = TOK_OTHER;
+	} else {
+		q++;
+		t->type = TOK_PUNCT;
+	}
+	t->p = p;
+	t->len = q - p;
+	lx->p = q;
+	lx->started = 1;
+}
+/**
+ * @brief Reads a parameter list after its '(' up to the matching ')'.
+ * @details Parameters are split at top-level commas; a lone `void` means none.
+ * @param lx Lexer positioned after the '('.
+ * @param d Declaration receiving the parameters.
+ * @param plain Output: 1 if every parameter is a bare identifier (K&R names).
+ * @return 0 when the list was closed, non-zero at the end of the buffer.
+ */
+static int lex_params(struct lexer_s* lx, decl* d, int* plain) {
+	//	one loop over bytes rather than tokens: lists are most of a declaration
+	const char* p = lx->p;
+	const char* end = lx->end;
+	const char* first = NULL;		//	first byte of the current parameter
+	const char* last = NULL;		//	end of its last token
+	int words = 0, other = 0, idents = 1, depth = 0, ret = 1;
+	*plain = 0;
+
+	while (p < end) {
+		char c = *p;
+		if (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v') {
+			p++;
+			continue;
+		}
+		if (c == '/' && p + 1 < end && (p[1] == '/' || p[1] == '*')) {
+			p = skip_comment(p, end);
+			continue;
+		}
+		if (depth == 0 && (c == ',' || c == ')')) {
+			if (first && d->params < DECL_MAX_PARAMS) d->param[d->params++] = view(first, last);
+			if (first && (words != 1 || other)) idents = 0;
+			first = NULL;
+			words = other = 0;
+			p++;
+			if (c == ')') {
+				ret = 0;
+				break;
+			}
+			continue;
+		}
+		if (!first) first = p;
+		if (IS_IDENT(c)) {
+			if (c >= '0' && c <= '9') other = 1; else words++;
+			while (p < end && IS_IDENT(*p)) p++;
+		} else if (c == '"' || c == '\'') {
+			p = skip_literal(p, end);
+			other = 1;
+		} else {
+			if (c == '(' || c == '[' || c == '{') depth++;
+			if ((c == ')' || c == ']' || c == '}') && depth > 0) depth--;
+			other = 1;
+			p++;
+		}
+		last = p;
+	}
+	lx->p = p;
+
+	if (d->params == 1 && d->param[0].len == 4 && memcmp(d->param[0].p, "void", 4) == 0) {
+		d->params = 0;
+	} else {
+		*plain = d->params > 0 && idents;
+	}
+	return ret;
+}
+/**
+ * @brief Reads the declarator group of a function pointer after its '('.
+ * @details Takes the first identifier as the name; a parameter list right
+ *			after it makes a function returning a function pointer.
+ * @param lx Lexer positioned after the '('.
+ * @param d Declaration receiving the name (and parameters).
+ * @param inner_fn Output: 1 for a function returning a function pointer.
+ */
+static void lex_fnptr(struct lexer_s* lx, decl* d, int* inner_fn) {
+	int stops = lx->stops;
+	lx->stops = 0;
+	struct token_s t;
+	int named = 0;
+	*inner_fn = 0;
+
+	for (next_token(lx, &t); t.type != TOK_END; next_token(lx, &t)) {
+		if (t.type == TOK_PUNCT && *t.p == ')') break;
+		if (t.type == TOK_PUNCT && *t.p == '(') {
+			int plain;
+			if (named && !*inner_fn) {
+				*inner_fn = 1;
+				lex_params(lx, d, &plain);
+			} else {
+				skip_group(lx, '(', ')');
+			}
+			continue;
+		}
+		if (t.type == TOK_PUNCT && *t.p == '[') {
+			skip_group(lx, '[', ']');
+			continue;
+		}
+		if (t.type == TOK_IDENT && !named && !is_annotation(&t) && !IS_WORD(&t, "const") &&
+		    !IS_WORD(&t, "volatile") && !IS_WORD(&t, "restrict")) {
+			d->name = view(t.p, t.p + t.len);
+			named = 1;
+		}
+	}
+	lx->stops = stops;
+}
+/**
+ * @brief Skips tokens up to the close matching an open already read.
+ */
+static void skip_group(struct lexer_s* lx, char open, char close) {
+	int stops = lx->stops;
+	lx->stops = 0;
+	struct token_s t;
+	int depth = 1;
+	for (next_token(lx, &t); t.type != TOK_END; next_token(lx, &t)) {
+		if (t.type != TOK_PUNCT) continue;
+		if (*t.p == open) depth++;
+		if (*t.p == close && --depth == 0) break;
+	}
+	lx->stops = stops;
+}
+/**
+ * @brief Finds the name after the body of `typedef struct ... { ... } name;`.
+ * @details Reads ahead on a copy of the lexer; the caller's position (just
+ *			after the '{') is unchanged so member comments are still parsed.
+ * @return The name, or an empty view if none follows the body.
+ */
+static decl_view typedef_name(const struct lexer_s* at) {
+	struct lexer_s lx = *at;
+	struct token_s t;
+	decl_view name = view(NULL, NULL);
+	skip_group(&lx, '{', '}');
+	for (next_token(&lx, &t); t.type != TOK_END; next_token(&lx, &t)) {
+		if (t.type == TOK_PUNCT && strchr(";,[(={}", *t.p)) break;
+		if (t.type == TOK_IDENT && !is_annotation(&t)) name = view(t.p, t.p + t.len);
+	}
+	return name;
+}
+/**
+ * @brief Skips whitespace and plain comments before a declaration.
+ * @return First byte of the declaration, a "/ **" opener, or end.
+ */
+static const char* skip_blank(const char* p, const char* end) {
+	for (;;) {
+		while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == '\f' || *p == '\v')) p++;
+		if (p + 1 >= end || *p != '/') return p;
+		if (p[1] != '/' && (p[1] != '*' || (p + 3 < end && p[2] == '*' && p[3] != '/'))) return p;
+		p = skip_comment(p, end);
+	}
+}
+/**
+ * @brief Skips a comment starting at p ("//" to the end of the line, or a block).
+ * @return First byte after the comment.
+ */
+static const char* skip_comment(const char* p, const char* end) {
+	if (p[1] == '/') {
+		const char* nl = memchr(p, '\n', end - p);
+		return nl ? nl : end;
+	}
+	for (p += 2; p + 1 < end; p++) {
+		if (p[0] == '*' && p[1] == '/') return p + 2;
+	}
+	return end;
+}
+/**
+ * @brief Skips a string or character literal starting at its quote.
+ * @return First byte after the literal (or its line, if unterminated).
+ */
+static const char* skip_literal(const char* p, const char* end) {
+	char quote = *p++;
+	while (p < end && *p != quote && *p != '\n') p += (*p == '\\' && p + 1 < end) ? 2 : 1;
+	return p < end && *p == quote ? p + 1 : p;
+}
+/**
+ * @brief Returns the start of the line after a position.
+ */
+static const char* line_after(const char* p, const char* end) {
+	const char* nl = memchr(p, '\n', end - p);
+	return nl ? nl + 1 : end;
+}
+/**
+ * @brief Builds a view of [p, end); empty when end is not after p.
+ */
+static decl_view view(const char* p, const char* end) {
+	decl_view v;
+	v.p = p;
+	v.len = p && end > p ? (size_t)(end - p) : 0;
+	return v;
+}
+/**
+ * @brief Tests for annotations that do not name anything: `__attribute__`,
+ *			`__declspec`, `__asm__` and `_Alignas`.
+ */
+static int is_annotation(const struct token_s* t) {
+	if (t->p[0] != '_' && t->p[0] != 'a') return 0;
+	return IS_WORD(t, "__attribute__") || IS_WORD(t, "__attribute") || IS_WORD(t, "__declspec") ||
+	       IS_WORD(t, "__asm__") || IS_WORD(t, "__asm") || IS_WORD(t, "asm") || IS_WORD(t, "_Alignas");
+}
+
+const IDecl Decl = {
+	.lex = decl_lex,
+	.name = decl_name
+};
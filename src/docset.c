@@ -0,0 +1,200 @@
+// docset.c
+#include "docset.h"
+#include "md_generator.h"
+#include "pages.h"
+#include "strmap.h"
+
+/* structure representing targets held in memory */
+struct docset_s {
+	doxy_config* config;	/**< Configuration */
+	list documents;			/**< Documents from Parser.parseTargets (units moved to the sources) */
+	list sources;			/**< docset_source entries */
+	strmap by_path;			/**< Source path -> docset_source */
+	strmap by_name;			/**< Target name -> document */
+};
+
+//	Forward declarations / Function prototypes
+static docset docset_load(doxy_config*, list);
+static void docset_free(docset);
+static list docset_documents(docset);
+static list docset_sources(docset);
+static document docset_target(docset, const char*);
+static docset_source docset_find(docset, const char*);
+static int docset_refresh(docset, docset_source);
+static int docset_write(docset, list, int*);
+static int render_source(docset_source, tmpl);
+
+/**
+ * @brief Parses the targets and indexes and renders their sources.
+ * @param config Configuration.
+ * @param names Target names, or NULL for every target except `default`.
+ * @return Set, or NULL if the targets cannot be built.
+ */
+static docset docset_load(doxy_config* config, list names) {
+	list documents = Parser.parseTargets(config, names);
+	if (!documents) return NULL;
+
+	docset set = Mem.alloc(sizeof(struct docset_s));
+	set->config = config;
+	set->documents = documents;
+	set->sources = List.new(64);
+	set->by_path = StrMap.new(64);
+	set->by_name = StrMap.new(16);
+	for (int i = 0; i < List.count(documents); i++) {
+		document d = List.getAt(documents, i);
+		StrMap.put(set->by_name, d->name, d);
+		for (int j = 0; j < List.count(d->sources); j++) {
+			string path = List.getAt(d->sources, j);
+			docset_source ds = StrMap.get(set->by_path, path);
+			if (!ds) {
+				ds = Mem.alloc(sizeof(struct docset_source_s));
+				ds->path = path;			//	held by the document
+				ds->u = NULL;
+				ds->text = NULL;
+				ds->length = 0;
+				ds->documents = List.new(4);
+				List.add(set->sources, ds);
+				StrMap.put(set->by_path, ds->path, ds);
+			}
+			if (List.indexOf(ds->documents, d) < 0) List.add(ds->documents, d);
+		}
+		for (int j = 0; j < List.count(d->units); j++) {
+			unit u = List.getAt(d->units, j);
+			docset_source ds = StrMap.get(set->by_path, u->src->path);
+			if (ds && !ds->u) {
+				u->refs++;
+				ds->u = u;
+				render_source(ds, config->layout);
+			}
+		}
+
+		//	the sources own the units from here on; documents are written from them
+		for (int j = 0; j < List.count(d->units); j++) free_unit(List.getAt(d->units, j));
+		List.clear(d->units);
+	}
+	return set;
+}
+/**
+ * @brief Releases a set, its documents and units.
+ */
+static void docset_free(docset set) {
+	if (!set) return;
+	for (int i = 0; i < List.count(set->sources); i++) {
+		docset_source ds = List.getAt(set->sources, i);
+		free_unit(ds->u);
+		if (ds->text) Mem.free(ds->text);
+		List.free(ds->documents);
+		Mem.free(ds);
+	}
+	List.free(set->sources);
+	StrMap.free(set->by_path);
+	StrMap.free(set->by_name);
+	Parser.releaseDocuments(set->documents);
+	Mem.free(set);
+}
+/**
+ * @brief Returns the documents, in the order requested.
+ */
+static list docset_documents(docset set) {
+	return set->documents;
+}
+/**
+ * @brief Returns the sources, each once.
+ */
+static list docset_sources(docset set) {
+	return set->sources;
+}
+/**
+ * @brief Finds a document by target name.
+ */
+static document docset_target(docset set, const char* name) {
+	return StrMap.get(set->by_name, name);
+}
+/**
+ * @brief Finds a source by path, as written in the targets.
+ */
+static docset_source docset_find(docset set, const char* path) {
+	return StrMap.get(set->by_path, path);
+}
+/**
+ * @brief Re-parses a source and renders it again; on failure the old unit
+ *			and text are kept.
+ * @return 0 on success, non-zero if the source could not be parsed.
+ */
+static int docset_refresh(docset set, docset_source ds) {
+	unit u = NULL;
+	if (Parser.parseFile(set->config, ds->path, &u) != 0) return 1;
+	free_unit(ds->u);
+	ds->u = u;
+	return render_source(ds, set->config->layout);
+}
+/**
+ * @brief Writes documents from the rendered text of their sources; a split
+ *			document is written as pages from the units, where unchanged pages
+ *			are left alone.
+ * @param failed Output, may be NULL: per document, non-zero if writing failed.
+ * @return 0 on success, non-zero if any document failed.
+ */
+static int docset_write(docset set, list documents, int* failed) {
+	doxy_config* config = set->config;
+	int ret = 0;
+	for (int i = 0; i < List.count(documents); i++) {
+		document d = List.getAt(documents, i);
+		sink out = d->split ? NULL : Sink.open(d->output);
+		int error = !d->split && !out;
+		if (d->split) {
+			list units = List.new(List.count(d->sources) + 1);
+			for (int j = 0; j < List.count(d->sources); j++) {
+				docset_source ds = StrMap.get(set->by_path, List.getAt(d->sources, j));
+				if (ds && ds->u && ds->u->count > 0) List.add(units, ds->u);
+			}
+			error = Pages.write(units, d->output, config->layout, config->jobs, NULL) != 0;
+			List.free(units);
+		} else if (out) {
+			MDGenerator.begin(out, d->output, config->layout);
+			for (int j = 0; j < List.count(d->sources); j++) {
+				docset_source ds = StrMap.get(set->by_path, List.getAt(d->sources, j));
+				if (ds && ds->text) Sink.write(out, ds->text, ds->length);
+			}
+			MDGenerator.end(out, d->output, config->layout);
+			error = Sink.close(out) != 0;
+		}
+		if (failed) failed[i] = error;
+		if (error) ret = 1;
+	}
+	return ret;
+}
+/**
+ * @brief Renders a source's unit into its cached markdown text.
+ * @param ds Source to render.
+ * @param layout Compiled template, or NULL.
+ * @return 0 on success, non-zero on failure.
+ */
+static int render_source(docset_source ds, tmpl layout) {
+	if (ds->text) Mem.free(ds->text);
+	ds->text = NULL;
+	ds->length = 0;
+	if (!ds->u || ds->u->count == 0) return 0;
+
+	string_builder sb = StringBuilder.new(4096);
+	sink out = Sink.toBuilder(sb);
+	if (out) {
+		MDGenerator.render(out, ds->u, NULL, layout);
+		Sink.close(out);
+	}
+	ds->text = StringBuilder.toString(sb);
+	ds->length = ds->text ? strlen(ds->text) : 0;
+	StringBuilder.free(sb);
+	return ds->text ? 0 : 1;
+}
+
+const IDocSet DocSet = {
+	.load = docset_load,
+	.free = docset_free,
+	.documents = docset_documents,
+	.sources = docset_sources,
+	.target = docset_target,
+	.find = docset_find,
+	.refresh = docset_refresh,
+	.write = docset_write
+};
@@ -0,0 +1,186 @@
+// doxy.c
+#include "doxy.h"
+#include "md_generator.h"
+#include "template.h"
+#include "pages.h"
+
+/* structure representing a library context */
+struct doxy_ctx_s {
+	doxy_config config;		/**< Copy of the caller's configuration; strings, lists and layout are owned */
+};
+
+//	Forward declarations / Function prototypes
+static doxy_ctx doxy_new(const doxy_config*);
+static void doxy_free(doxy_ctx);
+static doxy_config* doxy_get_config(doxy_ctx);
+static list doxy_resolve(doxy_ctx, list);
+static list doxy_parse(doxy_ctx, list);
+static int doxy_stream(doxy_ctx, document, unit_fn, object);
+static int doxy_render(doxy_ctx, document, const output_format*, sink);
+static int doxy_write(doxy_ctx, document, int*);
+static void doxy_release(list);
+static string copy_string(const char*);
+
+/**
+ * @brief Creates a context from a copy of a configuration.
+ * @param config Configuration to copy.
+ * @return Context, or NULL if the template cannot be loaded.
+ */
+static doxy_ctx doxy_new(const doxy_config* config) {
+	if (!config) return NULL;
+
+	doxy_ctx ctx = Mem.alloc(sizeof(struct doxy_ctx_s));
+	if (!ctx) return NULL;
+	ctx->config = *config;
+	ctx->config.file = copy_string(config->file);
+	ctx->config.output = copy_string(config->output);
+	ctx->config.target = copy_string(config->target);
+	ctx->config.template = copy_string(config->template);
+	ctx->config.cache_dir = copy_string(config->cache_dir);
+	ctx->config.sources = NULL;
+	ctx->config.formats = NULL;
+	ctx->config.layout = NULL;
+	if (config->sources) {
+		ctx->config.sources = List.new(List.count(config->sources) + 1);
+		for (int i = 0; i < List.count(config->sources); i++) {
+			List.add(ctx->config.sources, copy_string(List.getAt(config->sources, i)));
+		}
+	}
+	if (config->formats) {
+		//	formats are static descriptors; only the list is copied
+		ctx->config.formats = List.new(FORMATS_MAX);
+		for (int i = 0; i < List.count(config->formats); i++) {
+			List.add(ctx->config.formats, List.getAt(config->formats, i));
+		}
+	}
+
+	//	compiled once; every document of the context is rendered with it
+	if (ctx->config.template && !(ctx->config.layout = Template.load(ctx->config.template))) {
+		doxy_free(ctx);
+		return NULL;
+	}
+	return ctx;
+}
+/**
+ * @brief Frees a context, its configuration copy and template.
+ * @param ctx Context, or NULL.
+ */
+static void doxy_free(doxy_ctx ctx) {
+	if (!ctx) return;
+	doxy_config* config = &ctx->config;
+	if (config->sources) {
+		for (int i = 0; i < List.count(config->sources); i++) {
+			Mem.free(List.getAt(config->sources, i));
+		}
+		List.free(config->sources);
+	}
+	if (config->formats) List.free(config->formats);
+	Template.free(config->layout);
+	if (config->file) Mem.free(config->file);
+	if (config->output) Mem.free(config->output);
+	if (config->target) Mem.free(config->target);
+	if (config->template) Mem.free(config->template);
+	if (config->cache_dir) Mem.free(config->cache_dir);
+	Mem.free(ctx);
+}
+/**
+ * @brief Returns the context's configuration.
+ */
+static doxy_config* doxy_get_config(doxy_ctx ctx) {
+	return &ctx->config;
+}
+/**
+ * @brief Resolves targets into documents without parsing.
+ */
+static list doxy_resolve(doxy_ctx ctx, list names) {
+	return ctx ? Parser.resolveTargets(&ctx->config, names) : NULL;
+}
+/**
+ * @brief Parses targets into documents sharing their units.
+ */
+static list doxy_parse(doxy_ctx ctx, list names) {
+	return ctx ? Parser.parseTargets(&ctx->config, names) : NULL;
+}
+/**
+ * @brief Streams a resolved document's units to a callback.
+ */
+static int doxy_stream(doxy_ctx ctx, document d, unit_fn emit, object arg) {
+	if (!ctx || !d || !emit) return 1;
+	return Parser.streamDocument(&ctx->config, d, emit, arg);
+}
+/**
+ * @brief Renders a document into a sink in one format.
+ * @param ctx Context (template).
+ * @param d Document with units.
+ * @param f Format, or NULL for markdown.
+ * @param out Sink to write to; left open.
+ * @return 0 on success, non-zero on failure.
+ */
+static int doxy_render(doxy_ctx ctx, document d, const output_format* f, sink out) {
+	if (!ctx || !d || !out) return 1;
+
+	const IGenerator* gen = f ? f->gen : &MDGenerator;
+	tmpl t = gen == &MDGenerator ? ctx->config.layout : NULL;
+	string path = Formats.path(d->output, f);
+	gen->begin(out, path, t);
+	for (int i = 0; i < List.count(d->units); i++) {
+		gen->render(out, List.getAt(d->units, i), d->symbols, t);
+	}
+	gen->end(out, path, t);
+	Mem.free(path);
+	return 0;
+}
+/**
+ * @brief Writes a document's files in every configured format, or its pages.
+ * @details Pages are markdown with document-local anchors, so other formats
+ *			and links are refused for split documents.
+ * @param ctx Context (formats, links, template, workers).
+ * @param d Document with units.
+ * @param failed Output, may be NULL: per format, non-zero if writing failed.
+ * @return 0 on success, non-zero on failure.
+ */
+static int doxy_write(doxy_ctx ctx, document d, int* failed) {
+	if (!ctx || !d) return 1;
+	doxy_config* config = &ctx->config;
+	if (!d->split) return Formats.writeAll(config->formats, d->units, d->output, d->symbols, config->layout, failed);
+
+	int ret = 1;
+	if (config->links || (config->formats && (List.count(config->formats) > 1 ||
+			((const output_format*)List.getAt(config->formats, 0))->gen != &MDGenerator))) {
+		fprintf(stderr, "Error: target '%s' uses outmode=split, which writes markdown pages only (no --links or --format)\n", d->name);
+	} else {
+		int pages = 0;
+		ret = Pages.write(d->units, d->output, config->layout, config->jobs, &pages);
+		if (config->is_debug) printf("Wrote %d pages\n", pages);
+	}
+	if (failed) failed[0] = ret;
+	return ret;
+}
+/**
+ * @brief Releases documents and their shared units.
+ */
+static void doxy_release(list documents) {
+	Parser.releaseDocuments(documents);
+}
+/**
+ * @brief Copies a string.
+ * @return Allocated copy, or NULL for NULL.
+ */
+static string copy_string(const char* str) {
+	if (!str) return NULL;
+	string copy = Mem.alloc(strlen(str) + 1);
+	if (copy) strcpy(copy, str);
+	return copy;
+}
+
+const IDoxy Doxy = {
+	.new = doxy_new,
+	.free = doxy_free,
+	.config = doxy_get_config,
+	.resolve = doxy_resolve,
+	.parse = doxy_parse,
+	.stream = doxy_stream,
+	.render = doxy_render,
+	.write = doxy_write,
+	.release = doxy_release
+};
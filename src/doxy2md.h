@@ -2,12 +2,22 @@
 #ifndef DOXY2MD_H
 #define DOXY2MD_H
 
+#include "doxy.h"
 #include "md_generator.h"
 #include "writer.h"
+#include "watch.h"
+#include "serve.h"
+#include "stats.h"
+#include "cache.h"
+#include "symbols.h"
+#include "template.h"
+#include "formats.h"
+#include "pages.h"
 
 #include <sigcore.h>
 
-const string VERSION = "1.0";
+const string VERSION = DOXY2MD_VERSION;
+const string CACHE_DIR = ".doxy2md-cache";
 
 #endif // DOXY2MD_H
 
@@ -0,0 +1,134 @@
+// formats.c
+#include "formats.h"
+#include "json_generator.h"
+#include "html_generator.h"
+#include <pthread.h>
+#include <string.h>
+
+static const output_format FORMATS[FORMATS_MAX] = {
+	{ "md", "markdown", ".md", &MDGenerator },
+	{ "json", "JSON", ".json", &JSONGenerator },
+	{ "html", "HTML", ".html", &HTMLGenerator }
+};
+
+/* structure representing one format being written */
+struct format_job_s {
+	const output_format* f;		/**< Format to write */
+	list units;					/**< Units of the document (shared, read only) */
+	string path;				/**< Output path of the format */
+	symtab st;					/**< Symbol index, or NULL */
+	tmpl t;						/**< Template (markdown only) */
+	int ret;					/**< writeFile result */
+	pthread_t thread;
+	int started;				/**< 1 if running on its own thread */
+};
+
+//	Forward declarations / Function prototypes
+static list formats_parse(const string);
+static string formats_path(const string, const output_format*);
+static int formats_write_all(list, list, const string, symtab, tmpl, int*);
+static void* format_worker(void*);
+
+/**
+ * @brief Parses a comma-separated format list.
+ * @param spec Format names (e.g. "md,json").
+ * @return List of formats, or NULL after printing an error.
+ */
+static list formats_parse(const string spec) {
+	list formats = List.new(FORMATS_MAX);
+	const char* p = spec;
+	while (*p) {
+		const char* comma = strchr(p, ',');
+		size_t len = comma ? (size_t)(comma - p) : strlen(p);
+		const output_format* found = NULL;
+		for (int i = 0; i < FORMATS_MAX && len; i++) {
+			if (strlen(FORMATS[i].name) == len && memcmp(FORMATS[i].name, p, len) == 0) found = &FORMATS[i];
+		}
+		if (len && !found) {
+			fprintf(stderr, "Error: unknown format '%.*s' (md, json, html)\n", (int)len, p);
+			List.free(formats);
+			return NULL;
+		}
+		if (found && List.indexOf(formats, (object)found) < 0) List.add(formats, (object)found);
+		p += len + (comma ? 1 : 0);
+	}
+	if (List.count(formats) == 0) {
+		fprintf(stderr, "Error: no output format given\n");
+		List.free(formats);
+		return NULL;
+	}
+	return formats;
+}
+/**
+ * @brief Builds the output path of a format.
+ * @param output Document output path.
+ * @param f Format, or NULL for markdown.
+ * @return Allocated path.
+ */
+static string formats_path(const string output, const output_format* f) {
+	size_t len = strlen(output);
+	if (!f || f->gen == &MDGenerator) {
+		string path = Mem.alloc(len + 1);
+		strcpy(path, output);
+		return path;
+	}
+	if (len > 3 && strcmp(output + len - 3, ".md") == 0) len -= 3;
+	size_t ext = strlen(f->ext);
+	string path = Mem.alloc(len + ext + 1);
+	memcpy(path, output, len);
+	memcpy(path + len, f->ext, ext + 1);
+	return path;
+}
+/**
+ * @brief Writes a document in every format; the first on the calling thread.
+ * @return 0 if every format was written, non-zero otherwise.
+ */
+static int formats_write_all(list formats, list units, const string output, symtab st, tmpl t, int* failed) {
+	struct format_job_s jobs[FORMATS_MAX];
+	int count = formats ? List.count(formats) : 1;
+	if (count > FORMATS_MAX) count = FORMATS_MAX;
+	for (int i = 0; i < count; i++) {
+		struct format_job_s* job = &jobs[i];
+		job->f = formats ? List.getAt(formats, i) : &FORMATS[0];
+		job->units = units;
+		job->path = formats_path(output, job->f);
+		job->st = st;
+		job->t = job->f->gen == &MDGenerator ? t : NULL;
+		job->ret = 1;
+		job->started = 0;
+	}
+	//	the extra formats run beside the first; one that cannot start runs inline
+	for (int i = 1; i < count; i++) {
+		jobs[i].started = pthread_create(&jobs[i].thread, NULL, format_worker, &jobs[i]) == 0;
+	}
+	format_worker(&jobs[0]);
+
+	int ret = 0;
+	for (int i = 0; i < count; i++) {
+		if (i > 0 && jobs[i].started) {
+			pthread_join(jobs[i].thread, NULL);
+		} else if (i > 0) {
+			format_worker(&jobs[i]);
+		}
+		if (failed) failed[i] = jobs[i].ret;
+		if (jobs[i].ret != 0) ret = 1;
+		Mem.free(jobs[i].path);
+	}
+	return ret;
+}
+/**
+ * @brief Writes one format of a document.
+ * @param arg The format_job_s to run.
+ * @return NULL.
+ */
+static void* format_worker(void* arg) {
+	struct format_job_s* job = arg;
+	job->ret = job->f->gen->writeFile(job->units, job->path, job->st, job->t);
+	return NULL;
+}
+
+const IFormats Formats = {
+	.parse = formats_parse,
+	.path = formats_path,
+	.writeAll = formats_write_all
+};
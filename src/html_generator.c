@@ -0,0 +1,234 @@
+// html_generator.c
+#include "html_generator.h"
+#include "stats.h"
+#include "symbols.h"
+
+//	Forward declarations / Function prototypes
+static void html_comment(sink, symtab, comment);
+static void html_lines(sink, symtab, comment, const tag*, const char*);
+static void html_text(sink, symtab, comment, const char*, size_t);
+static void html_escape(sink, const char*, size_t);
+
+/**
+ * @brief Writes text escaped for HTML.
+ */
+static void html_escape(sink out, const char* p, size_t len) {
+	const char* end = p + len;
+	const char* run = p;
+	for (; p < end; p++) {
+		const char* esc = *p == '<' ? "&lt;" : *p == '>' ? "&gt;" : *p == '&' ? "&amp;" : *p == '"' ? "&quot;" : NULL;
+		if (!esc) continue;
+		Sink.write(out, run, p - run);
+		Sink.append(out, esc);
+		run = p + 1;
+	}
+	Sink.write(out, run, end - run);
+}
+/**
+ * @brief Writes escaped text, linking names of other symbols to their sections.
+ * @param out Sink to write to.
+ * @param st Symbol index, or NULL to write the text as is.
+ * @param c Comment the text belongs to (its own name is not linked).
+ * @param p Text.
+ * @param len Length of the text.
+ */
+static void html_text(sink out, symtab st, comment c, const char* p, size_t len) {
+	const char* end = p + len;
+	const char* run = p;
+	const char* at;
+	symbol* s;
+	while (st && (s = Symbols.next(st, &p, end, &at))) {
+		if (s->c == c) continue;
+		html_escape(out, run, at - run);
+		Sink.appendf(out, "<a href=\"#%.*s\">%.*s</a>", (int)s->length, s->name, (int)s->length, s->name);
+		run = p;
+	}
+	html_escape(out, run, end - run);
+}
+/**
+ * @brief Writes the lines of a section.
+ * @param sep Separator written between lines.
+ */
+static void html_lines(sink out, symtab st, comment c, const tag* t, const char* sep) {
+	for (int i = 0; i < t->count; i++) {
+		span line = c->lines.items[t->first + i];
+		if (i > 0) Sink.append(out, sep);
+		html_text(out, st, c, SPAN_PTR(c->src, line), line.length);
+	}
+}
+/**
+ * @brief Appends one comment as an HTML section.
+ * @param out Sink to write to.
+ * @param st Symbol index for ids and links, or NULL.
+ * @param c Comment to format.
+ */
+static void html_comment(sink out, symtab st, comment c) {
+	const tag* brief = NULL;		//	the last @brief wins
+	int details = 0, params = 0, see = 0;
+	for (int i = 0; i < c->tags.count; i++) {
+		const tag* t = &c->tags.items[i];
+		if (t->kind == TAG_BRIEF && t->count) brief = t;
+		if (t->kind == TAG_DETAILS) details += t->count;
+		if (t->kind == TAG_PARAM) params++;
+		if (t->kind == TAG_SEE) see += t->count;
+	}
+	symbol* self = Symbols.of(st, c);
+
+	if (self) {
+		Sink.appendf(out, "<section id=\"%.*s\">\n", (int)self->length, self->name);
+	} else {
+		Sink.append(out, "<section>\n");
+	}
+	if (c->is_file) {
+		Sink.append(out, "<h4>File: ");
+		html_escape(out, c->src->path, strlen(c->src->path));
+		Sink.append(out, "</h4>\n");
+	} else if (c->func_name.length) {
+		Sink.append(out, "<h4>");
+		html_escape(out, SPAN_PTR(c->src, c->func_name), c->func_name.length);
+		Sink.append(out, "</h4>\n");
+	}
+	if (brief) {
+		Sink.append(out, "<p>");
+		html_lines(out, st, c, brief, "\n");
+		Sink.append(out, "</p>\n");
+	}
+	if (details > 0) {
+		Sink.append(out, "<p>");
+		int first = 1;
+		for (int i = 0; i < c->tags.count; i++) {
+			const tag* t = &c->tags.items[i];
+			if (t->kind != TAG_DETAILS || t->count == 0) continue;
+			if (!first) Sink.append(out, "\n");
+			html_lines(out, st, c, t, "\n");
+			first = 0;
+		}
+		Sink.append(out, "</p>\n");
+	}
+	if (params > 0) {
+		Sink.append(out, "<dl>\n");
+		for (int i = 0; i < c->tags.count; i++) {
+			const tag* t = &c->tags.items[i];
+			if (t->kind != TAG_PARAM) continue;
+			Sink.append(out, "<dt><code>");
+			html_escape(out, SPAN_PTR(c->src, t->arg), t->arg.length);
+			Sink.append(out, "</code>");
+			if (t->dir) Sink.append(out, t->dir == (PARAM_IN | PARAM_OUT) ? " [in,out]" : t->dir == PARAM_IN ? " [in]" : " [out]");
+			Sink.append(out, "</dt><dd>");
+			html_lines(out, st, c, t, " ");
+			Sink.append(out, "</dd>\n");
+		}
+		Sink.append(out, "</dl>\n");
+	}
+	for (int i = 0; i < c->tags.count; i++) {
+		const tag* t = &c->tags.items[i];
+		if (t->kind != TAG_RETURN || t->count == 0) continue;
+		Sink.append(out, "<p><strong>Returns:</strong> ");
+		html_lines(out, st, c, t, " ");
+		Sink.append(out, "</p>\n");
+	}
+	if (see > 0) {
+		Sink.append(out, "<p><strong>See also:</strong> ");
+		int first = 1;
+		for (int i = 0; i < c->tags.count; i++) {
+			const tag* t = &c->tags.items[i];
+			if (t->kind != TAG_SEE || t->count == 0) continue;
+			if (!first) Sink.append(out, ", ");
+			html_lines(out, st, c, t, " ");
+			first = 0;
+		}
+		Sink.append(out, "</p>\n");
+	}
+	if (c->signature.length) {
+		Sink.append(out, "<pre><code>");
+		html_text(out, st, c, SPAN_PTR(c->src, c->signature), c->signature.length);
+		Sink.append(out, "</code></pre>\n");
+	}
+	if (self && self->ref_count > 0) {
+		Sink.append(out, "<p><strong>Referenced by:</strong> ");
+		for (int i = 0; i < self->ref_count; i++) {
+			symbol* r = self->refs[i];
+			Sink.appendf(out, "%s<a href=\"#%.*s\">%.*s</a>", i ? ", " : "", (int)r->length, r->name, (int)r->length, r->name);
+		}
+		Sink.append(out, "</p>\n");
+	}
+	Sink.append(out, "</section>\n");
+}
+
+/**
+ * @brief Writes the head of the page.
+ * @param out Sink to write to.
+ * @param path Output path; the title is its file name without the extension.
+ * @param t Template (unused).
+ */
+static void html_begin(sink out, const string path, tmpl t) {
+	const char* base = path ? strrchr(path, '/') : NULL;
+	base = base ? base + 1 : path ? path : "";
+	const char* dot = strrchr(base, '.');
+	Sink.append(out, "<!DOCTYPE html>\n<html>\n<head>\n<meta charset=\"utf-8\">\n<title>");
+	html_escape(out, base, dot && dot > base ? (size_t)(dot - base) : strlen(base));
+	Sink.append(out, "</title>\n</head>\n<body>\n");
+}
+/**
+ * @brief Writes the end of the page.
+ */
+static void html_end(sink out, const string path, tmpl t) {
+	Sink.append(out, "</body>\n</html>\n");
+}
+/**
+ * @brief Renders the comments of one source unit.
+ * @param out Sink to write to.
+ * @param u Unit to render.
+ * @param st Symbol index of the document, or NULL.
+ * @param t Template (unused).
+ */
+static void html_render(sink out, unit u, symtab st, tmpl t) {
+	long begin = Stats.now();
+	for (int j = 0; j < u->count; j++) {
+		html_comment(out, st, &u->comments[j]);
+	}
+	Stats.span("generate", u->src->path, begin);
+}
+/**
+ * @brief Renders a whole page into a StringBuilder.
+ * @param sb StringBuilder to append to.
+ * @param units Units in source order.
+ * @param st Symbol index, or NULL.
+ * @param t Template (unused).
+ */
+static void html_generate(string_builder sb, list units, symtab st, tmpl t) {
+	sink out = Sink.toBuilder(sb);
+	if (!out) return;
+	html_begin(out, NULL, t);
+	for (int i = 0; i < List.count(units); i++) {
+		html_render(out, List.getAt(units, i), st, t);
+	}
+	html_end(out, NULL, t);
+	Sink.close(out);
+}
+/**
+ * @brief Renders a page straight to a file through a sink.
+ * @param units Units in source order.
+ * @param path Output file path.
+ * @param st Symbol index, or NULL.
+ * @param t Template (unused).
+ * @return 0 on success, non-zero on failure.
+ */
+static int html_write_file(list units, const string path, symtab st, tmpl t) {
+	sink out = Sink.open(path);
+	if (!out) return 1;
+	html_begin(out, path, t);
+	for (int i = 0; i < List.count(units); i++) {
+		html_render(out, List.getAt(units, i), st, t);
+	}
+	html_end(out, path, t);
+	return Sink.close(out);
+}
+
+const IGenerator HTMLGenerator = {
+    .generate = html_generate,
+    .render = html_render,
+    .writeFile = html_write_file,
+    .begin = html_begin,
+    .end = html_end
+};
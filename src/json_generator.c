@@ -0,0 +1,202 @@
+// json_generator.c
+#include "json_generator.h"
+#include "stats.h"
+#include "symbols.h"
+#include "decl.h"
+
+/*	opening of every document; a comment after more than this is preceded by a comma */
+static const char JSON_HEAD[] = "{\n\"comments\": [";
+
+/*	byte copied into a JSON string as it is: not a control, '"' or '\\' */
+#define JSON_PLAIN(ch) ((unsigned char)(ch) >= 0x20 && (ch) != '"' && (ch) != '\\')
+
+static const char* TAG_NAMES[] = {
+	"none", "brief", "details", "param", "tparam", "return", "retval", "throws", "note",
+	"warning", "see", "author", "since", "version", "deprecated", "todo", "pre", "post", "file"
+};
+
+//	Forward declarations / Function prototypes
+static void json_comment(sink, symtab, comment);
+static void json_escape(sink, const char*, size_t);
+static void json_string(sink, const char*, size_t);
+
+/**
+ * @brief Writes bytes escaped for a JSON string (UTF-8 passes through).
+ * @param out Sink to write to.
+ * @param p Bytes.
+ * @param len Number of bytes.
+ */
+static void json_escape(sink out, const char* p, size_t len) {
+	static const char HEX[] = "0123456789abcdef";
+	const char* end = p + len;
+	const char* run = p;
+	for (; p < end; p++) {
+		unsigned char ch = *p;
+		if (JSON_PLAIN(ch)) continue;
+		Sink.write(out, run, p - run);
+		run = p + 1;
+		switch (ch) {
+			case '"': Sink.write(out, "\\\"", 2); break;
+			case '\\': Sink.write(out, "\\\\", 2); break;
+			case '\n': Sink.write(out, "\\n", 2); break;
+			case '\t': Sink.write(out, "\\t", 2); break;
+			case '\r': Sink.write(out, "\\r", 2); break;
+			default: {
+				char esc[6] = { '\\', 'u', '0', '0', HEX[ch >> 4], HEX[ch & 15] };
+				Sink.write(out, esc, 6);
+			}
+		}
+	}
+	Sink.write(out, run, end - run);
+}
+/**
+ * @brief Writes bytes as a quoted JSON string.
+ */
+static void json_string(sink out, const char* p, size_t len) {
+	Sink.write(out, "\"", 1);
+	json_escape(out, p, len);
+	Sink.write(out, "\"", 1);
+}
+/**
+ * @brief Appends one comment as a JSON object.
+ * @param out Sink to write to.
+ * @param st Symbol index for the referenced-by list, or NULL.
+ * @param c Comment to write.
+ */
+static void json_comment(sink out, symtab st, comment c) {
+	Sink.append(out, "{\"file\": ");
+	json_string(out, c->src->path, strlen(c->src->path));
+	Sink.append(out, c->is_file ? ", \"is_file\": true, \"kind\": \"" : ", \"is_file\": false, \"kind\": \"");
+	if (c->kind != DECL_NONE) Sink.append(out, Decl.name(c->kind));
+	Sink.append(out, "\", \"name\": ");
+	json_string(out, SPAN_PTR(c->src, c->func_name), c->func_name.length);
+	Sink.append(out, ", \"type\": ");
+	json_string(out, SPAN_PTR(c->src, c->ret_type), c->ret_type.length);
+	Sink.append(out, ", \"signature\": ");
+	json_string(out, SPAN_PTR(c->src, c->signature), c->signature.length);
+
+	Sink.append(out, ", \"params\": [");
+	for (int i = 0; i < c->params.count; i++) {
+		span sp = c->params.items[i];
+		if (i) Sink.write(out, ", ", 2);
+		json_string(out, SPAN_PTR(c->src, sp), sp.length);
+	}
+	Sink.append(out, "], \"sections\": [");
+	for (int i = 0; i < c->tags.count; i++) {
+		const tag* t = &c->tags.items[i];
+		Sink.append(out, i ? ", {\"tag\": \"" : "{\"tag\": \"");
+		Sink.append(out, TAG_NAMES[t->kind]);
+		Sink.write(out, "\"", 1);
+		if (t->arg.length) {
+			Sink.append(out, ", \"arg\": ");
+			json_string(out, SPAN_PTR(c->src, t->arg), t->arg.length);
+		}
+		if (t->dir) {
+			Sink.append(out, t->dir == (PARAM_IN | PARAM_OUT) ? ", \"dir\": \"in,out\"" : t->dir == PARAM_IN ? ", \"dir\": \"in\"" : ", \"dir\": \"out\"");
+		}
+		//	the section's lines as one string
+		Sink.append(out, ", \"text\": \"");
+		for (int j = 0; j < t->count; j++) {
+			span line = c->lines.items[t->first + j];
+			if (j) Sink.write(out, "\\n", 2);
+			json_escape(out, SPAN_PTR(c->src, line), line.length);
+		}
+		Sink.append(out, "\"}");
+	}
+	Sink.append(out, "]");
+
+	symbol* self = Symbols.of(st, c);
+	if (self) {
+		Sink.append(out, ", \"referenced_by\": [");
+		for (int i = 0; i < self->ref_count; i++) {
+			if (i) Sink.write(out, ", ", 2);
+			json_string(out, self->refs[i]->name, self->refs[i]->length);
+		}
+		Sink.append(out, "]");
+	}
+	Sink.append(out, "}");
+}
+
+/**
+ * @brief Writes the opening of a document.
+ * @param out Sink to write to.
+ * @param path Output path (unused; the title is written at the end).
+ * @param t Template (unused).
+ */
+static void json_begin(sink out, const string path, tmpl t) {
+	Sink.write(out, JSON_HEAD, sizeof(JSON_HEAD) - 1);
+}
+/**
+ * @brief Writes the end of a document and its title.
+ * @param out Sink to write to.
+ * @param path Output path; the title is its file name without the extension.
+ * @param t Template (unused).
+ */
+static void json_end(sink out, const string path, tmpl t) {
+	Sink.append(out, "\n],\n\"title\": ");
+	const char* base = path ? strrchr(path, '/') : NULL;
+	base = base ? base + 1 : path ? path : "";
+	const char* dot = strrchr(base, '.');
+	json_string(out, base, dot && dot > base ? (size_t)(dot - base) : strlen(base));
+	Sink.append(out, "\n}\n");
+}
+/**
+ * @brief Renders the comments of one source unit as array elements.
+ * @details Streamed units share one array: an element is preceded by a comma
+ *			unless only the document's opening has been written.
+ * @param out Sink to write to, opened with json_begin.
+ * @param u Unit to render.
+ * @param st Symbol index of the document, or NULL.
+ * @param t Template (unused).
+ */
+static void json_render(sink out, unit u, symtab st, tmpl t) {
+	long begin = Stats.now();
+	for (int j = 0; j < u->count; j++) {
+		Sink.append(out, Sink.length(out) > sizeof(JSON_HEAD) - 1 ? ",\n" : "\n");
+		json_comment(out, st, &u->comments[j]);
+	}
+	Stats.span("generate", u->src->path, begin);
+}
+/**
+ * @brief Renders a whole document into a StringBuilder.
+ * @param sb StringBuilder to append to.
+ * @param units Units in source order.
+ * @param st Symbol index, or NULL.
+ * @param t Template (unused).
+ */
+static void json_generate(string_builder sb, list units, symtab st, tmpl t) {
+	sink out = Sink.toBuilder(sb);
+	if (!out) return;
+	json_begin(out, NULL, t);
+	for (int i = 0; i < List.count(units); i++) {
+		json_render(out, List.getAt(units, i), st, t);
+	}
+	json_end(out, NULL, t);
+	Sink.close(out);
+}
+/**
+ * @brief Renders a document straight to a file through a sink.
+ * @param units Units in source order.
+ * @param path Output file path.
+ * @param st Symbol index, or NULL.
+ * @param t Template (unused).
+ * @return 0 on success, non-zero on failure.
+ */
+static int json_write_file(list units, const string path, symtab st, tmpl t) {
+	sink out = Sink.open(path);
+	if (!out) return 1;
+	json_begin(out, path, t);
+	for (int i = 0; i < List.count(units); i++) {
+		json_render(out, List.getAt(units, i), st, t);
+	}
+	json_end(out, path, t);
+	return Sink.close(out);
+}
+
+const IGenerator JSONGenerator = {
+    .generate = json_generate,
+    .render = json_render,
+    .writeFile = json_write_file,
+    .begin = json_begin,
+    .end = json_end
+};
@@ -0,0 +1,176 @@
+// lines.c
+#define _POSIX_C_SOURCE 200809L
+#include "lines.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* structure representing a line reader over a mapping or a stream */
+struct line_reader_s {
+	source src;			/**< Mapped source, or NULL when streaming */
+	const char* cursor;	/**< Mapped: next unread byte */
+	const char* end;	/**< Mapped: end of the mapping */
+	int fd;				/**< Streaming: descriptor, -1 when mapped */
+	char* block;		/**< Streaming: reused buffer */
+	size_t size;		/**< Streaming: capacity of block */
+	size_t start;		/**< Streaming: first unread byte in block */
+	size_t fill;		/**< Streaming: bytes read into block */
+	int eof;			/**< Streaming: the descriptor is exhausted */
+	int failed;			/**< Set after a read or allocation failure */
+	long line;			/**< Lines handed out */
+};
+
+//	Forward declarations / Function prototypes
+static line_reader lines_open(const string);
+static line_reader lines_from_source(source);
+static const char* lines_next(line_reader, size_t*);
+static const char* stream_next(line_reader, size_t*);
+static int refill(line_reader);
+static long lines_number(line_reader);
+static int lines_error(line_reader);
+static void lines_close(line_reader);
+
+/**
+ * @brief Opens a file: regular files are mapped, anything else is streamed.
+ * @return Reader, or NULL if the file cannot be opened.
+ */
+static line_reader lines_open(const string path) {
+	struct stat st;
+	if (stat(path, &st) == 0 && S_ISREG(st.st_mode)) {
+		source s = Source.open(path);
+		if (!s) return NULL;
+		line_reader r = lines_from_source(s);
+		Source.release(s);		//	the reader holds its own reference
+		return r;
+	}
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) return NULL;
+	line_reader r = Mem.alloc(sizeof(struct line_reader_s));
+	char* block = r ? Mem.alloc(LINE_BLOCK) : NULL;
+	if (!block) {
+		if (r) Mem.free(r);
+		close(fd);
+		return NULL;
+	}
+	memset(r, 0, sizeof(struct line_reader_s));
+	r->fd = fd;
+	r->block = block;
+	r->size = LINE_BLOCK;
+	return r;
+}
+/**
+ * @brief Reads the lines of a mapped source in place.
+ * @return Reader, or NULL on failure.
+ */
+static line_reader lines_from_source(source s) {
+	line_reader r = Mem.alloc(sizeof(struct line_reader_s));
+	if (!r) return NULL;
+	memset(r, 0, sizeof(struct line_reader_s));
+	r->src = Source.retain(s);
+	r->cursor = s->data;
+	r->end = s->data + s->size;
+	r->fd = -1;
+	return r;
+}
+/**
+ * @brief Returns the next line as a view into the mapping or the block.
+ */
+static const char* lines_next(line_reader r, size_t* len) {
+	if (r->fd >= 0) return stream_next(r, len);
+
+	const char* p = r->cursor;
+	if (p >= r->end) return NULL;
+	const char* nl = memchr(p, '\n', r->end - p);
+	*len = (nl ? nl : r->end) - p;
+	r->cursor = nl ? nl + 1 : r->end;
+	r->line++;
+	return p;
+}
+/**
+ * @brief Returns the next line of a stream, reading blocks as needed.
+ * @details A partial line at the end of the block is moved to the front
+ *			before the next read; the block doubles only when the partial line
+ *			already fills it.
+ */
+static const char* stream_next(line_reader r, size_t* len) {
+	for (;;) {
+		char* p = r->block + r->start;
+		size_t avail = r->fill - r->start;
+		char* nl = memchr(p, '\n', avail);
+		if (nl || (r->eof && avail)) {
+			*len = nl ? (size_t)(nl - p) : avail;
+			r->start += *len + (nl ? 1 : 0);
+			r->line++;
+			return p;
+		}
+		if (r->eof || r->failed || refill(r) != 0) return NULL;
+	}
+}
+/**
+ * @brief Makes room after the unread bytes and reads more of the stream.
+ * @return 0 on success (including end of stream), non-zero on failure.
+ */
+static int refill(line_reader r) {
+	size_t avail = r->fill - r->start;
+	if (r->start > 0) {
+		memmove(r->block, r->block + r->start, avail);
+		r->start = 0;
+		r->fill = avail;
+	} else if (r->fill == r->size) {
+		char* grown = Mem.alloc(r->size * 2);
+		if (!grown) {
+			r->failed = 1;
+			return 1;
+		}
+		memcpy(grown, r->block, r->fill);
+		Mem.free(r->block);
+		r->block = grown;
+		r->size *= 2;
+	}
+
+	ssize_t n;
+	do {
+		n = read(r->fd, r->block + r->fill, r->size - r->fill);
+	} while (n < 0 && errno == EINTR);
+	if (n < 0) {
+		r->failed = 1;
+		return 1;
+	}
+	if (n == 0) r->eof = 1;
+	r->fill += n;
+	return 0;
+}
+/**
+ * @brief Returns the number of the last line handed out.
+ */
+static long lines_number(line_reader r) {
+	return r->line;
+}
+/**
+ * @brief Tests whether reading stopped on an error.
+ */
+static int lines_error(line_reader r) {
+	return r->failed;
+}
+/**
+ * @brief Closes a reader and releases its mapping or block.
+ */
+static void lines_close(line_reader r) {
+	if (!r) return;
+	if (r->src) Source.release(r->src);
+	if (r->fd >= 0) close(r->fd);
+	if (r->block) Mem.free(r->block);
+	Mem.free(r);
+}
+
+const ILines Lines = {
+	.open = lines_open,
+	.fromSource = lines_from_source,
+	.next = lines_next,
+	.number = lines_number,
+	.error = lines_error,
+	.close = lines_close
+};
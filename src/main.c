@@ -11,22 +11,62 @@
 #include "doxy2md.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
 
-static int run_doxy(const string, int, string, string*);
+/* structure representing a document being streamed to its output */
+struct emit_ctx_s {
+	doxy_config* config;	/**< Configuration of the context */
+	sink out;				/**< Output sink, opened with the first unit */
+	int files;				/**< Units rendered */
+	list units;				/**< The document's units when held for linking, extra formats or pages, else NULL */
+	document d;				/**< Document being streamed */
+};
+
+static int run_doxy(doxy_ctx);
+static int emit_unit(unit, object);
+static sink open_output(struct emit_ctx_s*);
+static int write_document(doxy_ctx, document, int);
+static void print_memory(void);
+static void print_output(void);
+static void print_cache(doxy_config*);
+static int run_targets(doxy_ctx, list);
+static list split_targets(const string);
+static string join_args(int, string*);
 
 // Main
 /**
  * @brief Main entry for the `doxy` command 
- * @detail `<target>` to specify target configuration
+ * @detail `<target>` to specify target configuration; `a,b,c` builds several targets
+ *			  `--all` build every target (except `default`), parsing shared sources once
+ *			  `--watch` keep running and regenerate targets as their sources change
+ *			  `--serve <socket>` keep the targets in memory and answer requests on a socket
+ *			  `--connect <socket> <request...>` send one request to a server and print the answer
  *			  `-o <output.md>` to override target configuration
+ *			  `-j <jobs>` number of parse workers (default: online CPUs)
+ *			  `--no-cache` parse every source, ignoring the parse cache
+ *			  `--cache-stats` print parse cache hits and misses
+ *			  `--stats` print stage times, per-file comment counts and memory at exit
+ *			  `--trace <out.json>` write a Chrome trace of every stage and file
+ *			  `--links` link symbol names to their documentation; list references
+ *			  `--template <file>` render comments with an output template
+ *			  `--format md,json,html` output formats, written concurrently from one parse
  *			  `<config_file>` optional configuration
  * @return 0 on SUCCESS; otherwise non-0;
  */
 int main(int argc, string* argv) {
-	string config_file = "Doxy2MD";
+	doxy_config config = {
+		.file = "Doxy2MD",
+		.target = "default",
+		.cache_dir = CACHE_DIR
+	};
+	doxy_ctx ctx = NULL;
 	string output_file = NULL;
-	string target = "default";
-	int is_debug = 0;
+	string trace_file = NULL;
+	string serve_path = NULL;
+	int is_stats = 0;
+	int is_all = 0;
+	int is_watch = 0;
 	int ret = 0;
 	// **
 	//	assumptions:
@@ -40,7 +80,62 @@ int main(int argc, string* argv) {
 			printf("doxy2md version=%s\n", VERSION);
 			goto exit;
 		} else if (strcmp(argv[i], "--debug") == 0) {
-			is_debug = 1;
+			config.is_debug = 1;
+		} else if (strcmp(argv[i], "--all") == 0) {
+			is_all = 1;
+		} else if (strcmp(argv[i], "--watch") == 0) {
+			is_watch = 1;
+		} else if (strcmp(argv[i], "--serve") == 0) {
+			if (++i >= argc) {
+				fprintf(stderr, "Error: '--serve' requires a socket path\n");
+				ret = 1;
+				goto cleanup;
+			}
+			serve_path = argv[i];
+		} else if (strcmp(argv[i], "--connect") == 0) {
+			//	everything after the socket is the request
+			if (i + 2 >= argc) {
+				fprintf(stderr, "Error: '--connect' requires a socket path and a request\n");
+				ret = 1;
+				goto cleanup;
+			}
+			string request = join_args(argc - i - 2, argv + i + 2);
+			ret = Serve.request(argv[i + 1], request);
+			Mem.free(request);
+			goto exit;
+		} else if (strcmp(argv[i], "--no-cache") == 0) {
+			config.cache_dir = NULL;
+		} else if (strcmp(argv[i], "--cache-stats") == 0) {
+			config.cache_stats = 1;
+		} else if (strcmp(argv[i], "--links") == 0) {
+			config.links = 1;
+		} else if (strcmp(argv[i], "--stats") == 0) {
+			is_stats = 1;
+		} else if (strcmp(argv[i], "--trace") == 0) {
+			if (++i >= argc) {
+				fprintf(stderr, "Error: '--trace' requires an output file\n");
+				ret = 1;
+				goto cleanup;
+			}
+			trace_file = argv[i];
+		} else if (strcmp(argv[i], "--template") == 0) {
+			if (++i >= argc) {
+				fprintf(stderr, "Error: '--template' requires a template file\n");
+				ret = 1;
+				goto cleanup;
+			}
+			config.template = argv[i];
+		} else if (strcmp(argv[i], "--format") == 0) {
+			if (++i >= argc) {
+				fprintf(stderr, "Error: '--format' requires a format list\n");
+				ret = 1;
+				goto cleanup;
+			}
+			if (config.formats) List.free(config.formats);
+			if (!(config.formats = Formats.parse(argv[i]))) {
+				ret = 1;
+				goto cleanup;
+			}
 		} else if (strcmp(argv[i], "-o") == 0) {
 			if (++i >= argc) {
 				fprintf(stderr, "Error: '-o' requires an output file\n");
@@ -48,11 +143,17 @@ int main(int argc, string* argv) {
 				goto cleanup;
 			}
 			output_file = argv[i];
+		} else if (strcmp(argv[i], "-j") == 0) {
+			if (++i >= argc || (config.jobs = atoi(argv[i])) < 1) {
+				fprintf(stderr, "Error: '-j' requires a positive job count\n");
+				ret = 1;
+				goto cleanup;
+			}
 		} else if (argv[i][0] != '-') { // Positional arg
-			if (strcmp(target, "default") == 0) { 		// First positional is target
-				target = argv[i];
+			if (strcmp(config.target, "default") == 0) { 		// First positional is target
+				config.target = argv[i];
 			} else { // Last positional is config_file
-				config_file = argv[i];
+				config.file = argv[i];
 			}
 		} else {
 			fprintf(stderr, "Error: Unknown flag '%s'\n", argv[i]);
@@ -61,62 +162,280 @@ int main(int argc, string* argv) {
 		}
 		i++;
 	}	
+	Stats.start(is_stats, trace_file);
+	
+	if (is_all && strcmp(config.target, "default") != 0) {
+		//	with --all the only positional is the config file
+		config.file = config.target;
+	}
+	//	the context copies the configuration and compiles the template once
+	config.output = output_file;
+	if (!(ctx = Doxy.new(&config))) {
+		ret = 1;
+		goto cleanup;
+	}
+	
+	//	several targets: one parse, one document per target
+	if (is_all || is_watch || serve_path || strchr(config.target, ',')) {
+		int resident = is_watch || serve_path;
+		if (is_watch && serve_path) {
+			fprintf(stderr, "Error: '--watch' cannot be used with --serve\n");
+			ret = 1;
+			goto cleanup;
+		}
+		if (resident && config.links) {
+			//	watch and serve modes cache each source's text for every target that shares it
+			fprintf(stderr, "Error: '--links' cannot be used with --watch or --serve\n");
+			ret = 1;
+			goto cleanup;
+		}
+		if (resident && config.formats && (List.count(config.formats) > 1 ||
+				((const output_format*)List.getAt(config.formats, 0))->gen != &MDGenerator)) {
+			fprintf(stderr, "Error: '--format' cannot be used with --watch or --serve\n");
+			ret = 1;
+			goto cleanup;
+		}
+		if (output_file) {
+			fprintf(stderr, "Error: '-o' cannot be used with several targets, --watch or --serve\n");
+			ret = 1;
+			goto cleanup;
+		}
+		//	a server without targets serves them all
+		int every = is_all || (serve_path && strcmp(config.target, "default") == 0);
+		list names = every ? NULL : split_targets(config.target);
+		if (serve_path) {
+			ret = Serve.run(Doxy.config(ctx), names, serve_path);
+		} else {
+			ret = is_watch ? Watch.run(Doxy.config(ctx), names) : run_targets(ctx, names);
+		}
+		if (names) {
+			for (int n = 0; n < List.count(names); n++) Mem.free(List.getAt(names, n));
+			List.free(names);
+		}
+		print_cache(Doxy.config(ctx));
+		goto exit;
+	}
 	
 	//	run doxy
-	ret = run_doxy(config_file, is_debug, target, &output_file);
+	ret = run_doxy(ctx);
+	goto exit;
 	
 cleanup:
 	printf("Document '%s' generated [%s]\n", output_file, ret ? "FALSE" : "TRUE");
 exit:
+	Doxy.free(ctx);
+	if (config.formats) List.free(config.formats);
+	if (Stats.finish() != 0) ret = 1;
 	return ret;
 }
 
-static int run_doxy(const string config_file, int is_debug, string target, string* output_file) {
-	int ret = 0;
-	
-	doxy_config* config = Mem.alloc(sizeof(doxy_config));
-	if (!config) {
-		fprintf(stderr, "Memory allocation failed.\n");
-		return 1;
-	}
-	
-	config->is_debug = is_debug;
-	config->file = config_file;
-	config->output = *output_file;
-	config->target = target;
+/**
+ * @brief Generates the configured target, rendering each source as soon as
+ *			it is parsed.
+ * @param ctx Context.
+ * @return 0 on success, non-zero on failure.
+ */
+static int run_doxy(doxy_ctx ctx) {
+	doxy_config* config = Doxy.config(ctx);
+	int is_debug = config->is_debug;
 	
 	printf("Configuration='%s'\n", config->file);
 	if (is_debug) printf("Output='%s'\n", config->output ? config->output : "DEFAULT");
 	if (is_debug) printf("Target='%s'\n", config->target ? config->target : "DEFAULT");
 	
-	list comments = Parser.parseDoxy(config);
-	if (is_debug) printf("Parsed %d comments\n", List.count(comments));
-	
-	string_builder sb = StringBuilder.new(1024);
-	MDGenerator.generate(sb, comments, NULL); // No template yet
+	list names = List.new(1);
+	List.add(names, config->target);
+	list documents = Doxy.resolve(ctx, names);
+	List.free(names);
+	if (documents && List.count(documents) == 0) printf("Configuration '%s' was empty\n", config->file);
+	document d = documents && List.count(documents) > 0 ? List.getAt(documents, 0) : NULL;
+	string output = d ? d->output : config->output;
 	
-	string genMD = StringBuilder.toString(sb);
-	if (FileWriter.write(genMD, config->output) == 0) {
-		printf("Generated markdown to %s\n", config->output);
+	//	links, extra formats and pages need every unit first; they are kept in the document
+	int hold = d && (d->split || config->links || config->formats);
+	struct emit_ctx_s emit = { config, NULL, 0, hold ? d->units : NULL, d };
+	int ret = d ? Doxy.stream(ctx, d, emit_unit, &emit) : 1;
+	if (is_debug) printf("Parsed %d files\n", emit.files);
+	if (emit.units) {
+		if (ret == 0 && config->links && !d->split && !(d->symbols = Symbols.build(d->units))) ret = 1;
+		if (is_debug && d->symbols) printf("Indexed %d symbols\n", Symbols.count(d->symbols));
+		if (ret == 0) ret = write_document(ctx, d, 0);
 	} else {
-		printf("Failed to generate markdown to file (%s)\n", *output_file);
+		if (ret == 0 && !emit.out) open_output(&emit);
+		if (ret == 0 && emit.out) {
+			MDGenerator.end(emit.out, output, config->layout);
+			size_t bytes = Sink.length(emit.out);
+			ret = Sink.close(emit.out);
+			if (ret == 0) printf("Generated markdown to %s\n", output);
+			if (ret == 0 && is_debug) printf("Wrote %zu bytes\n", bytes);
+		} else {
+			Sink.abort(emit.out);
+			ret = 1;
+		}
+		if (ret != 0) printf("Failed to generate markdown to file (%s)\n", output);
 	}
+	print_output();
+	print_cache(config);
+	
+	if (is_debug) print_memory();
 	
-	*output_file = Mem.alloc(strlen(config->output) + 1);
-	strcpy(*output_file, config->output);	
+	printf("Document '%s' generated [%s]\n", output, ret ? "FALSE" : "TRUE");
+	Doxy.release(documents);
+	return ret;
+}
+
+/**
+ * @brief Generates several targets from a single parse.
+ * @param ctx Context.
+ * @param names Target names, or NULL for all targets.
+ * @return 0 on success, non-zero if any document failed.
+ */
+static int run_targets(doxy_ctx ctx, list names) {
+	doxy_config* config = Doxy.config(ctx);
+	int ret = 0;
+	printf("Configuration='%s'\n", config->file);
 	
-	Mem.free(genMD);
-	Mem.free(config);
-	StringBuilder.free(sb);
+	list documents = Doxy.parse(ctx, names);
+	if (!documents) return 1;
+	if (List.count(documents) == 0) {
+		printf("Configuration '%s' was empty\n", config->file);
+		ret = 1;
+	}
+	if (names && List.count(documents) < List.count(names)) ret = 1;
 	
-	//	clean up comments list
-	iterator it = Array.getIterator(comments, LIST);
-	while (Iterator.hasNext(it)) {
-		free_comment(Iterator.next(it));
+	for (int i = 0; i < List.count(documents); i++) {
+		document d = List.getAt(documents, i);
+		if (config->is_debug) printf("Target='%s' (%d files)\n", d->name, List.count(d->units));
+		if (write_document(ctx, d, 1) != 0) ret = 1;
 	}
-	Iterator.free(it);
-	List.free(comments);
+	print_output();
+	
+	Doxy.release(documents);
+	
+	if (config->is_debug) print_memory();
 	
 	return ret;
 }
-
+/**
+ * @brief Splits a comma-separated target list.
+ * @param spec Target list (e.g. "sigcore,parser").
+ * @return List of allocated names (caller frees).
+ */
+static list split_targets(const string spec) {
+	list names = List.new(4);
+	const char* p = spec;
+	while (*p) {
+		const char* comma = strchr(p, ',');
+		size_t len = comma ? (size_t)(comma - p) : strlen(p);
+		if (len > 0) {
+			string name = Mem.alloc(len + 1);
+			memcpy(name, p, len);
+			name[len] = '\0';
+			List.add(names, name);
+		}
+		p += len + (comma ? 1 : 0);
+	}
+	return names;
+}
+/**
+ * @brief Joins arguments with single spaces.
+ * @param count Number of arguments.
+ * @param args Arguments.
+ * @return Allocated string (caller frees).
+ */
+static string join_args(int count, string* args) {
+	size_t len = 0;
+	for (int i = 0; i < count; i++) len += strlen(args[i]) + 1;
+	string joined = Mem.alloc(len + 1);
+	joined[0] = '\0';
+	for (int i = 0; i < count; i++) {
+		if (i > 0) strcat(joined, " ");
+		strcat(joined, args[i]);
+	}
+	return joined;
+}
+/**
+ * @brief Renders a parsed unit into the document's sink, or holds it for
+ *			linking.
+ * @param u Unit with comments.
+ * @param ctx The emit_ctx_s of the document.
+ * @return 0 on success, non-zero if the output cannot be opened.
+ */
+static int emit_unit(unit u, object ctx) {
+	struct emit_ctx_s* emit = ctx;
+	if (emit->units) {
+		u->refs++;				//	rendered once every symbol is known
+		List.add(emit->units, u);
+		emit->files++;
+		return 0;
+	}
+	if (!emit->out && !open_output(emit)) return 1;
+	
+	MDGenerator.render(emit->out, u, NULL, emit->config->layout);
+	emit->files++;
+	return 0;
+}
+/**
+ * @brief Opens the document's output and writes the template header.
+ * @param emit Document being streamed.
+ * @return Sink, or NULL if the output cannot be opened.
+ */
+static sink open_output(struct emit_ctx_s* emit) {
+	emit->out = Sink.open(emit->d->output);
+	if (emit->out) MDGenerator.begin(emit->out, emit->d->output, emit->config->layout);
+	return emit->out;
+}
+/**
+ * @brief Writes a document in each output format, concurrently, or as pages,
+ *			and reports every file.
+ * @param ctx Context (formats, template).
+ * @param d Document with units.
+ * @param as_document 1 to report as "Document ... generated", else as "Generated ... to".
+ * @return 0 on success, non-zero if any file failed.
+ */
+static int write_document(doxy_ctx ctx, document d, int as_document) {
+	doxy_config* config = Doxy.config(ctx);
+	int failed[FORMATS_MAX];
+	int count = config->formats && !d->split ? List.count(config->formats) : 1;
+	for (int i = 0; i < count; i++) failed[i] = 1;
+	int ret = Doxy.write(ctx, d, failed);
+	for (int i = 0; i < count; i++) {
+		const output_format* f = config->formats && !d->split ? List.getAt(config->formats, i) : NULL;
+		string path = Formats.path(d->output, f);
+		if (as_document) {
+			printf("Document '%s' generated [%s]\n", path, failed[i] ? "FALSE" : "TRUE");
+		} else {
+			printf("%s %s to %s\n", failed[i] ? "Failed to generate" : "Generated", f ? f->label : "markdown", path);
+		}
+		Mem.free(path);
+	}
+	return ret;
+}
+/**
+ * @brief Prints memory high-water marks: parse results (arena) and process RSS.
+ */
+static void print_memory(void) {
+	arena_stats st = Arena.stats();
+	printf("Arena: %ld arenas, %ld blocks, %ld allocations, peak %zu bytes\n", 
+			st.arenas, st.blocks, st.allocs, st.peak);
+	
+	struct rusage ru;
+	if (getrusage(RUSAGE_SELF, &ru) == 0) printf("Peak RSS: %ld KB\n", ru.ru_maxrss);
+}
+/**
+ * @brief Prints the parse cache's hits and misses (--cache-stats or --debug).
+ * @param config Configuration.
+ */
+static void print_cache(doxy_config* config) {
+	if (!config->cache_dir || !(config->cache_stats || config->is_debug)) return;
+	cache_stats st = Cache.stats();
+	printf("Cache: %ld hits (%ld rehashed), %ld misses, %ld stored\n", 
+			st.hits, st.rehashed, st.misses, st.stored);
+}
+/**
+ * @brief Prints how many output files were written and how many were unchanged.
+ */
+static void print_output(void) {
+	writer_stats st = FileWriter.stats();
+	printf("Output: %ld written, %ld unchanged\n", st.written, st.skipped);
+}
@@ -1,31 +1,444 @@
 // md_generator.c
 #include "md_generator.h"
+#include "stats.h"
+#include "symbols.h"
+#include "decl.h"
 
-static void md_generate(string_builder sb, list comments, const string template) {
-	iterator it = Array.getIterator(comments, LIST);
-	while (Iterator.hasNext(it)) {
-		comment c = Iterator.next(it);
-		//	minimal rendering for now -- to be expanced
-		if (c->brief) {
-			if (c->is_file) {
-				StringBuilder.appendf(sb, "#### File: %s\n", c->filename);
-			} else {
-				StringBuilder.appendf(sb, "#### %s\n", c->func_name ? c->func_name : "File");
+/*	printf arguments for "%.*s" of a comment span */
+#define SPAN_ARGS(c, sp) (int)(sp).length, SPAN_PTR((c)->src, sp)
+
+/* structure representing what a template instruction can read */
+struct tm_ctx_s {
+	symtab st;			/**< Symbol index for links, or NULL */
+	comment c;			/**< Comment rendered; NULL in a header or footer */
+	symbol* self;		/**< Symbol of the comment, or NULL */
+	const char* title;	/**< Document title (header and footer) */
+	size_t title_len;
+	tmpl_field list;	/**< List of the open loop */
+	tag_kind tag;		/**< Tag kind of a TL_TAG loop */
+	int item;			/**< Current item: tag, parameter or referrer index */
+	int next;			/**< Next item, or -1 on the last */
+	int first;			/**< 1 on the first item */
+};
+
+//	Forward declarations / Function prototypes
+static void md_text(sink, symtab, comment, const char*, size_t);
+static void md_html(sink, const char*, size_t);
+static void md_template(sink, struct tm_ctx_s*, const tmpl_op*, int);
+static int tm_field(sink, const struct tm_ctx_s*, const tmpl_op*);
+static int tm_next(const struct tm_ctx_s*, const tmpl_op*, int);
+static int tm_write(sink, const char*, size_t);
+static void md_frame(sink, const string, tmpl, tmpl_part);
+
+/**
+ * @brief Writes the lines of a section, one per line.
+ * @param out Sink to write to.
+ * @param st Symbol index for links, or NULL.
+ * @param c Comment owning the lines.
+ * @param t Section to write.
+ * @param first 1 if nothing was written before this section.
+ * @param sep Separator written between lines.
+ */
+static void md_lines(sink out, symtab st, comment c, const tag* t, int first, const char* sep) {
+	for (int i = 0; i < t->count; i++) {
+		span line = c->lines.items[t->first + i];
+		if (!first || i > 0) Sink.append(out, sep);
+		md_text(out, st, c, SPAN_PTR(c->src, line), line.length);
+	}
+}
+/**
+ * @brief Writes comment text, linking names of other symbols to their anchors.
+ * @param out Sink to write to.
+ * @param st Symbol index, or NULL to write the text as is.
+ * @param c Comment the text belongs to (its own name is not linked).
+ * @param p Text.
+ * @param len Length of the text.
+ */
+static void md_text(sink out, symtab st, comment c, const char* p, size_t len) {
+	const char* end = p + len;
+	const char* run = p;
+	const char* at;
+	symbol* s;
+	while (st && (s = Symbols.next(st, &p, end, &at))) {
+		if (s->c == c) continue;
+		Sink.write(out, run, at - run);
+		Sink.appendf(out, "[%.*s](#%.*s)", (int)s->length, s->name, (int)s->length, s->name);
+		run = p;
+	}
+	Sink.write(out, run, end - run);
+}
+/**
+ * @brief Writes a signature as HTML with its symbol names linked; used
+ *			instead of a code fence, where links would show as text.
+ * @return 1 if written, 0 if the signature names no other symbol.
+ */
+static int md_signature_links(sink out, symtab st, comment c) {
+	const char* p = SPAN_PTR(c->src, c->signature);
+	const char* end = p + c->signature.length;
+	const char* scan = p;
+	const char* at;
+	symbol* s;
+	while ((s = Symbols.next(st, &scan, end, &at)) && s->c == c);
+	if (!s) return 0;
+	
+	Sink.append(out, "<pre><code>");
+	const char* run = p;
+	for (scan = p; (s = Symbols.next(st, &scan, end, &at)); ) {
+		if (s->c == c) continue;
+		md_html(out, run, at - run);
+		Sink.appendf(out, "<a href=\"#%.*s\">%.*s</a>", (int)s->length, s->name, (int)s->length, s->name);
+		run = scan;
+	}
+	md_html(out, run, end - run);
+	Sink.append(out, "</code></pre>\n\n");
+	return 1;
+}
+/**
+ * @brief Writes text escaped for HTML.
+ */
+static void md_html(sink out, const char* p, size_t len) {
+	const char* end = p + len;
+	const char* run = p;
+	for (; p < end; p++) {
+		const char* esc = *p == '<' ? "&lt;" : *p == '>' ? "&gt;" : *p == '&' ? "&amp;" : NULL;
+		if (!esc) continue;
+		Sink.write(out, run, p - run);
+		Sink.append(out, esc);
+		run = p + 1;
+	}
+	Sink.write(out, run, end - run);
+}
+/**
+ * @brief Appends one comment in Markdown format.
+ * @param out Sink to write to.
+ * @param st Symbol index for anchors and links, or NULL.
+ * @param c Comment to format.
+ */
+static void md_comment(sink out, symtab st, comment c) {
+	//	minimal rendering for now -- to be expanced
+	const tag* brief = NULL;		//	the last @brief wins
+	int details = 0, see = 0;
+	for (int i = 0; i < c->tags.count; i++) {
+		const tag* t = &c->tags.items[i];
+		if (t->kind == TAG_BRIEF && t->count) brief = t;
+		if (t->kind == TAG_DETAILS) details += t->count;
+		if (t->kind == TAG_SEE) see += t->count;
+	}
+	symbol* self = Symbols.of(st, c);
+	
+	if (brief || self) {
+		if (c->is_file) {
+			Sink.appendf(out, "#### File: %s\n", c->src->path);
+		} else if (self) {
+			//	the anchor sits in the heading: an HTML line of its own would swallow it
+			Sink.appendf(out, "#### <a id=\"%.*s\"></a>%.*s\n", (int)self->length, self->name, (int)self->length, self->name);
+		} else if (c->func_name.length) {
+			Sink.appendf(out, "#### %.*s\n", SPAN_ARGS(c, c->func_name));
+		} else {
+			Sink.append(out, "#### File\n");
+		}
+		if (brief) {
+			md_lines(out, st, c, brief, 1, "\n");
+			Sink.append(out, "\n\n");
+		}
+	}
+	if (details > 0) {
+		int first = 1;
+		for (int i = 0; i < c->tags.count; i++) {
+			const tag* t = &c->tags.items[i];
+			if (t->kind != TAG_DETAILS || t->count == 0) continue;
+			md_lines(out, st, c, t, first, "\n");
+			first = 0;
+		}
+		Sink.append(out, "\n\n");
+	}
+	if (see > 0) {
+		Sink.append(out, "**See also:** ");
+		int first = 1;
+		for (int i = 0; i < c->tags.count; i++) {
+			const tag* t = &c->tags.items[i];
+			if (t->kind != TAG_SEE || t->count == 0) continue;
+			if (!first) Sink.append(out, ", ");
+			md_lines(out, st, c, t, 1, " ");
+			first = 0;
+		}
+		Sink.append(out, "\n\n");
+	}
+	if (c->signature.length && !(st && md_signature_links(out, st, c))) {
+		Sink.appendf(out, "``` c\n%.*s\n```  \n", SPAN_ARGS(c, c->signature));
+	}
+	if (self && self->ref_count > 0) {
+		Sink.append(out, "**Referenced by:** ");
+		for (int i = 0; i < self->ref_count; i++) {
+			symbol* r = self->refs[i];
+			Sink.appendf(out, "%s[%.*s](#%.*s)", i ? ", " : "", (int)r->length, r->name, (int)r->length, r->name);
+		}
+		Sink.append(out, "\n\n");
+	}
+}
+
+/**
+ * @brief Runs template instructions for a comment or a document frame.
+ * @details Literals are copied as they are; sections and loops are jumps
+ *			resolved when the template was compiled.
+ * @param out Sink to write to.
+ * @param x Values the instructions read; the loop state is updated.
+ * @param ops Instructions.
+ * @param count Number of instructions.
+ */
+static void md_template(sink out, struct tm_ctx_s* x, const tmpl_op* ops, int count) {
+	for (int pc = 0; pc < count; pc++) {
+		const tmpl_op* op = &ops[pc];
+		switch (op->op) {
+			case TOP_TEXT:
+				Sink.write(out, op->text, op->len);
+				break;
+			case TOP_FIELD:
+				tm_field(out, x, op);
+				break;
+			case TOP_SECTION:
+				if (!tm_field(NULL, x, op)) pc = op->jump;
+				break;
+			case TOP_INVERTED:
+				if (op->field >= TL_TAG ? tm_next(x, op, -1) >= 0 : tm_field(NULL, x, op)) pc = op->jump;
+				break;
+			case TOP_LOOP:
+				x->list = op->field;
+				x->tag = op->tag;
+				x->item = tm_next(x, op, -1);
+				if (x->item < 0) {
+					pc = op->jump;
+					break;
+				}
+				x->next = tm_next(x, op, x->item);
+				x->first = 1;
+				break;
+			case TOP_END:
+				if (op->field < TL_TAG || ops[op->jump].op != TOP_LOOP || x->next < 0) break;
+				x->item = x->next;
+				x->next = tm_next(x, &ops[op->jump], x->item);
+				x->first = 0;
+				pc = op->jump;
+				break;
+		}
+	}
+}
+/**
+ * @brief Writes a field, or tests it when out is NULL.
+ * @param out Sink to write to, or NULL to test only.
+ * @param x Values to read.
+ * @param op Instruction naming the field.
+ * @return 1 if the field is not empty.
+ */
+static int tm_field(sink out, const struct tm_ctx_s* x, const tmpl_op* op) {
+	comment c = x->c;
+	switch (op->field) {
+		case TF_NAME:
+			return tm_write(out, SPAN_PTR(c->src, c->func_name), c->func_name.length);
+		case TF_FILE:
+			return tm_write(out, c->src->path, strlen(c->src->path));
+		case TF_KIND:
+			if (c->kind == DECL_NONE) return 0;
+			return tm_write(out, Decl.name(c->kind), strlen(Decl.name(c->kind)));
+		case TF_TYPE:
+			return tm_write(out, SPAN_PTR(c->src, c->ret_type), c->ret_type.length);
+		case TF_SIGNATURE:
+			return tm_write(out, SPAN_PTR(c->src, c->signature), c->signature.length);
+		case TF_IS_FILE:
+			return c->is_file;
+		case TF_TITLE:
+			return tm_write(out, x->title, x->title_len);
+		case TF_TAG: {
+			const tag* brief = NULL;		//	the last @brief wins
+			int found = 0;
+			for (int i = 0; i < c->tags.count; i++) {
+				const tag* t = &c->tags.items[i];
+				if (t->kind != op->tag || t->count == 0) continue;
+				if (op->tag == TAG_BRIEF) {
+					brief = t;
+					continue;
+				}
+				if (!out) return 1;
+				md_lines(out, x->st, c, t, !found, "\n");
+				found = 1;
 			}
-			StringBuilder.appendf(sb, "%s\n\n", c->brief);
+			if (brief && out) md_lines(out, x->st, c, brief, 1, "\n");
+			return found || brief;
 		}
-		if (StringBuilder.length(c->details) > 0) {
-			string details = StringBuilder.toString(c->details);
-			StringBuilder.appendf(sb, "%s\n\n", details);
-			Mem.free(details);
+		case TF_ITEM_NAME:
+			if (x->list == TL_TAG) {
+				span arg = c->tags.items[x->item].arg;
+				return tm_write(out, SPAN_PTR(c->src, arg), arg.length);
+			}
+			if (x->list == TL_REFS) {
+				symbol* r = x->self->refs[x->item];
+				return tm_write(out, r->name, r->length);
+			}
+			{
+				//	a declaration parameter is named by its last identifier
+				span sp = c->params.items[x->item];
+				const char* p = SPAN_PTR(c->src, sp);
+				const char* e = p + sp.length;
+				while (e > p && e[-1] == ']') {
+					while (e > p && e[-1] != '[') e--;
+					if (e > p) e--;
+				}
+				const char* b = e;
+				while (b > p && (b[-1] == '_' || (unsigned)((b[-1] | 0x20) - 'a') < 26 || (unsigned)(b[-1] - '0') < 10)) b--;
+				return tm_write(out, b, e - b);
+			}
+		case TF_ITEM_TEXT:
+			if (x->list == TL_TAG) {
+				const tag* t = &c->tags.items[x->item];
+				if (out) md_lines(out, x->st, c, t, 1, " ");
+				return t->count > 0;
+			}
+			if (x->list == TL_ARGS) {
+				span sp = c->params.items[x->item];
+				return tm_write(out, SPAN_PTR(c->src, sp), sp.length);
+			}
+			return 0;
+		case TF_ITEM_DIR: {
+			int dir = x->list == TL_TAG ? c->tags.items[x->item].dir : 0;
+			const char* name = dir == (PARAM_IN | PARAM_OUT) ? "in,out" : dir == PARAM_IN ? "in" : dir == PARAM_OUT ? "out" : "";
+			return tm_write(out, name, strlen(name));
 		}
-		if (c->signature && strlen(trim(c->signature)) > 0) {
-			StringBuilder.appendf(sb, "``` c\n%s\n```  \n", c->signature);
+		case TF_FIRST:
+			return x->first;
+		case TF_LAST:
+			return x->next < 0;
+		default:
+			return 0;
+	}
+}
+/**
+ * @brief Finds the item after another in the list a loop instruction names.
+ * @param x Values to read.
+ * @param op TOP_LOOP or TOP_INVERTED instruction.
+ * @param after Item to start after, or -1 for the first.
+ * @return Item index, or -1 if there is none.
+ */
+static int tm_next(const struct tm_ctx_s* x, const tmpl_op* op, int after) {
+	comment c = x->c;
+	switch (op->field) {
+		case TL_TAG:
+			for (int i = after + 1; i < c->tags.count; i++) {
+				if (c->tags.items[i].kind == op->tag) return i;
+			}
+			return -1;
+		case TL_ARGS:
+			return after + 1 < c->params.count ? after + 1 : -1;
+		case TL_REFS:
+			return x->self && after + 1 < x->self->ref_count ? after + 1 : -1;
+		default:
+			return -1;
+	}
+}
+/**
+ * @brief Writes bytes when a sink is given.
+ * @return 1 if there are bytes to write.
+ */
+static int tm_write(sink out, const char* p, size_t len) {
+	if (out) Sink.write(out, p, len);
+	return len > 0;
+}
+/**
+ * @brief Renders the header or footer of a template.
+ * @param out Sink to write to.
+ * @param path Output path naming the document, or NULL.
+ * @param t Template, or NULL.
+ * @param part TMPL_HEADER or TMPL_FOOTER.
+ */
+static void md_frame(sink out, const string path, tmpl t, tmpl_part part) {
+	int count;
+	const tmpl_op* ops = t ? Template.program(t, part, &count) : NULL;
+	if (!ops || count == 0) return;
+
+	struct tm_ctx_s x = { 0 };
+	if (path) {
+		//	the title is the file name without directory and extension
+		const char* base = strrchr(path, '/');
+		base = base ? base + 1 : path;
+		const char* dot = strrchr(base, '.');
+		x.title = base;
+		x.title_len = dot && dot > base ? (size_t)(dot - base) : strlen(base);
+	}
+	md_template(out, &x, ops, count);
+}
+/**
+ * @brief Writes the template's header.
+ */
+static void md_begin(sink out, const string path, tmpl t) {
+	md_frame(out, path, t, TMPL_HEADER);
+}
+/**
+ * @brief Writes the template's footer.
+ */
+static void md_end(sink out, const string path, tmpl t) {
+	md_frame(out, path, t, TMPL_FOOTER);
+}
+/**
+ * @brief Renders the comments of one source unit.
+ * @param out Sink to write to.
+ * @param u Unit to render.
+ * @param st Symbol index of the document for links, or NULL.
+ * @param t Compiled template, or NULL for the built-in layout.
+ */
+static void md_render(sink out, unit u, symtab st, tmpl t) {
+	long begin = Stats.now();
+	int count = 0;
+	const tmpl_op* ops = t ? Template.program(t, TMPL_BODY, &count) : NULL;
+	for (int j = 0; j < u->count; j++) {
+		comment c = &u->comments[j];
+		if (!t) {
+			md_comment(out, st, c);
+			continue;
 		}
+		struct tm_ctx_s x = { st, c, Symbols.of(st, c) };
+		md_template(out, &x, ops, count);
+	}
+	Stats.span("generate", u->src->path, begin);
+}
+/**
+ * @brief Renders a whole document into a StringBuilder.
+ * @param sb StringBuilder to append to.
+ * @param units Units in source order.
+ * @param st Symbol index for links, or NULL.
+ * @param t Compiled template, or NULL for the built-in layout.
+ */
+static void md_generate(string_builder sb, list units, symtab st, tmpl t) {
+	sink out = Sink.toBuilder(sb);
+	if (!out) return;
+	md_begin(out, NULL, t);
+	for (int i = 0; i < List.count(units); i++) {
+		md_render(out, List.getAt(units, i), st, t);
+	}
+	md_end(out, NULL, t);
+	Sink.close(out);
+}
+/**
+ * @brief Renders a document straight to a file through a sink.
+ * @param units Units in source order.
+ * @param path Output file path.
+ * @param st Symbol index for links, or NULL.
+ * @param t Compiled template, or NULL for the built-in layout.
+ * @return 0 on success, non-zero on failure.
+ */
+static int md_write_file(list units, const string path, symtab st, tmpl t) {
+	sink out = Sink.open(path);
+	if (!out) return 1;
+	md_begin(out, path, t);
+	for (int i = 0; i < List.count(units); i++) {
+		md_render(out, List.getAt(units, i), st, t);
 	}
-	Iterator.free(it);
+	md_end(out, path, t);
+	return Sink.close(out);
 }
 
 const IGenerator MDGenerator = {
-    .generate = md_generate
+    .generate = md_generate,
+    .render = md_render,
+    .writeFile = md_write_file,
+    .begin = md_begin,
+    .end = md_end
 };
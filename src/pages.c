@@ -0,0 +1,298 @@
+// pages.c
+#define _POSIX_C_SOURCE 200809L
+#include "pages.h"
+#include "lines.h"
+#include "strmap.h"
+#include <errno.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*	lists the pages of the last run, relative to the page directory */
+#define PAGES_MANIFEST ".pages"
+
+/* structure representing the pages of a document being written */
+struct page_pool_s {
+	list units;			/**< Units in source order (read only) */
+	const char* output;	/**< Index path */
+	tmpl t;				/**< Page template, or NULL */
+	int next;			/**< Next unit to hand out */
+	int written;		/**< Pages written */
+	int failed;			/**< Set when a page could not be written */
+	string* paths;		/**< Page path of each unit */
+	size_t dir_len;		/**< Length of the page directory in the paths */
+};
+
+//	Forward declarations / Function prototypes
+static string pages_dir(const string);
+static string pages_path(const string, const string);
+static int pages_write(list, const string, tmpl, int, int*);
+static int write_page(unit, string, size_t, tmpl);
+static int write_index(list, string*, const string);
+static int make_parents(string, size_t);
+static void remove_stale(const string, string*, int);
+static void* page_worker(void*);
+
+/**
+ * @brief Builds the page directory of an index: its path without `.md`, or
+ *			with `.pages` appended when it has another extension.
+ * @return Allocated path (caller frees).
+ */
+static string pages_dir(const string output) {
+	size_t len = strlen(output);
+	int md = len > 3 && strcmp(output + len - 3, ".md") == 0;
+	string dir = Mem.alloc(len + 7);
+	if (md) {
+		memcpy(dir, output, len - 3);
+		dir[len - 3] = '\0';
+	} else {
+		memcpy(dir, output, len);
+		memcpy(dir + len, ".pages", 7);
+	}
+	return dir;
+}
+/**
+ * @brief Builds the page path of a source: the source's path mirrored under
+ *			the page directory, plus `.md`.
+ * @details The mapping is one to one: `%` is written `%25`, a `..` component
+ *			`%2E%2E` and a leading `/` a `%2F` component; `.` components and
+ *			repeated slashes are dropped, as they name the same file.
+ * @param output Index path.
+ * @param source Source path.
+ * @return Allocated path (caller frees).
+ */
+static string pages_path(const string output, const string source) {
+	string dir = pages_dir(output);
+	size_t dlen = strlen(dir);
+	string path = Mem.alloc(dlen + 3 * strlen(source) + 12);
+	memcpy(path, dir, dlen);
+	Mem.free(dir);
+
+	char* w = path + dlen;
+	const char* p = source;
+	if (*p == '/') {
+		memcpy(w, "/%2F", 4);
+		w += 4;
+	}
+	while (*p) {
+		while (*p == '/') p++;
+		const char* end = strchr(p, '/');
+		if (!end) end = p + strlen(p);
+		size_t len = end - p;
+		if (len == 0 || (len == 1 && p[0] == '.')) {
+			p = end;
+			continue;
+		}
+		*w++ = '/';
+		if (len == 2 && p[0] == '.' && p[1] == '.') {
+			memcpy(w, "%2E%2E", 6);
+			w += 6;
+		} else {
+			for (const char* c = p; c < end; c++) {
+				if (*c == '%') {
+					memcpy(w, "%25", 3);
+					w += 3;
+				} else {
+					*w++ = *c;
+				}
+			}
+		}
+		p = end;
+	}
+	memcpy(w, ".md", 4);
+	return path;
+}
+/**
+ * @brief Writes the pages of a document on a pool of workers, then its index,
+ *			and removes the pages of sources that left the document.
+ * @details Workers take the next unit until none are left; the calling thread
+ *			is one of them. Pages do not depend on each other, so their order
+ *			of completion does not matter.
+ * @return 0 if every page and the index were written, non-zero otherwise.
+ */
+static int pages_write(list units, const string output, tmpl t, int jobs, int* pages) {
+	int count = List.count(units);
+	string dir = pages_dir(output);
+	if (count > 0 && mkdir(dir, 0755) != 0 && errno != EEXIST) {
+		fprintf(stderr, "Failed to create page directory '%s'\n", dir);
+		Mem.free(dir);
+		return 1;
+	}
+
+	struct page_pool_s pool = { units, output, t, 0, 0, 0, NULL, strlen(dir) };
+	pool.paths = Mem.alloc((count + 1) * sizeof(string));
+	for (int i = 0; i < count; i++) {
+		pool.paths[i] = pages_path(output, ((unit)List.getAt(units, i))->src->path);
+	}
+
+	int workers = jobs > 0 ? jobs : (int)sysconf(_SC_NPROCESSORS_ONLN);
+	if (workers > count) workers = count;
+	pthread_t* threads = workers > 1 ? Mem.alloc((workers - 1) * sizeof(pthread_t)) : NULL;
+	int started = 0;
+	while (threads && started < workers - 1 && pthread_create(&threads[started], NULL, page_worker, &pool) == 0) {
+		started++;
+	}
+	page_worker(&pool);
+	for (int i = 0; i < started; i++) pthread_join(threads[i], NULL);
+	if (threads) Mem.free(threads);
+
+	if (write_index(units, pool.paths, output) != 0) pool.failed = 1;
+	remove_stale(dir, pool.paths, count);
+	if (pages) *pages = pool.written;
+
+	for (int i = 0; i < count; i++) Mem.free(pool.paths[i]);
+	Mem.free(pool.paths);
+	Mem.free(dir);
+	return pool.failed;
+}
+/**
+ * @brief Takes units from the pool and writes their pages until none are left.
+ * @param arg The page_pool_s of the document.
+ * @return NULL.
+ */
+static void* page_worker(void* arg) {
+	struct page_pool_s* pool = arg;
+	int count = List.count(pool->units);
+	int i;
+	while ((i = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED)) < count) {
+		unit u = List.getAt(pool->units, i);
+		string path = pool->paths[i];
+		if (write_page(u, path, pool->dir_len, pool->t) == 0) {
+			__atomic_add_fetch(&pool->written, 1, __ATOMIC_RELAXED);
+		} else {
+			fprintf(stderr, "Failed to write page '%s'\n", path);
+			__atomic_store_n(&pool->failed, 1, __ATOMIC_RELAXED);
+		}
+	}
+	return NULL;
+}
+/**
+ * @brief Writes the page of one source, header and footer included.
+ * @param u Unit to render.
+ * @param path Page path.
+ * @param dir_len Length of the page directory in path; directories below it
+ *			are created as needed.
+ * @param t Page template, or NULL.
+ * @return 0 on success, non-zero on failure.
+ */
+static int write_page(unit u, string path, size_t dir_len, tmpl t) {
+	if (make_parents(path, dir_len + 1) != 0) return 1;
+	sink out = Sink.open(path);
+	if (!out) return 1;
+	MDGenerator.begin(out, path, t);
+	MDGenerator.render(out, u, NULL, t);
+	MDGenerator.end(out, path, t);
+	return Sink.close(out);
+}
+/**
+ * @brief Writes the index: a title and one link per page, followed by the
+ *			brief of the source's `@file` comment when it has one.
+ * @param units Units in source order.
+ * @param paths Page path of each unit.
+ * @param output Index path; the title is its file name without the extension.
+ * @return 0 on success, non-zero on failure.
+ */
+static int write_index(list units, string* paths, const string output) {
+	sink out = Sink.open(output);
+	if (!out) return 1;
+
+	const char* base = strrchr(output, '/');
+	base = base ? base + 1 : output;
+	const char* dot = strrchr(base, '.');
+	int title = dot && dot > base ? (int)(dot - base) : (int)strlen(base);
+	Sink.appendf(out, "# %.*s\n\n", title, base);
+
+	for (int i = 0; i < List.count(units); i++) {
+		unit u = List.getAt(units, i);
+		Sink.appendf(out, "- [%s](", u->src->path);
+		for (const char* link = paths[i] + (base - output); *link; link++) {	//	relative to the index
+			if (*link == '%') {
+				Sink.append(out, "%25");		//	a link is a URL: keep the escapes literal
+			} else {
+				Sink.write(out, link, 1);
+			}
+		}
+		Sink.append(out, ")");
+
+		const tag* brief = NULL;
+		for (int j = 0; j < u->count && !brief; j++) {
+			comment c = &u->comments[j];
+			for (int k = 0; c->is_file && k < c->tags.count; k++) {
+				if (c->tags.items[k].kind == TAG_BRIEF && c->tags.items[k].count) brief = &c->tags.items[k];
+			}
+			if (brief) {
+				span line = c->lines.items[brief->first];
+				Sink.appendf(out, ": %.*s", (int)line.length, SPAN_PTR(c->src, line));
+			}
+		}
+		Sink.appendf(out, " (%d %s)\n", u->count, u->count == 1 ? "comment" : "comments");
+	}
+	return Sink.close(out);
+}
+/**
+ * @brief Creates the directories of a path below a prefix.
+ * @param path File path; restored before returning.
+ * @param from Offset of the first directory to create.
+ * @return 0 on success, non-zero if a directory cannot be created.
+ */
+static int make_parents(string path, size_t from) {
+	for (char* p = strchr(path + from, '/'); p; p = strchr(p + 1, '/')) {
+		*p = '\0';
+		int made = mkdir(path, 0755) == 0 || errno == EEXIST;
+		if (!made) fprintf(stderr, "Failed to create page directory '%s'\n", path);
+		*p = '/';
+		if (!made) return 1;
+	}
+	return 0;
+}
+/**
+ * @brief Removes the pages of an earlier run that are no longer written,
+ *			then records the current pages in the directory's manifest.
+ * @details Only pages listed in the manifest are removed, so other files in
+ *			the directory are never touched; directories left empty are removed.
+ * @param dir Page directory.
+ * @param paths Page paths of this run.
+ * @param count Number of pages.
+ */
+static void remove_stale(const string dir, string* paths, int count) {
+	size_t dlen = strlen(dir);
+	string manifest = Mem.alloc(dlen + sizeof(PAGES_MANIFEST) + 1);
+	sprintf(manifest, "%s/%s", dir, PAGES_MANIFEST);
+
+	strmap current = StrMap.new(count + 1);
+	for (int i = 0; i < count; i++) StrMap.put(current, paths[i] + dlen + 1, paths[i]);
+
+	line_reader r = Lines.open(manifest);
+	size_t len;
+	const char* name;
+	while (r && (name = Lines.next(r, &len))) {
+		if (len == 0 || StrMap.getn(current, name, len)) continue;
+		string stale = Mem.alloc(dlen + len + 2);
+		sprintf(stale, "%s/%.*s", dir, (int)len, name);
+		if (unlink(stale) == 0 || errno == ENOENT) {
+			//	prune directories the page leaves empty, up to the page directory
+			for (char* p = strrchr(stale, '/'); p && (size_t)(p - stale) > dlen; p = strrchr(stale, '/')) {
+				*p = '\0';
+				if (rmdir(stale) != 0) break;
+			}
+		}
+		Mem.free(stale);
+	}
+	if (r) Lines.close(r);
+	StrMap.free(current);
+
+	if (count > 0) {
+		sink out = Sink.open(manifest);
+		for (int i = 0; out && i < count; i++) Sink.appendf(out, "%s\n", paths[i] + dlen + 1);
+		if (out) Sink.close(out);
+	} else {
+		unlink(manifest);
+		rmdir(dir);
+	}
+	Mem.free(manifest);
+}
+
+const IPages Pages = {
+	.path = pages_path,
+	.write = pages_write
+};
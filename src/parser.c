@@ -1,147 +1,491 @@
 // parser.c
+#define _POSIX_C_SOURCE 200809L
 #include "parser.h"
-#include <dirent.h>
-#include <ctype.h>
+#include "scan.h"
+#include "cache.h"
+#include "strmap.h"
+#include "stats.h"
+#include "walk.h"
+#include "symbols.h"
+#include "lines.h"
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
 
 const string OUTDIR = "outdir=";
-const string WILDSEP = "/*";
-const char O_PAREN = '(';
-const string DOXTAG = "/**";
+const string EXCLUDE = "exclude=";
+const string OUTMODE = "outmode=";
 const string DEFTRGET = "default";
-const string DOXFILE = "* @file";
-const string DOXBRIEF = "* @brief";
-const string DOXDTAIL = "* @details";
-const string DOXPARAM = "* @param";
-const string DOXRETRN = "* @return";
 
-static int IS_DEBUG = 0;
+#define UNIT_BLOCK 16384
+
+/*	printf arguments for "%.*s" of a span, with a fallback when empty */
+#define SPAN_ARGS(s, sp, dflt) \
+	(sp).length ? (int)(sp).length : (int)strlen(dflt), (sp).length ? SPAN_PTR(s, sp) : (dflt)
 
 //	Typedefs
-enum tag_type {
-	NONE,
-	BRIEF,
-	DTAIL,
-	PARAM,
-	RETRN
-};
-typedef enum tag_type TAGTYPE;
 /*	structure representing a target in Doxy2MD. */
 struct target_s {
 	string target;		/**< Target name (e.g., "sigcore") */
 	list sources; 		/**< List of source files (e.g., "sigcore.h") */
 	string outdir;		/**< Output directory (e.g., "docs/") */
+	int split;			/**< outmode=split: one page per source plus an index */
 	int is_redirect;	/**< Flag: 1 if this redirects to another target, 0 otherwise */
 };
 typedef struct target_s* target;
-/* structure representing a target index */
-struct index_s {
+/* structure representing one target line of Doxy2MD */
+struct target_entry_s {
 	string name;		/**< Target name */
-	long offset;		/**< File offset to target line */
+	string line;		/**< Logical line (continuations joined) */
+	target t;			/**< Parsed target; NULL until first lookup */
+	target resolved;	/**< Target after following redirects */
+	int state;			/**< 0 unresolved, 1 resolving, 2 resolved */
+};
+typedef struct target_entry_s* target_entry;
+/* structure representing a parsed Doxy2MD file */
+struct target_table_s {
+	list entries;		/**< Entries in file order; first definition of a name wins */
+	strmap names;		/**< Target name -> entry */
+};
+typedef struct target_table_s* target_table;
+/* structure representing the parse of one source file */
+struct parse_job_s {
+	string filename;	/**< Source file to parse */
+	unit result;		/**< Parse results; NULL if the file has no comment blocks */
+	string_builder log;	/**< Debug output, flushed in source order; NULL if not debugging */
+	int ret;			/**< process_file result */
+	int dropped;		/**< Comment blocks dropped (empty or unterminated) */
+	int done;			/**< Set by the worker when the job has finished */
+};
+typedef struct parse_job_s* parse_job;
+/* structure representing the work queue shared by parse workers */
+struct job_queue_s {
+	struct parse_job_s* jobs;	/**< Jobs in source order */
+	int count;					/**< Number of jobs */
+	int next;					/**< Next job to hand out */
+	int consumed;				/**< Jobs taken by the consumer, in order */
+	int window;					/**< Jobs allowed to run ahead of the consumer */
+	string cache_dir;			/**< Parse cache directory, or NULL */
+	doxy_config* config;		/**< Configuration (debug, cache stats) */
+	pthread_t* threads;			/**< Worker threads */
+	int started;				/**< Number of running workers */
+	pthread_mutex_t lock;		/**< Guards next, consumed and done */
+	pthread_cond_t ready;		/**< Signals finished jobs and freed window slots */
 };
-typedef struct index_s* target_index;
+typedef struct job_queue_s* job_queue;
+/* structure representing the comments of a source while it is parsed */
+struct block_buf_s {
+	span_list lines;	/**< Text lines of the kept blocks, then the open one (Mem-allocated) */
+	tag_list tags;		/**< Sections, likewise */
+	span_list params;	/**< Parameters of the declarations after the blocks, likewise */
+	struct comment_s* comments;	/**< Kept comments; the open block is the slot after them */
+	int count;			/**< Number of kept comments */
+	int capacity;		/**< Allocated comment slots */
+	int line_mark;		/**< First line of the open block */
+	int tag_mark;		/**< First tag of the open block */
+	int param_mark;		/**< First parameter of the open block */
+};
+
+/*	appends to a job's debug log when debugging */
+#define JOB_LOG(job, ...) \
+	do { if ((job)->log) StringBuilder.appendf((job)->log, __VA_ARGS__); } while (0)
 
 
 //	Forward declarations / Function prototypes
-static int doxy_index_targets(FILE*, list);
-static long find_offset(list, const string);
+static target_table load_targets(const string);
+static void add_target_line(target_table, string_builder);
+static target find_target(target_table, const string, const string);
+static void free_table(target_table);
 static target doxy_parse_line(const string);
 static void free_target(target);
-static int process_target(target, list, doxy_config*);
-static int process_file(const string, list);
-static comment init_comment();
-static string parse_comment_line(const string, TAGTYPE*);
-static string extract_signature(FILE*, string*, string*);
+static string target_outfile(const string, const string, const string);
+static int stream_document(doxy_config*, document, unit_fn, object);
+static list resolve_targets(doxy_config*, list);
+static list resolve_configured(doxy_config*);
+static document new_document(const string, const string, const string, int, list);
+static void print_sources(doxy_config*);
+static int collect_unit(unit, object);
+static int parse_sources(list, doxy_config*, unit_fn, object);
+static job_queue start_jobs(list, doxy_config*);
+static parse_job wait_job(job_queue, int);
+static void finish_job(job_queue, int);
+static void stop_jobs(job_queue);
+static void flush_log(parse_job, int);
+static void free_document(document);
+static void release_documents(list);
+static void* parse_worker(void*);
+static int parse_file(doxy_config*, const string, unit*);
+static int process_file(parse_job, const string);
+static int parse_source(parse_job, source);
+static comment open_block(struct block_buf_s*, source);
+static void release_units(list);
+static const char* lex_tag(source, const char*, size_t, tag*, size_t*);
+static tag_kind lookup_tag(const char*, size_t);
+static int push_span(span_list*, span);
+static int push_tag(struct block_buf_s*, tag);
+static void keep_block(struct block_buf_s*);
+static int seal_unit(unit, const struct block_buf_s*);
+static int extract_signature(comment, struct block_buf_s*, const char**, const char*);
+static const char* trim_view(const char*, const char*, size_t*);
+static const char* next_line(const char**, const char*, size_t*);
+static span make_span(source, const char*, size_t);
 
 //	to md_generator ???
 //static void append_comment_to_md(string_builder, comment);
 
 /**
- * @brief Parses a Doxy2MD file and processes its targets.
- * @param filename Name of the Doxy2MD file to parse.
- * @return 0 on success, non-zero on failure.
+ * @brief Parses the configured target (or config->sources) of a Doxy2MD file.
+ * @param config Configuration for parsing.
+ * @return List of units with comments, in source order.
  */
 static list parse_doxy2md(doxy_config* config) {
-	list comments = NULL;
-	if (!config || !config->file) return comments;
-	IS_DEBUG = config->is_debug;
+	if (!config || !config->file) return NULL;
 	
+	list units = List.new(100);
+	list documents = resolve_configured(config);
+	for (int i = 0; documents && i < List.count(documents); i++) {
+		stream_document(config, List.getAt(documents, i), collect_unit, units);
+	}
+	release_documents(documents);
+	return units;
+}
+/**
+ * @brief Keeps a streamed unit in a list.
+ * @param u Unit with comments.
+ * @param ctx List to append to.
+ * @return 0.
+ */
+static int collect_unit(unit u, object ctx) {
+	u->refs++;
+	List.add(ctx, u);
+	return 0;
+}
+/**
+ * @brief Parses a document's sources, handing each unit to a callback in
+ *			source order.
+ * @details Units are released once the callback returns, so only the parse
+ *			window is held in memory. Neither the configuration nor the document
+ *			is modified.
+ * @param config Configuration for parsing.
+ * @param d Document from resolveTargets.
+ * @param emit Callback receiving each unit with comments.
+ * @param ctx Callback context.
+ * @return 0 on success, non-zero on failure.
+ */
+static int stream_document(doxy_config* config, document d, unit_fn emit, object ctx) {
+	if (!config || !d) return 1;
+	if (config->is_debug) printf("Processing target (%s)\n", d->name);
+	return parse_sources(d->sources, config, emit, ctx);
+}
+/**
+ * @brief Parses several targets of a Doxy2MD file, sharing parse results.
+ * @details Every unique source across the targets is parsed exactly once; each
+ *			document references the shared units of its sources.
+ * @param config Configuration for parsing (file, workers, cache).
+ * @param names Target names to build, or NULL for every target except `default`.
+ * @return List of documents in the order requested, or NULL on failure.
+ */
+static list parse_targets(doxy_config* config, list names) {
+	list documents = resolve_targets(config, names);
+	if (!documents || List.count(documents) == 0) return documents;
 	
-	comments = List.new(100);
-	if (config->sources && List.count(config->sources) > 0) {
-		printf("IS_DEBUG=%s\n", IS_DEBUG ? "TRUE" : "FALSE");
-		printf("cfg.file=%s\n", config->file);
-		printf("cfg.output=%s\n", config->output);
-		printf("cfg.target=%s\n", config->target);
-		printf("cfg.template=%s\n", config->template);
-		printf("cfg.sources:\n");
-		iterator s_it = Array.getIterator(config->sources, LIST);
-		while (Iterator.hasNext(s_it)) printf("   src=%s\n", (string)Iterator.next(s_it));
-		Iterator.free(s_it);
-		
-		//	use provided sources directly
-		process_target(NULL, comments, config);
-	} else {
-		FILE* f = fopen(config->file, "r");
-		if (!f) {
-			fprintf(stderr, "failed to open configuration: %s\n", config->file);
-			return comments;
+	//	collect the unique sources
+	list files = List.new(64);
+	strmap seen = StrMap.new(64);		//	source path -> index in files + 1
+	for (int i = 0; i < List.count(documents); i++) {
+		document d = List.getAt(documents, i);
+		for (int j = 0; j < List.count(d->sources); j++) {
+			string path = List.getAt(d->sources, j);
+			if (StrMap.get(seen, path)) continue;
+			List.add(files, path);
+			StrMap.put(seen, path, (object)(intptr_t)List.count(files));
 		}
-		
-		list indices = List.new(10);
-		if (doxy_index_targets(f, indices) != 0) {
-			//	came back empty -- no targets
-			printf("Configuration '%s' was empty\n", config->file);
-			List.free(comments);
-			comments = NULL;
-			
-			goto cleanup;
+	}
+	
+	//	parse each unique source once
+	job_queue queue = start_jobs(files, config);
+	if (!queue) {
+		StrMap.free(seen);
+		List.free(files);
+		release_documents(documents);
+		return NULL;
+	}
+	for (int i = 0; i < List.count(files); i++) {
+		parse_job job = wait_job(queue, i);
+		if (config->is_debug) flush_log(job, i);
+		finish_job(queue, i);
+	}
+	parse_job jobs = queue->jobs;
+	
+	//	attach the shared units; a target with a failed source is dropped
+	for (int i = 0; i < List.count(documents); i++) {
+		document d = List.getAt(documents, i);
+		for (int j = 0; j < List.count(d->sources); j++) {
+			parse_job job = &jobs[(intptr_t)StrMap.get(seen, List.getAt(d->sources, j)) - 1];
+			if (job->ret != 0) {
+				fprintf(stderr, "%s: target '%s' skipped, source '%s' failed\n", config->file, d->name, job->filename);
+				List.remove(documents, d);
+				free_document(d);
+				i--;
+				break;
+			}
+			if (job->result && job->result->count > 0) {
+				job->result->refs++;
+				List.add(d->units, job->result);
+			}
 		}
+	}
+	
+	//	index each document's symbols while its units are at hand
+	for (int i = 0; config->links && i < List.count(documents); i++) {
+		document d = List.getAt(documents, i);
+		d->symbols = Symbols.build(d->units);
+	}
+	
+	//	drop the parse references; units live on through their documents
+	stop_jobs(queue);
+	StrMap.free(seen);
+	List.free(files);
+	
+	return documents;
+}
+/**
+ * @brief Resolves targets of a Doxy2MD file into documents without parsing.
+ * @details With config->sources set, the sources form a single document
+ *			named after config->target. config->output, when set, replaces the
+ *			file name of every document ([outdir/]output).
+ * @param config Configuration (file, output, sources).
+ * @param names Target names, or NULL for every target except `default`.
+ * @return List of documents with names, outputs and sources (no units), or
+ *			NULL on failure.
+ */
+static list resolve_targets(doxy_config* config, list names) {
+	if (!config || !config->file) return NULL;
+	
+	if (config->sources && List.count(config->sources) > 0) {
+		//	use provided sources directly
+		print_sources(config);
+		list documents = List.new(1);
+		List.add(documents, new_document(config->target ? config->target : DEFTRGET, NULL, config->output, 0, config->sources));
+		return documents;
+	}
+	
+	long begin = Stats.now();
+	target_table table = load_targets(config->file);
+	if (!table) {
+		fprintf(stderr, "failed to open configuration: %s\n", config->file);
+		return NULL;
+	}
+	
+	if (List.count(table->entries) == 0) {
+		//	not a failure: the caller reports it
+		free_table(table);
+		return List.new(1);
+	}
+	
+	list documents = List.new(10);
+	int count = names ? List.count(names) : List.count(table->entries);
+	for (int i = 0; i < count; i++) {
+		string name = names ? (string)List.getAt(names, i) : ((target_entry)List.getAt(table->entries, i))->name;
+		if (!names && strcmp(name, DEFTRGET) == 0) continue;
 		
-		string target_name = config->target ? config->target : DEFTRGET;
-		long offset = find_offset(indices, target_name);
-		target t = NULL;
-		char line[MAX_LINE];
+		target t = find_target(table, name, config->file);
+		if (!t) continue;
 		
-		if (offset >= 0) {
-			fseek(f, offset, SEEK_SET);
-			if (fgets(line, MAX_LINE, f)) {
-				t = doxy_parse_line(line);
-			}
-		}
+		List.add(documents, new_document(t->target, t->outdir, config->output, t->split, t->sources));
+	}
+	free_table(table);
+	Stats.span("index", config->file, begin);
+	
+	if (names && List.count(documents) == 0) {
+		//	none of the named targets exists; each was reported
+		List.free(documents);
+		return NULL;
+	}
+	return documents;
+}
+/**
+ * @brief Resolves the configured target (config->target, else `default`).
+ * @param config Configuration (file, target, output, sources).
+ * @return List of documents (at most one), or NULL on failure.
+ */
+static list resolve_configured(doxy_config* config) {
+	list names = List.new(1);
+	List.add(names, config->target ? config->target : DEFTRGET);
+	list documents = resolve_targets(config, names);
+	List.free(names);
+	return documents;
+}
+/**
+ * @brief Creates a document with no units.
+ * @param name Target name.
+ * @param outdir Output directory, or NULL.
+ * @param output Output override, or NULL for <name>.md.
+ * @param split outmode=split flag.
+ * @param sources Source paths; the document keeps its own copies.
+ * @return Document (release with free_document).
+ */
+static document new_document(const string name, const string outdir, const string output, int split, list sources) {
+	document d = Mem.alloc(sizeof(struct document_s));
+	d->name = Mem.alloc(strlen(name) + 1);
+	strcpy(d->name, name);
+	d->output = target_outfile(name, outdir, output);
+	d->units = List.new(List.count(sources) + 1);
+	d->sources = List.new(List.count(sources) + 1);
+	d->symbols = NULL;
+	d->split = split;
+	for (int j = 0; j < List.count(sources); j++) {
+		string src = List.getAt(sources, j);
+		string path = Mem.alloc(strlen(src) + 1);
+		strcpy(path, src);
+		List.add(d->sources, path);
+	}
+	return d;
+}
+/**
+ * @brief Prints a configuration that lists its sources directly (debug only).
+ * @param config Configuration with sources.
+ */
+static void print_sources(doxy_config* config) {
+	if (!config->is_debug) return;
+	printf("cfg.file=%s\n", config->file);
+	printf("cfg.output=%s\n", config->output);
+	printf("cfg.target=%s\n", config->target);
+	printf("cfg.template=%s\n", config->template ? config->template : "(built-in)");
+	printf("cfg.sources:\n");
+	iterator s_it = Array.getIterator(config->sources, LIST);
+	while (Iterator.hasNext(s_it)) printf("   src=%s\n", (string)Iterator.next(s_it));
+	Iterator.free(s_it);
+}
+/**
+ * @brief Reads a Doxy2MD file into a table of targets.
+ * @details Lines have no length limit; a trailing `\\` continues a line on the
+ *			next one. The file may be a pipe (e.g. process substitution); it is
+ *			read with the shared line reader. Targets are parsed on first lookup
+ *			and kept.
+ * @param file Doxy2MD file to read.
+ * @return Allocated table (empty if the file has no targets), or NULL if the
+ *			file cannot be read.
+ */
+static target_table load_targets(const string file) {
+	line_reader r = Lines.open(file);
+	if (!r) return NULL;
+	
+	target_table table = Mem.alloc(sizeof(struct target_table_s));
+	table->entries = List.new(16);
+	table->names = StrMap.new(16);
+	
+	string_builder line = StringBuilder.new(256);
+	size_t len;
+	const char* text;
+	int continued = 0;
+	while ((text = Lines.next(r, &len))) {
+		text = trim_view(text, text + len, &len);
+		//	skip comments and blank lines between targets
+		if (!continued && (len == 0 || text[0] == '#')) continue;
 		
-		if (t && t->is_redirect && t->target) {
-			offset = find_offset(indices, t->target);
-			free_target(t);
-			t = NULL;
-			
-			if (offset >= 0) {
-				fseek(f, offset, SEEK_SET);
-				if (fgets(line, MAX_LINE, f)) {
-					t = doxy_parse_line(line);
-				}
-			}
-		}
+		//	a trailing '\\' joins the next line
+		continued = len > 0 && text[len - 1] == '\\';
+		if (continued) len--;
 		
-		if (t && !t->is_redirect) {
-			process_target(t, comments, config);
-			free_target(t);
-		} else {
-			fprintf(stderr, "%s: target '%s' not found or invalid default\n", config->file, target_name);
-			if (t) free_target(t);
-		}
+		StringBuilder.appendf(line, "%.*s%s", (int)len, text, continued ? " " : "");
 		
-	cleanup:
-		iterator it = Array.getIterator(indices, LIST);
-		while (Iterator.hasNext(it)) {
-			target_index ti = Iterator.next(it);
-			Mem.free(ti->name);
-			Mem.free(ti);
-		}
-		Iterator.free(it);
-		fclose(f);
+		if (!continued) add_target_line(table, line);
+	}
+	if (continued) add_target_line(table, line);
+	if (Lines.error(r)) fprintf(stderr, "%s: read failed after line %ld\n", file, Lines.number(r));
+	
+	StringBuilder.free(line);
+	Lines.close(r);
+	return table;
+}
+/**
+ * @brief Adds a logical line to the table, if it names a target.
+ * @param table Table to add to.
+ * @param line Accumulated logical line; cleared on return.
+ */
+static void add_target_line(target_table table, string_builder line) {
+	string text = StringBuilder.toString(line);
+	StringBuilder.clear(line);
+	
+	char* colon = strchr(text, ':');
+	if (!colon) {
+		//	invalid target configuration
+		Mem.free(text);
+		return;
+	}
+	
+	size_t len = colon - text;
+	string name = Mem.alloc(len + 1);
+	memcpy(name, text, len);
+	name[len] = '\0';
+	string trimmed = trim(name);
+	if (StrMap.get(table->names, trimmed)) {
+		//	first definition wins
+		Mem.free(name);
+		Mem.free(text);
+		return;
 	}
+	memmove(name, trimmed, strlen(trimmed) + 1);
 	
-	return comments;	
+	target_entry e = Mem.alloc(sizeof(struct target_entry_s));
+	e->name = name;
+	e->line = text;
+	e->t = NULL;
+	e->resolved = NULL;
+	e->state = 0;
+	List.add(table->entries, e);
+	StrMap.put(table->names, e->name, e);
+}
+/**
+ * @brief Looks up a target, following redirects (e.g. `default: doxy`).
+ * @param table Target table.
+ * @param name Target name.
+ * @param file Config file name, for diagnostics.
+ * @return Target with sources (owned by the table), or NULL if not found, a
+ *			redirect cycle, or invalid.
+ */
+static target find_target(target_table table, const string name, const string file) {
+	target_entry e = StrMap.get(table->names, name);
+	if (!e) {
+		fprintf(stderr, "%s: target '%s' not found or invalid default\n", file, name);
+		return NULL;
+	}
+	if (e->state == 2) return e->resolved;
+	if (e->state == 1) {
+		fprintf(stderr, "%s: target '%s' redirects to itself\n", file, name);
+		return NULL;
+	}
+	
+	e->state = 1;
+	if (!e->t) e->t = doxy_parse_line(e->line);
+	if (!e->t) {
+		fprintf(stderr, "%s: target '%s' not found or invalid default\n", file, name);
+	} else if (e->t->is_redirect) {
+		e->resolved = find_target(table, e->t->target, file);
+	} else {
+		e->resolved = e->t;
+	}
+	e->state = 2;
+	
+	return e->resolved;
+}
+/**
+ * @brief Frees a target table and its targets.
+ * @param table Table to free.
+ */
+static void free_table(target_table table) {
+	if (!table) return;
+	for (int i = 0; i < List.count(table->entries); i++) {
+		target_entry e = List.getAt(table->entries, i);
+		free_target(e->t);
+		Mem.free(e->name);
+		Mem.free(e->line);
+		Mem.free(e);
+	}
+	List.free(table->entries);
+	StrMap.free(table->names);
+	Mem.free(table);
 }
 
 /**
@@ -171,13 +515,15 @@ static target doxy_parse_line(const string line) {
 	
 	t->sources = List.new(10);
 	t->outdir = NULL;
+	t->split = 0;
 	t->target = Mem.alloc(strlen(target_name) + 1);
 	strcpy(t->target, target_name);
 	t->is_redirect = 0;
 	
 	//	set up token iteration
 	string body = trim(colon + 1);
-	string token = strtok(body, " ");
+	string save = NULL;
+	string token = strtok_r(body, " ", &save);
 	if (strcmp(t->target, "default") == 0) {
 		//	redirecting to the default target
 		if (token) {
@@ -196,108 +542,59 @@ static target doxy_parse_line(const string line) {
 	} else {
 		//	parse body tokens
 		int offset = 0;
+		list excludes = List.new(4);
 		while (token) {
 			if (strncmp(token, OUTDIR, (offset = strlen(OUTDIR))) == 0) {	//	outdir=
 				t->outdir = Mem.alloc(strlen(token + offset) + 1);
 				strcpy(t->outdir, token + offset);
-			} else if (strstr(token, WILDSEP)) {									// wildcards
-				string dir = Mem.alloc(strlen(token) + 1);
-				strcpy(dir, token);
-				char* wild = strstr(dir, WILDSEP);	// locate the wildcard separator: /*
-				if (wild) *wild = '\0';					// trim separator
-				
-				DIR* d = opendir(dir);
-				if (d) {
-					struct dirent* entry;
-					while((entry = readdir(d)) != NULL) {
-						if (strstr(entry->d_name, ".c") || strstr(entry->d_name, ".h")) {
-							string path = Mem.alloc(strlen(dir) + strlen(entry->d_name) + 2);
-							snprintf(path, strlen(dir) + strlen(entry->d_name) + 2, "%s/%s", dir, entry->d_name);
-							List.add(t->sources, path);
-						}
-					}
-					closedir(d);
+			} else if (strncmp(token, OUTMODE, strlen(OUTMODE)) == 0) {				//	outmode=single|split
+				string mode = token + strlen(OUTMODE);
+				if (strcmp(mode, "split") == 0 || strcmp(mode, "single") == 0) {
+					t->split = strcmp(mode, "split") == 0;
 				} else {
-					fprintf(stderr, "Failed to open directory '%s/'\n", dir);
+					fprintf(stderr, "%s: unknown outmode '%s' (single, split)\n", t->target, mode);
+				}
+			} else if (strncmp(token, EXCLUDE, strlen(EXCLUDE)) == 0) {				//	exclude=a,b
+				string item_save = NULL;
+				for (string p = strtok_r(token + strlen(EXCLUDE), ",", &item_save); p; p = strtok_r(NULL, ",", &item_save)) {
+					List.add(excludes, p);
+				}
+			} else if (Walk.isPattern(token)) {									// wildcards
+				if (Walk.expand(token, t->sources) < 0) {
+					fprintf(stderr, "Failed to open directory for '%s'\n", token);
 				}
-				Mem.free(dir);
 			} else {																			// sources
 				List.add(t->sources, Mem.alloc(strlen(token) + 1));
 				strcpy(List.getAt(t->sources, List.count(t->sources) - 1), token);
 			}
 			
 			//	advance token
-			token = strtok(NULL, " ");
-		}
-	}
-	
-cleanup:
-	Mem.free(copy);
-	return t;
-}
-/**
- * @brief Builds an index of targets in a Doxy2MD file.
- * @param f Open file handle to Doxy2MD.
- * @param indices List to store target_index tuples.
- * @return 0 on success, non-zero if empty or error.
- */
-static int doxy_index_targets(FILE* f, list indices) {
-	char line[MAX_LINE];
-	long pos;
-	
-	//	it is possible to prevent allocation of copy
-	while (fgets(line, MAX_LINE, f)) {
-		//	skip comments and new lines
-		if (line[0] == '#' || line[0] == '\n') continue;
-		
-		pos = ftell(f) - strlen(line);	//	start of line
-		string copy = Mem.alloc(strlen(line) + 1);
-		strcpy(copy, line);
-		
-		//	split target from body
-		char* colon = strchr(copy, ':');
-		if (!colon) {
-			//	invalid target configuration
-			Mem.free(copy);
-			continue;
+			token = strtok_r(NULL, " ", &save);
 		}
 		
-		*colon = '\0';
-		string target_name = trim(copy);
-		
-		target_index ti = Mem.alloc(sizeof(struct index_s));
-		//	set the target name
-		ti->name = Mem.alloc(strlen(target_name) + 1);
-		strcpy(ti->name, target_name);
-		//	set the target line start
-		ti->offset = pos;
-		List.add(indices, ti);
-		
-		Mem.free(copy);
-	}
-	
-	return List.count(indices) > 0 ? 0 : 1;
-}
-/**
- * @brief Finds a target’s file offset in the index.
- * @param indices List of target_index tuples.
- * @param name Target name to find.
- * @return File offset if found, -1 if not.
- */
-static long find_offset(list indices, const string name) {
-	long offset = -1;
-	iterator it = Array.getIterator(indices, LIST);
-	while (Iterator.hasNext(it)) {
-		target_index ti = Iterator.next(it);
-		if (strcmp(ti->name, name) == 0) {
-			offset = ti->offset;
-			goto cleanup;
+		//	drop excluded and repeated sources, keeping the first position
+		list kept = List.new(List.count(t->sources) + 1);
+		strmap seen = StrMap.new(List.count(t->sources) + 1);
+		for (int i = 0; i < List.count(t->sources); i++) {
+			string path = List.getAt(t->sources, i);
+			int drop = StrMap.get(seen, path) != NULL;
+			for (int j = 0; !drop && j < List.count(excludes); j++) drop = Walk.match(List.getAt(excludes, j), path);
+			if (drop) {
+				Mem.free(path);
+			} else {
+				StrMap.put(seen, path, path);
+				List.add(kept, path);
+			}
 		}
+		StrMap.free(seen);
+		List.free(t->sources);
+		t->sources = kept;
+		List.free(excludes);
 	}
 	
 cleanup:
-	Iterator.free(it);
-	return offset;
+	Mem.free(copy);
+	return t;
 }
 /**
  * @brief Frees a Target and its resources.
@@ -316,306 +613,732 @@ static void free_target(target t) {
 	Mem.free(t);
 }
 /**
- * @brief Processes a Target, generating its Markdown output.
- * @param t Target to process.
+ * @brief Builds a target's output path: [outdir/]<output or name.md>
+ * @param name Target name.
+ * @param outdir Output directory, or NULL.
+ * @param output Output override, or NULL.
+ * @return Allocated path (caller frees).
+ */
+static string target_outfile(const string name, const string outdir, const string output) {
+	string_builder outfile_sb = StringBuilder.new(MAX_TARGET);
+	if (outdir) {
+		StringBuilder.appendf(outfile_sb, "%s/", outdir);
+	}
+	StringBuilder.append(outfile_sb, output ? output : name);
+	if (!output) StringBuilder.append(outfile_sb, ".md");
+	
+	string outfile = StringBuilder.toString(outfile_sb);
+	StringBuilder.free(outfile_sb);
+	return outfile;
+}
+/**
+ * @brief Parses a target's sources, handing their units over in source order.
+ * @details Each file is parsed on a worker into its own unit; units are handed
+ *			to the callback in source order, so the result does not depend on the
+ *			number of workers, and released right after.
+ * @param sources Source files to parse.
+ * @param config Configuration (debug flag, worker count).
+ * @param emit Callback receiving each unit with comments.
+ * @param ctx Callback context.
+ * @return 0 on success, non-zero if a source or the callback failed.
  */
-static int process_target(target t, list comments, doxy_config* config) {
-	//	checking sources to process ...
-	iterator it = NULL;
+static int parse_sources(list sources, doxy_config* config, unit_fn emit, object ctx) {
+	int count = List.count(sources);
 	int ret = 0;
+	if (count == 0) return ret;
 	
-	if (t && t->sources) {
-		it = Array.getIterator(t->sources, LIST);
-		if (IS_DEBUG) printf("Processing target (%s)\n", t->target);
-	} else if (config->sources) {
-		if (IS_DEBUG) printf("Processing target (%s)\n", config->target);
-		if (IS_DEBUG) printf("(allocating iterator on config sources)\n");
-		it = Array.getIterator(config->sources, LIST);
-	} else {
-		ret = 1;
-		goto cleanup;
-	}
+	job_queue queue = start_jobs(sources, config);
+	if (!queue) return 1;
 	
-	int i = 0;
-	while (Iterator.hasNext(it)) {
-		string source = Iterator.next(it);
-		if (IS_DEBUG) printf("   Processing file [%d]=%s\n", i, source);
-		ret = process_file(source, comments);
+	//	consume in source order, stopping at the first failed source
+	for (int i = 0; i < count && ret == 0; i++) {
+		parse_job job = wait_job(queue, i);
+		if (config->is_debug) flush_log(job, i);
+		ret = job->ret;
 		
-		if (ret != 0) {
-			goto cleanup;
-		}
-		++i;
+		unit u = job->result;
+		job->result = NULL;
+		if (u && ret == 0 && u->count > 0) ret = emit(u, ctx);
+		free_unit(u);
+		finish_job(queue, i);
 	}
-		
-	//	build output file w/ output directory
-	string_builder outfile_sb = StringBuilder.new(MAX_TARGET);
-	if (t->outdir) {
-		StringBuilder.appendf(outfile_sb, "%s/", t->outdir);
+	stop_jobs(queue);
+	
+	return ret;
+}
+/**
+ * @brief Starts parsing source files on a pool of workers.
+ * @details Workers run at most two jobs per worker ahead of the consumer, so
+ *			parse results held in memory are bounded by the window rather than the
+ *			number of sources.
+ * @param sources Source files to parse.
+ * @param config Configuration (debug flag, worker count, cache).
+ * @return Running queue (finish with stop_jobs), or NULL on failure.
+ */
+static job_queue start_jobs(list sources, doxy_config* config) {
+	int count = List.count(sources);
+	job_queue queue = Mem.alloc(sizeof(struct job_queue_s));
+	if (!queue) return NULL;
+	queue->jobs = Mem.alloc((count ? count : 1) * sizeof(struct parse_job_s));
+	if (!queue->jobs) {
+		Mem.free(queue);
+		return NULL;
+	}
+	queue->count = count;
+	queue->next = 0;
+	queue->consumed = 0;
+	queue->cache_dir = config->cache_dir;
+	queue->config = config;
+	for (int i = 0; i < count; i++) {
+		parse_job job = &queue->jobs[i];
+		job->filename = List.getAt(sources, i);
+		job->result = NULL;
+		job->log = config->is_debug ? StringBuilder.new(256) : NULL;
+		job->ret = 0;
+		job->dropped = 0;
+		job->done = 0;
 	}
-	StringBuilder.append(outfile_sb, config->output ? config->output : t->target);
-	if (!config->output) StringBuilder.append(outfile_sb, ".md");
 	
-	//	output documentation - if an output override is not give we have to allocate the space
-	string outfile = StringBuilder.toString(outfile_sb);
+	int workers = config->jobs > 0 ? config->jobs : (int)sysconf(_SC_NPROCESSORS_ONLN);
+	if (workers > count) workers = count;
+	if (workers < 1) workers = 1;
+	queue->window = workers * 2;
 	
-	/*
-	FILE* out = fopen(outfile, "w");
-	if (out) {
-		StringBuilder.toStream(sb, out);
-		//fprintf(out, "%s", StringBuilder.toString(sb));
-		fclose(out);
-	} else {
-		fprintf(stderr, "Failed to open target %s\n", outfile);
-		ret = 1;
-	}
-	*/
-	
-	if (config->output) {
-		if (strcmp(config->output, outfile) != 0) {
-			//	clear the string and copy outfile to config->output
-			Mem.free(config->output);
-			// allocate config->output and copy outfile
-			config->output = Mem.alloc(strlen(outfile) + 1);
-			strcpy(config->output, outfile);
+	pthread_mutex_init(&queue->lock, NULL);
+	pthread_cond_init(&queue->ready, NULL);
+	queue->threads = Mem.alloc(workers * sizeof(pthread_t));
+	queue->started = 0;
+	while (queue->threads && queue->started < workers && 
+	       pthread_create(&queue->threads[queue->started], NULL, parse_worker, queue) == 0) {
+		++queue->started;
+	}
+	if (queue->started == 0) {
+		//	no threads: parse everything up front on the calling thread
+		queue->window = count;
+		parse_worker(queue);
+	}
+	
+	return queue;
+}
+/**
+ * @brief Waits for a job to finish.
+ * @param queue Running queue.
+ * @param i Job index; jobs are waited for in order.
+ * @return The finished job.
+ */
+static parse_job wait_job(job_queue queue, int i) {
+	pthread_mutex_lock(&queue->lock);
+	while (!queue->jobs[i].done) pthread_cond_wait(&queue->ready, &queue->lock);
+	pthread_mutex_unlock(&queue->lock);
+	return &queue->jobs[i];
+}
+/**
+ * @brief Hands a job back, letting the workers move the window forward.
+ * @param queue Running queue.
+ * @param i Job index.
+ */
+static void finish_job(job_queue queue, int i) {
+	pthread_mutex_lock(&queue->lock);
+	queue->consumed = i + 1;
+	pthread_cond_broadcast(&queue->ready);
+	pthread_mutex_unlock(&queue->lock);
+}
+/**
+ * @brief Cancels jobs not yet started, joins the workers and frees the queue
+ *			with any results that were not taken.
+ * @param queue Queue to stop.
+ */
+static void stop_jobs(job_queue queue) {
+	pthread_mutex_lock(&queue->lock);
+	queue->next = queue->count;
+	pthread_cond_broadcast(&queue->ready);
+	pthread_mutex_unlock(&queue->lock);
+	for (int i = 0; i < queue->started; i++) {
+		pthread_join(queue->threads[i], NULL);
+	}
+	
+	for (int i = 0; i < queue->count; i++) {
+		if (queue->jobs[i].result) free_unit(queue->jobs[i].result);
+		if (queue->jobs[i].log) StringBuilder.free(queue->jobs[i].log);
+	}
+	
+	pthread_cond_destroy(&queue->ready);
+	pthread_mutex_destroy(&queue->lock);
+	if (queue->threads) Mem.free(queue->threads);
+	Mem.free(queue->jobs);
+	Mem.free(queue);
+}
+/**
+ * @brief Prints a job's buffered debug output.
+ * @param job Finished parse job.
+ * @param i Index of the job's source.
+ */
+static void flush_log(parse_job job, int i) {
+	printf("   Processing file [%d]=%s\n", i, job->filename);
+	string log = StringBuilder.toString(job->log);
+	fputs(log, stdout);
+	Mem.free(log);
+}
+/**
+ * @brief Worker loop: takes jobs from the queue until it is drained.
+ * @param arg The shared job_queue.
+ * @return NULL.
+ */
+static void* parse_worker(void* arg) {
+	job_queue queue = arg;
+	while (1) {
+		pthread_mutex_lock(&queue->lock);
+		while (queue->next < queue->count && queue->next >= queue->consumed + queue->window) {
+			pthread_cond_wait(&queue->ready, &queue->lock);
 		}
-	} else {
-		// allocate config->output and copy outfile
-		config->output = Mem.alloc(strlen(outfile) + 1);
-		strcpy(config->output, outfile);
+		int i = queue->next < queue->count ? queue->next++ : -1;
+		pthread_mutex_unlock(&queue->lock);
+		
+		if (i < 0) break;
+		int ret = process_file(&queue->jobs[i], queue->cache_dir);
+		
+		pthread_mutex_lock(&queue->lock);
+		queue->jobs[i].ret = ret;
+		queue->jobs[i].done = 1;
+		pthread_cond_broadcast(&queue->ready);
+		pthread_mutex_unlock(&queue->lock);
+	}
+	return NULL;
+}
+/**
+ * @brief Parses a single source file on the calling thread, using the cache.
+ * @param config Configuration (debug flag, cache).
+ * @param path Source file to parse.
+ * @param out Output: unit, or NULL if the file has no comment blocks.
+ * @return 0 on success, non-zero on failure.
+ */
+static int parse_file(doxy_config* config, const string path, unit* out) {
+	struct parse_job_s job = { path, NULL, config->is_debug ? StringBuilder.new(256) : NULL, 0, 0, 0 };
+	job.ret = process_file(&job, config->cache_dir);
+	if (job.log) {
+		flush_log(&job, 0);
+		StringBuilder.free(job.log);
 	}
 	
-	Mem.free(outfile);
-	StringBuilder.free(outfile_sb);
+	if (job.ret != 0) {
+		free_unit(job.result);
+		job.result = NULL;
+	}
+	*out = job.result;
+	return job.ret;
+}
+/**
+ * @brief Processes a source file into a unit of Doxygen comments.
+ * @details Unchanged sources are loaded from the parse cache. Otherwise the source
+ *			is mapped and walked in place; comment fields are spans into the
+ *			mapping. The comments and their pools live in the unit's arena.
+ * @param job Parse job naming the source; receives the unit and debug log.
+ * @param cache_dir Parse cache directory, or NULL.
+ * @return 0 on success, non-zero on failure.
+ */
+static int process_file(parse_job job, const string cache_dir) {
+	long begin = Stats.now();
+	source_stamp stamp;
+	int cached = cache_dir && Source.stat(job->filename, &stamp) == 0;
+	if (cached && Cache.load(cache_dir, job->filename, &stamp, &job->result)) {
+		JOB_LOG(job, "Cache hit\n");
+		Stats.file(job->filename, stamp.size, job->result ? job->result->count : 0, 0, 1, begin);
+		return 0;
+	}
 	
-cleanup:
-	if (it) Iterator.free(it);
+	source s = Source.open(job->filename);
+	if (!s) {
+		fprintf(stderr, "Failed to open source '%s'\n", job->filename);
+		return 1;
+	}
+	
+	int ret = parse_source(job, s);
+	if (ret == 0 && cached) Cache.store(cache_dir, &stamp, s, job->result);
+	Stats.file(job->filename, s->size, job->result ? job->result->count : 0, job->dropped, 0, begin);
+	Source.release(s);
 	return ret;
 }
 /**
- * @brief Processes a source file, appending Doxygen comments to the string builder.
- * @param filename Source file to process.
- * @param sb StringBuilder to append documentation to.
+ * @brief Parses the comment blocks of a mapped source into the job's unit.
+ * @details Blocks accumulate in one set of growable buffers for the whole
+ *			source; a discarded block is truncated away and the buffers are
+ *			sealed into the unit's flat arrays at the end.
+ * @param job Parse job; receives the unit (left NULL without comment blocks).
+ * @param s Mapped source.
  * @return 0 on success, non-zero on failure.
  */
-static int process_file(const string filename, list comments) {
-	FILE* in = fopen(filename, "r");
-	if (!in) {
-		fprintf(stderr, "Failed to open source '%s'\n", filename);
+static int parse_source(parse_job job, source s) {
+	const char* end = s->data + s->size;
+	scan_state lex = { .base = s->data };
+	const char* open = Scan.nextBlock(s->data, end, &lex);
+	if (open == end) {
+		JOB_LOG(job, "No comment blocks\n");
+		return 0;
+	}
+	
+	unit u = new_unit(s);
+	if (!u) {
 		return 1;
 	}
-
-	char line[MAX_LINE];
-	int in_comment = 0;
-	comment c = NULL;
-	TAGTYPE lastTagType = NONE; // Track last tag for continuation lines
-	
-	while (fgets(line, MAX_LINE, in)) {
-		string trimmed = trim(line);
-		//printf("Line: '%s'\n", trimmed); // Debug: see every line
-		
-		if (strncmp(trimmed, DOXTAG, strlen(DOXTAG)) == 0) {
-			in_comment = 1;
-			c = init_comment();
-			if (!c) {
-				fclose(in);
-				return 1;
-			}
-			c->filename = Mem.alloc(strlen(filename) + 1);	// set filename
-			strcpy(c->filename, filename);
-			if (IS_DEBUG) printf("Start comment block\n"); 	// Debug
-			continue;
+	job->result = u;
+	
+	const char* line;
+	size_t len;
+	int ret = 0;
+	struct block_buf_s buf = { 0 };	//	comments of the source and the open block
+	
+	for (; open < end; open = Scan.nextBlock(open, end, &lex)) {
+		const char* close = Scan.findClose(open + 3, end);
+		if (close == end) {
+			job->dropped++;				//	unterminated at end of file
+			break;
 		}
-
-		if (in_comment && strstr(trimmed, "*/")) {
-			in_comment = 0;
-			if (!c->is_file) {
-				c->signature = extract_signature(in, &c->func_name, &c->ret_type);
-			}
-			if (IS_DEBUG) printf("End comment block, signature: '%s' (%s -> %s)\n", 
-										c->signature ? c->signature : "none",
-										c->func_name ? c->func_name : "none",
-										c->ret_type ? c->ret_type : "none");
-			// keep comment if it has any content
-			if (c->brief || StringBuilder.length(c->details) > 0 || List.count(c->params) > 0 || 
-			    c->ret || (c->signature && strlen(trim(c->signature)) > 0)) {			//	skip empty signatures
-				List.add(comments, c);
-			} else {
-				free_comment(c);
-			}
-			c = NULL;
-			continue;
+		comment c = open_block(&buf, s);
+		if (!c) {
+			ret = 1;
+			goto cleanup;
 		}
-
-		if (in_comment) {
-			TAGTYPE tagType = NONE;
-			string result = parse_comment_line(trimmed, &tagType);
-			if (result) {
-				if (IS_DEBUG) printf("Parsed: '%s' (param=%d, ret=%d)\n", result, tagType == PARAM, tagType == RETRN); // Debug
-				if (tagType == PARAM) {
-					List.add(c->params, result);
-				} else if (tagType == RETRN) {
-					c->ret = result;
-				} else if (tagType == BRIEF) {
-					c->brief = result;
-				} else if (tagType == DTAIL) {
-					StringBuilder.lappends(c->details, result);
-					Mem.free(result);		//	free result since sb copies result
-				} else if (tagType == NONE && strncmp(trimmed, DOXFILE, strlen(DOXFILE)) == 0) {
-					c->is_file = 1;
-					Mem.free(result);
-				} else {
-					Mem.free(result);
+		JOB_LOG(job, "Start comment block\n"); 	// Debug
+		
+		//	the lines of the block, from after "/ **" up to "* /" on their own lines
+		const char* cursor = open + 3;
+		int section = -1;				//	section that takes continuation lines
+		while ((line = next_line(&cursor, close, &len))) {
+			if (len == 0) {					//	also the rest of "/ **" and the indent of "* /"
+				if (section >= 0 && buf.tags.items[section].kind != TAG_DETAILS) section = -1;
+				continue;
+			}
+			tag t;
+			size_t tlen;
+			const char* text = lex_tag(s, line, len, &t, &tlen);
+			if (t.kind == TAG_FILE) {
+				c->is_file = 1;
+				section = -1;
+			} else if (t.kind != TAG_NONE) {
+				JOB_LOG(job, "Parsed: '%.*s' (param=%d, ret=%d)\n", (int)tlen, text, t.kind == TAG_PARAM, t.kind == TAG_RETURN); // Debug
+				t.first = buf.lines.count - buf.line_mark;
+				t.count = tlen > 0;
+				if ((tlen > 0 && push_span(&buf.lines, make_span(s, text, tlen)) != 0) || push_tag(&buf, t) != 0) {
+					ret = 1;
+					goto cleanup;
 				}
-				lastTagType = tagType;	//	update last tag
-			} else if (lastTagType == DTAIL && trimmed[0] == '*') {	// continuation line
-				string continuation = trim(trimmed + 1);					// skip '*'
-				if (strlen(continuation) > 0) {
-					if (IS_DEBUG) printf("-       '%s' (param=0, ret=0)\n", continuation);
-					StringBuilder.lappends(c->details, continuation);
+				section = buf.tags.count - 1;
+			} else if (section < 0) {
+				continue;					//	untagged text before any section
+			} else if (tlen > 0) {			//	continuation line
+				JOB_LOG(job, "-       '%.*s' (param=0, ret=0)\n", (int)tlen, text);
+				if (push_span(&buf.lines, make_span(s, text, tlen)) != 0) {
+					ret = 1;
+					goto cleanup;
 				}
+				buf.tags.items[section].count++;
+			} else if (buf.tags.items[section].kind != TAG_DETAILS) {
+				section = -1;				//	a blank line ends every section but details
 			}
 		}
+		
+		//	the declaration may follow on the closer's line
+		open = close + 2;
+		if (!c->is_file && extract_signature(c, &buf, &open, end) != 0) {
+			ret = 1;
+			goto cleanup;
+		}
+		if (open < close + 2) open = close + 2;	//	stopped on a block sharing the closer's line
+		JOB_LOG(job, "End comment block, %s: '%.*s' (%.*s -> %.*s)\n", Decl.name(c->kind),
+									SPAN_ARGS(s, c->signature, "none"),
+									SPAN_ARGS(s, c->func_name, "none"),
+									SPAN_ARGS(s, c->ret_type, "none"));
+		// keep comment if it has any content
+		if (buf.lines.count > buf.line_mark || c->signature.length) {
+			keep_block(&buf);
+		} else {
+			job->dropped++;
+		}
 	}
+	ret = seal_unit(u, &buf);
 
-	if (c) free_comment(c);
-	fclose(in);
+cleanup:
+	if (buf.lines.items) Mem.free(buf.lines.items);
+	if (buf.tags.items) Mem.free(buf.tags.items);
+	if (buf.params.items) Mem.free(buf.params.items);
+	if (buf.comments) Mem.free(buf.comments);
+	return ret;
+}
+/**
+ * @brief Appends a line or parameter to a list of the open block.
+ * @return 0 on success, non-zero if the buffer cannot grow.
+ */
+static int push_span(span_list* l, span line) {
+	if (l->count == l->capacity) {
+		int capacity = l->capacity ? l->capacity * 2 : 32;
+		span* items = Mem.alloc(capacity * sizeof(span));
+		if (!items) return 1;
+		if (l->items) {
+			memcpy(items, l->items, l->count * sizeof(span));
+			Mem.free(l->items);
+		}
+		l->items = items;
+		l->capacity = capacity;
+	}
+	l->items[l->count++] = line;
+	return 0;
+}
+/**
+ * @brief Appends a tag to the open block.
+ * @return 0 on success, non-zero if the buffer cannot grow.
+ */
+static int push_tag(struct block_buf_s* buf, tag t) {
+	tag_list* l = &buf->tags;
+	if (l->count == l->capacity) {
+		int capacity = l->capacity ? l->capacity * 2 : 16;
+		tag* items = Mem.alloc(capacity * sizeof(tag));
+		if (!items) return 1;
+		if (l->items) {
+			memcpy(items, l->items, l->count * sizeof(tag));
+			Mem.free(l->items);
+		}
+		l->items = items;
+		l->capacity = capacity;
+	}
+	l->items[l->count++] = t;
 	return 0;
 }
 /**
- * @brief Initializes a new comment struct.
- * @return Allocated comment or NULL on failure.
+ * @brief Starts a block in the slot after the kept comments, dropping the
+ *			lines, tags and parameters of a block left open.
+ * @param buf Comments of the source.
+ * @param s Source being parsed.
+ * @return Comment of the block, or NULL if the buffer cannot grow.
  */
-static comment init_comment() {
-	comment c = Mem.alloc(sizeof(struct comment_s));
-	if (c) {
-		c->brief = NULL;
-		c->details = StringBuilder.new(128);
-		c->params = List.new(4);
-		c->ret = NULL;
-		c->signature = NULL;
-		c->func_name = NULL;
-		c->ret_type = NULL;
-		c->is_file = 0;
-		c->filename = NULL;
+static comment open_block(struct block_buf_s* buf, source s) {
+	if (buf->count == buf->capacity) {
+		int capacity = buf->capacity ? buf->capacity * 2 : 16;
+		struct comment_s* items = Mem.alloc(capacity * sizeof(struct comment_s));
+		if (!items) return NULL;
+		if (buf->comments) {
+			memcpy(items, buf->comments, buf->count * sizeof(struct comment_s));
+			Mem.free(buf->comments);
+		}
+		buf->comments = items;
+		buf->capacity = capacity;
 	}
+	buf->lines.count = buf->line_mark;
+	buf->tags.count = buf->tag_mark;
+	buf->params.count = buf->param_mark;
 	
+	comment c = &buf->comments[buf->count];
+	memset(c, 0, sizeof(struct comment_s));
+	c->src = s;
 	return c;
 }
 /**
- * @brief Frees a Comment and its resources.
- * @param c Comment to free.
+ * @brief Keeps the open block: its runs of lines, tags and parameters become
+ *			the comment's (placed when the unit is sealed).
+ * @param buf Comments of the source.
  */
-void free_comment(comment c) {
-	if (!c) return;
-	if (c->brief) Mem.free(c->brief);
-	if (c->details) StringBuilder.free(c->details);
-	if (c->params) {
-		for (int i = 0; i < List.count(c->params); i++) {
-			Mem.free(List.getAt(c->params, i));
-		}
-		List.free(c->params);
+static void keep_block(struct block_buf_s* buf) {
+	comment c = &buf->comments[buf->count++];
+	c->lines.count = buf->lines.count - buf->line_mark;
+	c->tags.count = buf->tags.count - buf->tag_mark;
+	c->params.count = buf->params.count - buf->param_mark;
+	buf->line_mark = buf->lines.count;
+	buf->tag_mark = buf->tags.count;
+	buf->param_mark = buf->params.count;
+}
+/**
+ * @brief Copies the kept comments and their lines, tags and parameters into
+ *			exactly sized arrays of the unit's arena.
+ * @details Blocks were kept in source order, so each comment's views are the
+ *			next runs of the pools.
+ * @param u Unit receiving the comments.
+ * @param buf Comments of the source.
+ * @return 0 on success, non-zero on failure.
+ */
+static int seal_unit(unit u, const struct block_buf_s* buf) {
+	int count = buf->count;
+	int lines = buf->line_mark;
+	int tags = buf->tag_mark;
+	int params = buf->param_mark;
+	if (count == 0) return 0;
+	
+	u->comments = Arena.alloc(u->mem, count * sizeof(struct comment_s));
+	span* line_pool = lines ? Arena.alloc(u->mem, lines * sizeof(span)) : NULL;
+	tag* tag_pool = tags ? Arena.alloc(u->mem, tags * sizeof(tag)) : NULL;
+	span* param_pool = params ? Arena.alloc(u->mem, params * sizeof(span)) : NULL;
+	if (!u->comments || (lines && !line_pool) || (tags && !tag_pool) || (params && !param_pool)) return 1;
+	
+	memcpy(u->comments, buf->comments, count * sizeof(struct comment_s));
+	if (lines) memcpy(line_pool, buf->lines.items, lines * sizeof(span));
+	if (tags) memcpy(tag_pool, buf->tags.items, tags * sizeof(tag));
+	if (params) memcpy(param_pool, buf->params.items, params * sizeof(span));
+	for (int i = 0; i < count; i++) {
+		comment c = &u->comments[i];
+		c->lines.items = c->lines.count ? line_pool : NULL;
+		c->tags.items = c->tags.count ? tag_pool : NULL;
+		c->params.items = c->params.count ? param_pool : NULL;
+		c->lines.capacity = c->lines.count;
+		c->tags.capacity = c->tags.count;
+		c->params.capacity = c->params.count;
+		line_pool += c->lines.count;
+		tag_pool += c->tags.count;
+		param_pool += c->params.count;
+	}
+	u->count = count;
+	return 0;
+}
+/**
+ * @brief Creates an empty unit for a source.
+ * @param s Source the unit's spans view into; the unit takes a reference.
+ * @return Unit with its own arena, or NULL on failure.
+ */
+unit new_unit(source s) {
+	arena mem = Arena.new(UNIT_BLOCK);
+	unit u = mem ? Arena.alloc(mem, sizeof(struct unit_s)) : NULL;
+	if (!u) {
+		Arena.free(mem);
+		return NULL;
+	}
+	u->src = Source.retain(s);
+	u->mem = mem;
+	u->comments = NULL;
+	u->count = 0;
+	u->refs = 1;
+	return u;
+}
+/**
+ * @brief Drops a reference to a unit; releases its mapping and arena when
+ *			none remain.
+ * @param u Unit to release.
+ */
+void free_unit(unit u) {
+	if (!u || --u->refs > 0) return;
+	Source.release(u->src);
+	Arena.free(u->mem);		//	u lives in its own arena
+}
+/**
+ * @brief Releases parsed units: one arena and one mapping per source.
+ * @param units List of units returned by parseDoxy; freed as well.
+ */
+static void release_units(list units) {
+	if (!units) return;
+	for (int i = 0; i < List.count(units); i++) {
+		free_unit(List.getAt(units, i));
+	}
+	List.free(units);
+}
+/**
+ * @brief Frees a document and drops its unit references.
+ * @param d Document to free.
+ */
+static void free_document(document d) {
+	Symbols.free(d->symbols);
+	for (int i = 0; i < List.count(d->units); i++) {
+		free_unit(List.getAt(d->units, i));
+	}
+	List.free(d->units);
+	for (int i = 0; i < List.count(d->sources); i++) {
+		Mem.free(List.getAt(d->sources, i));
 	}
-	if (c->ret) Mem.free(c->ret);
-	if (c->signature) Mem.free(c->signature);
-	if (c->func_name) Mem.free(c->func_name);
-	if (c->ret_type) Mem.free(c->ret_type);
-	if (c->filename) Mem.free(c->filename);
+	List.free(d->sources);
+	Mem.free(d->name);
+	Mem.free(d->output);
+	Mem.free(d);
+}
+/**
+ * @brief Releases documents returned by parseTargets; shared units are freed
+ *			with their last document.
+ * @param documents List of documents; freed as well.
+ */
+static void release_documents(list documents) {
+	if (!documents) return;
+	for (int i = 0; i < List.count(documents); i++) {
+		free_document(List.getAt(documents, i));
+	}
+	List.free(documents);
+}
+/**
+ * @brief Lexes the declaration after a comment block.
+ * @details The declaration may span lines up to its terminating `{` or `;`;
+ *			its text, name and return type become spans of the comment and its
+ *			parameters go to the block buffer.
+ * @param c Comment receiving the declaration.
+ * @param buf Block buffer receiving the parameters.
+ * @param cursor In/out: read position after "* /"; moved past the declaration's terminator line.
+ * @param end End of the source buffer.
+ * @return 0 on success, non-zero if the parameters cannot be stored.
+ */
+static int extract_signature(comment c, struct block_buf_s* buf, const char** cursor, const char* end) {
+	decl d;
+	*cursor = Decl.lex(*cursor, end, &d);
+	if (d.text.len == 0) return 0;
 	
-	Mem.free(c);
+	c->kind = d.kind;
+	c->signature = make_span(c->src, d.text.p, d.text.len);
+	//	without a name (anonymous enum, unrecognized text) the whole text is the title
+	c->func_name = d.name.len ? make_span(c->src, d.name.p, d.name.len) : c->signature;
+	if (d.type.len) c->ret_type = make_span(c->src, d.type.p, d.type.len);
+	for (int i = 0; i < d.params; i++) {
+		if (push_span(&buf->params, make_span(c->src, d.param[i].p, d.param[i].len)) != 0) return 1;
+	}
+	return 0;
 }
 /**
- * @brief Extracts the signature line after a comment block.
- * @param in File pointer positioned after "* /".
- * @return Allocated signature string or NULL.
+ * @brief Lexes the section command at the start of a comment line.
+ * @details One pass over the line: the optional leading `*`, the command
+ *			(`@name` or `\name`), a `[in,out]` direction, then the text. For
+ *			param, tparam, retval and throws the first word of the text is also
+ *			kept as the tag's argument.
+ * @param s Source the line belongs to.
+ * @param line Trimmed line inside a comment block.
+ * @param len Length of the line.
+ * @param t Output: kind (TAG_NONE for plain text), name, direction and argument.
+ * @param text_len Output: length of the text.
+ * @return Start of the text after the command and its argument (the whole
+ *			line content for plain text).
  */
-static string extract_signature(FILE* in, string* func_name, string* ret_type) {
-	char line[MAX_LINE];
-	while (fgets(line, MAX_LINE, in) && trim(line)[0] == '\0'); // Skip empty lines
-	if (feof(in)) return NULL;
-
-	string copy = Mem.alloc(strlen(trim(line)) + 1);
-	strcpy(copy, trim(line));
-	char* brace = strchr(copy, '{');
-	char* semi = strchr(copy, ';');
-	if (brace) *brace = '\0';
-	if (semi) *semi = '\0';
-	string signature = Mem.alloc(strlen(trim(copy)) + 1);
-	strcpy(signature, trim(copy));
-	
-	//	extract func_name and ret_type
-	char* paren = strchr(signature, O_PAREN);
-	if (paren) {
-		// Work backward from ( to find function name start
-		string name_end = paren - 1;
-		while (name_end > signature && (*name_end == ' ' || *name_end == '\t')) name_end--; // Skip trailing spaces
-		string name_start = name_end;
-		while (name_start > signature && (*name_start == '*' || isalnum(*name_start) || *name_start == '_')) name_start--; // Include * and identifier
-		if (name_start > signature && (*name_start == ' ' || *name_start == '\t')) name_start++; // Move past space
-
-		// Extract function name
-		size_t name_len = name_end - name_start + 1;
-		*func_name = Mem.alloc(name_len + 1);
-		strncpy(*func_name, name_start, name_len);
-		(*func_name)[name_len] = '\0';
-
-		// Extract return type (everything before name_start)
-		if (name_start > signature) {
-			size_t type_len = name_start - signature - 1; // Exclude the space
-			*ret_type = Mem.alloc(type_len + 1);
-			strncpy(*ret_type, signature, type_len);
-			(*ret_type)[type_len] = '\0';
-		} else {
-			*ret_type = NULL; // No return type found
+static const char* lex_tag(source s, const char* line, size_t len, tag* t, size_t* text_len) {
+	const char* end = line + len;
+	const char* p = line;
+	t->kind = TAG_NONE;
+	t->dir = 0;
+	t->name.length = t->arg.length = 0;
+	t->name.offset = t->arg.offset = 0;
+	
+	while (p < end && *p == '*') p++;
+	while (p < end && (*p == ' ' || *p == '\t')) p++;
+	const char* text = p;
+	
+	if (p < end && (*p == '@' || *p == '\\')) {
+		const char* name = ++p;
+		while (p < end && ((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z'))) p++;
+		size_t name_len = p - name;
+		tag_kind kind = name_len ? lookup_tag(name, name_len) : TAG_NONE;
+		
+		if (kind == TAG_PARAM && p < end && *p == '[') {
+			const char* close = memchr(p, ']', end - p);
+			if (close) {
+				for (const char* d = p + 1; d + 1 < close; d++) {
+					if (d[0] == 'i' && d[1] == 'n') t->dir |= PARAM_IN;
+					if (d + 2 < close && d[0] == 'o' && d[1] == 'u' && d[2] == 't') t->dir |= PARAM_OUT;
+				}
+				p = close + 1;
+			}
+		}
+		//	a command is a whole word: "@briefly" is text
+		if (kind != TAG_NONE && (p == end || *p == ' ' || *p == '\t')) {
+			t->kind = kind;
+			t->name = make_span(s, name, name_len);
+			while (p < end && (*p == ' ' || *p == '\t')) p++;
+			text = p;
+			if (kind == TAG_PARAM || kind == TAG_TPARAM || kind == TAG_RETVAL || kind == TAG_THROWS) {
+				const char* w = p;
+				while (w < end && *w != ' ' && *w != '\t') w++;
+				t->arg = make_span(s, p, w - p);
+				for (p = w; p < end && (*p == ' ' || *p == '\t'); p++);
+				text = p;					//	the text follows the argument
+			}
 		}
-	} else {
-		// No paren: treat whole signature as function name (e.g., struct definition)
-		*func_name = Mem.alloc(strlen(signature) + 1);
-		strcpy(*func_name, signature);
-		*ret_type = NULL;
 	}
 	
-	Mem.free(copy);
-	return signature;
+	*text_len = end - text;
+	return text;
 }
 /**
- * @brief Parses a single Doxygen comment line and identifies its type.
- * @param line Line to parse (e.g., "* @brief Short desc").
- * @param is_param Output flag: 1 if line is a param, 0 otherwise.
- * @param is_ret Output flag: 1 if line is a return, 0 otherwise.
- * @return Allocated string with the content (caller frees), or NULL if not a tagged line.
+ * @brief Maps a command name to its section kind.
+ * @details Dispatches on the first letter and the length, so a name costs one
+ *			switch and at most a few fixed-size compares.
+ * @param name Command name (without `@` or `\`).
+ * @param n Length of the name.
+ * @return Section kind, or TAG_NONE for inline and unknown commands.
  */
-static string parse_comment_line(const string line, TAGTYPE* tagType) {
-	 *tagType = NONE;
-	 string trimmed = trim(line);
-	 string tag = NULL;
-
-	int tagLen = 0;
-	if (strncmp(trimmed, DOXBRIEF, (tagLen = strlen(DOXBRIEF))) == 0) {
-		*tagType = BRIEF;
-		tag = Mem.alloc(strlen(trimmed + tagLen) + 1);
-		strcpy(tag, trim(trimmed + tagLen));
-	} else if (strncmp(trimmed, DOXDTAIL, (tagLen = strlen(DOXDTAIL))) == 0 || 
-		      strncmp(trimmed, "* @detail", 9) == 0) { // Fixed condition
-		*tagType = DTAIL;
-		tagLen = strncmp(trimmed, DOXDTAIL, strlen(DOXDTAIL)) == 0 ? strlen(DOXDTAIL) : 9;
-		tag = Mem.alloc(strlen(trimmed + tagLen) + 1);
-		strcpy(tag, trim(trimmed + tagLen));
-	} else if (strncmp(trimmed, DOXPARAM, (tagLen = strlen(DOXPARAM))) == 0) {
-		*tagType = PARAM;
-		tag = Mem.alloc(strlen(trimmed + tagLen) + 1);
-		strcpy(tag, trim(trimmed + tagLen));
-	} else if (strncmp(trimmed, DOXRETRN, (tagLen = strlen(DOXRETRN))) == 0) {
-		*tagType = RETRN;
-		tag = Mem.alloc(strlen(trimmed + tagLen) + 1);
-		strcpy(tag, trim(trimmed + tagLen));
-	} else if (strncmp(trimmed, DOXFILE, (tagLen = strlen(DOXFILE))) == 0) {
-		*tagType = NONE;		// treat as metadata, not content
-		tag = Mem.alloc(strlen(trimmed + tagLen) + 1);
-		strcpy(tag, trim(trimmed + tagLen));
+static tag_kind lookup_tag(const char* name, size_t n) {
+#define TAG_IS(lit) (n == sizeof(lit) - 1 && memcmp(name, lit, sizeof(lit) - 1) == 0)
+	switch (name[0]) {
+		case 'a':
+			if (TAG_IS("author") || TAG_IS("authors")) return TAG_AUTHOR;
+			if (TAG_IS("attention")) return TAG_WARNING;
+			break;
+		case 'b':
+			if (TAG_IS("brief")) return TAG_BRIEF;
+			if (TAG_IS("bug")) return TAG_TODO;
+			break;
+		case 'd':
+			if (TAG_IS("details") || TAG_IS("detail")) return TAG_DETAILS;
+			if (TAG_IS("deprecated")) return TAG_DEPRECATED;
+			break;
+		case 'e':
+			if (TAG_IS("exception")) return TAG_THROWS;
+			break;
+		case 'f':
+			if (TAG_IS("file")) return TAG_FILE;
+			break;
+		case 'n':
+			if (TAG_IS("note")) return TAG_NOTE;
+			break;
+		case 'p':
+			if (TAG_IS("param")) return TAG_PARAM;
+			if (TAG_IS("pre")) return TAG_PRE;
+			if (TAG_IS("post")) return TAG_POST;
+			break;
+		case 'r':
+			if (TAG_IS("return") || TAG_IS("returns") || TAG_IS("result")) return TAG_RETURN;
+			if (TAG_IS("retval")) return TAG_RETVAL;
+			if (TAG_IS("remark") || TAG_IS("remarks")) return TAG_NOTE;
+			break;
+		case 's':
+			if (TAG_IS("see") || TAG_IS("sa")) return TAG_SEE;
+			if (TAG_IS("short")) return TAG_BRIEF;
+			if (TAG_IS("since")) return TAG_SINCE;
+			break;
+		case 't':
+			if (TAG_IS("tparam")) return TAG_TPARAM;
+			if (TAG_IS("throws") || TAG_IS("throw")) return TAG_THROWS;
+			if (TAG_IS("todo")) return TAG_TODO;
+			break;
+		case 'v':
+			if (TAG_IS("version")) return TAG_VERSION;
+			break;
+		case 'w':
+			if (TAG_IS("warning")) return TAG_WARNING;
+			break;
 	}
-
-	return tag;
+	return TAG_NONE;
+#undef TAG_IS
+}
+/**
+ * @brief Trims spaces, tabs and line endings from both ends of a view.
+ * @param p Start of the view.
+ * @param end One past the end of the view.
+ * @param len Output: length of the trimmed view.
+ * @return Start of the trimmed view.
+ */
+static const char* trim_view(const char* p, const char* end, size_t* len) {
+	while (p < end && (*p == ' ' || *p == '\t')) p++;
+	while (end > p && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r' || end[-1] == '\n')) end--;
+	*len = end - p;
+	return p;
+}
+/**
+ * @brief Returns the next trimmed line of a buffer.
+ * @param cursor In/out: read position; moved past the line terminator.
+ * @param end End of the buffer.
+ * @param len Output: length of the trimmed line.
+ * @return Start of the trimmed line, or NULL at end of buffer.
+ */
+static const char* next_line(const char** cursor, const char* end, size_t* len) {
+	const char* p = *cursor;
+	if (p >= end) return NULL;
+	
+	const char* nl = memchr(p, '\n', end - p);
+	*cursor = nl ? nl + 1 : end;
+	return trim_view(p, nl ? nl : end, len);
+}
+/**
+ * @brief Builds a span from a pointer into a source.
+ */
+static span make_span(source s, const char* p, size_t len) {
+	span sp = { (size_t)(p - s->data), len };
+	return sp;
 }
 /**
  * @brief Trims whitespace from a string.
@@ -656,5 +1379,11 @@ static void append_comment_to_md(string_builder sb, comment c) {
 
 //	=============================================================================
 const IParser Parser = {
-	.parseDoxy = parse_doxy2md
+	.parseDoxy = parse_doxy2md,
+	.streamDocument = stream_document,
+	.parseFile = parse_file,
+	.parseTargets = parse_targets,
+	.resolveTargets = resolve_targets,
+	.release = release_units,
+	.releaseDocuments = release_documents
 };
@@ -0,0 +1,347 @@
+// scan.c
+#include "scan.h"
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+static const char OPENER[] = { '/', '*', '*' };
+static const char CLOSER[] = { '*', '/' };
+
+typedef const char* (*find_fn)(const char*, const char*, const char*, size_t);
+typedef const char* (*special_fn)(const char*, const char*);
+
+static const char* find_scalar(const char*, const char*, const char*, size_t);
+static const char* special_scalar(const char*, const char*);
+#ifdef SCAN_X86
+static const char* find_sse2(const char*, const char*, const char*, size_t);
+static const char* find_avx2(const char*, const char*, const char*, size_t);
+static const char* special_sse2(const char*, const char*);
+static const char* special_avx2(const char*, const char*);
+#endif
+static const char* next_block(const char*, const char*, scan_state*);
+static const char* skip_literal(const char*, const char*);
+static const char* skip_line_comment(const char*, const char*);
+static const char* directive(const char*, const char*, scan_state*);
+static int at_line_start(const char*, const char*);
+
+static find_fn KERNEL = NULL;
+static special_fn SPECIAL = special_scalar;
+static SCANISA KERNEL_ISA = SCAN_SCALAR;
+static pthread_once_t KERNEL_ONCE = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Finds a 2- or 3-byte pattern using memchr on its first byte.
+ * @param p Start of the range.
+ * @param end End of the range.
+ * @param pat Pattern bytes.
+ * @param n Pattern length (2 or 3).
+ * @return Pointer to the match, or end.
+ */
+static const char* find_scalar(const char* p, const char* end, const char* pat, size_t n) {
+	while (end - p >= (ptrdiff_t)n && (p = memchr(p, pat[0], end - p - n + 1))) {
+		if (memcmp(p + 1, pat + 1, n - 1) == 0) return p;
+		++p;
+	}
+	return end;
+}
+
+/**
+ * @brief Finds the next byte the lexer must look at: '/', '"', '\'' or '#'.
+ * @return Pointer to the byte, or end.
+ */
+static const char* special_scalar(const char* p, const char* end) {
+	for (; p < end; p++) {
+		if (*p == '/' || *p == '"' || *p == '\'' || *p == '#') return p;
+	}
+	return end;
+}
+
+#ifdef SCAN_X86
+/**
+ * @brief SSE2 kernel: compares 16 positions per step against each pattern byte.
+ */
+__attribute__((target("sse2")))
+static const char* find_sse2(const char* p, const char* end, const char* pat, size_t n) {
+	const __m128i a = _mm_set1_epi8(pat[0]);
+	const __m128i b = _mm_set1_epi8(pat[1]);
+	const __m128i c = _mm_set1_epi8(pat[n - 1]);
+	const size_t skip = n - 1;		//	offset of the last pattern byte
+
+	while (end - p >= (ptrdiff_t)(16 + skip)) {
+		__m128i m = _mm_and_si128(
+			_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), a),
+			_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + 1)), b));
+		if (n > 2) m = _mm_and_si128(m, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + skip)), c));
+
+		unsigned mask = (unsigned)_mm_movemask_epi8(m);
+		if (mask) return p + __builtin_ctz(mask);
+		p += 16;
+	}
+	return find_scalar(p, end, pat, n);
+}
+/**
+ * @brief AVX2 kernel: compares 32 positions per step against each pattern byte.
+ */
+__attribute__((target("avx2")))
+static const char* find_avx2(const char* p, const char* end, const char* pat, size_t n) {
+	const __m256i a = _mm256_set1_epi8(pat[0]);
+	const __m256i b = _mm256_set1_epi8(pat[1]);
+	const __m256i c = _mm256_set1_epi8(pat[n - 1]);
+	const size_t skip = n - 1;
+
+	while (end - p >= (ptrdiff_t)(32 + skip)) {
+		__m256i m = _mm256_and_si256(
+			_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)p), a),
+			_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + 1)), b));
+		if (n > 2) m = _mm256_and_si256(m, _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + skip)), c));
+
+		unsigned mask = (unsigned)_mm256_movemask_epi8(m);
+		if (mask) return p + __builtin_ctz(mask);
+		p += 32;
+	}
+	return find_sse2(p, end, pat, n);
+}
+/**
+ * @brief SSE2 lexer kernel: tests 16 bytes per step against the four special bytes.
+ */
+__attribute__((target("sse2")))
+static const char* special_sse2(const char* p, const char* end) {
+	const __m128i slash = _mm_set1_epi8('/');
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i apos = _mm_set1_epi8('\'');
+	const __m128i hash = _mm_set1_epi8('#');
+
+	while (end - p >= 16) {
+		__m128i v = _mm_loadu_si128((const __m128i*)p);
+		__m128i m = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(v, slash), _mm_cmpeq_epi8(v, quote)),
+			_mm_or_si128(_mm_cmpeq_epi8(v, apos), _mm_cmpeq_epi8(v, hash)));
+
+		unsigned mask = (unsigned)_mm_movemask_epi8(m);
+		if (mask) return p + __builtin_ctz(mask);
+		p += 16;
+	}
+	return special_scalar(p, end);
+}
+/**
+ * @brief AVX2 lexer kernel: tests 32 bytes per step against the four special bytes.
+ */
+__attribute__((target("avx2")))
+static const char* special_avx2(const char* p, const char* end) {
+	const __m256i slash = _mm256_set1_epi8('/');
+	const __m256i quote = _mm256_set1_epi8('"');
+	const __m256i apos = _mm256_set1_epi8('\'');
+	const __m256i hash = _mm256_set1_epi8('#');
+
+	while (end - p >= 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i*)p);
+		__m256i m = _mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(v, slash), _mm256_cmpeq_epi8(v, quote)),
+			_mm256_or_si256(_mm256_cmpeq_epi8(v, apos), _mm256_cmpeq_epi8(v, hash)));
+
+		unsigned mask = (unsigned)_mm256_movemask_epi8(m);
+		if (mask) return p + __builtin_ctz(mask);
+		p += 32;
+	}
+	return special_sse2(p, end);
+}
+#endif
+/**
+ * @brief Selects the kernel; unsupported requests fall back to the best available.
+ * @param isa Requested instruction set.
+ * @return Instruction set now in use.
+ */
+static SCANISA scan_select(SCANISA isa) {
+	KERNEL = find_scalar;
+	SPECIAL = special_scalar;
+	KERNEL_ISA = SCAN_SCALAR;
+	if (isa == SCAN_SCALAR) return KERNEL_ISA;
+
+#ifdef SCAN_X86
+	__builtin_cpu_init();
+	if ((isa == SCAN_AUTO || isa == SCAN_AVX2) && __builtin_cpu_supports("avx2")) {
+		KERNEL = find_avx2;
+		SPECIAL = special_avx2;
+		KERNEL_ISA = SCAN_AVX2;
+	} else if (__builtin_cpu_supports("sse2")) {
+		KERNEL = find_sse2;
+		SPECIAL = special_sse2;
+		KERNEL_ISA = SCAN_SSE2;
+	}
+#endif
+
+	return KERNEL_ISA;
+}
+/**
+ * @brief Picks the best kernel unless one was selected explicitly.
+ */
+static void scan_init(void) {
+	if (!KERNEL) scan_select(SCAN_AUTO);
+}
+/**
+ * @brief Finds the next "/ **" opener.
+ */
+static const char* find_open(const char* p, const char* end) {
+	pthread_once(&KERNEL_ONCE, scan_init);
+	return KERNEL(p, end, OPENER, sizeof(OPENER));
+}
+/**
+ * @brief Finds the next "* /" closer.
+ */
+static const char* find_close(const char* p, const char* end) {
+	pthread_once(&KERNEL_ONCE, scan_init);
+	return KERNEL(p, end, CLOSER, sizeof(CLOSER));
+}
+/**
+ * @brief Finds the next live Doxygen block opener, lexing C on the way.
+ * @details One pass over the range: the special-byte kernel skips plain code,
+ *			and each stop is a comment, a literal or a directive to step over.
+ *			Inside a disabled group only comments and directives matter, but
+ *			literals are still stepped over so a quoted "#endif" stays text.
+ */
+static const char* next_block(const char* p, const char* end, scan_state* st) {
+	pthread_once(&KERNEL_ONCE, scan_init);
+	while ((p = SPECIAL(p, end)) < end) {
+		switch (*p) {
+			case '/':
+				if (p + 1 < end && p[1] == '/') {
+					p = skip_line_comment(p, end);
+				} else if (p + 1 < end && p[1] == '*') {
+					if (!st->off && p + 3 < end && p[2] == '*' && p[3] != '/' && p[3] != '*' &&
+						at_line_start(st->base, p)) return p;
+					const char* close = KERNEL(p + 2, end, CLOSER, sizeof(CLOSER));
+					p = close < end ? close + 2 : end;
+				} else {
+					p++;
+				}
+				break;
+			case '"':
+			case '\'':
+				p = skip_literal(p, end);
+				break;
+			default:
+				p = at_line_start(st->base, p) ? directive(p + 1, end, st) : p + 1;
+				break;
+		}
+	}
+	return end;
+}
+/**
+ * @brief Skips a string or character literal starting at its quote.
+ * @return First byte after the literal, or its newline if it is unterminated.
+ */
+static const char* skip_literal(const char* p, const char* end) {
+	char quote = *p++;
+	while (p < end && *p != quote && *p != '\n') p += (*p == '\\' && p + 1 < end) ? 2 : 1;
+	return p < end && *p == quote ? p + 1 : p;
+}
+/**
+ * @brief Skips a "//" comment, following backslash-continued lines.
+ * @return The newline ending the comment, or end.
+ */
+static const char* skip_line_comment(const char* p, const char* end) {
+	for (;;) {
+		const char* nl = memchr(p, '\n', end - p);
+		if (!nl) return end;
+		const char* q = nl;
+		if (q > p && q[-1] == '\r') q--;
+		if (q == p || q[-1] != '\\') return nl;
+		p = nl + 1;
+	}
+}
+/**
+ * @brief Applies a conditional directive to the lexer state.
+ * @details `#if 0` opens a disabled group; `#if 1` marks its level so the
+ *			`#else` and `#elif` branches are disabled. In a disabled group only
+ *			the nesting is counted until a branch at its own depth can be live.
+ * @param p First byte after the '#'.
+ * @param end End of the buffer.
+ * @param st Lexer state.
+ * @return First byte after the directive name; the rest of the line is lexed
+ *			as usual.
+ */
+static const char* directive(const char* p, const char* end, scan_state* st) {
+	while (p < end && (*p == ' ' || *p == '\t')) p++;
+	const char* name = p;
+	while (p < end && *p >= 'a' && *p <= 'z') p++;
+	size_t n = p - name;
+	int cond = -1;		//	constant condition of #if/#elif: 0, 1, or -1 when not constant
+	if (n == 2 || n == 4) {
+		const char* v = p;
+		while (v < end && (*v == ' ' || *v == '\t')) v++;
+		if (v < end && (*v == '0' || *v == '1') &&
+			(v + 1 == end || !((v[1] >= '0' && v[1] <= '9') || (v[1] >= 'a' && v[1] <= 'z') ||
+			(v[1] >= 'A' && v[1] <= 'Z') || v[1] == '_' || v[1] == '.'))) cond = *v - '0';
+	}
+#define DIRECTIVE_IS(lit) (n == sizeof(lit) - 1 && memcmp(name, lit, sizeof(lit) - 1) == 0)
+	unsigned long long bit = st->level > 0 && st->level <= SCAN_DEPTH ? 1ULL << (st->level - 1) : 0;
+	if (DIRECTIVE_IS("if") || DIRECTIVE_IS("ifdef") || DIRECTIVE_IS("ifndef")) {
+		if (st->off) {
+			st->off++;
+		} else {
+			st->level++;
+			bit = st->level <= SCAN_DEPTH ? 1ULL << (st->level - 1) : 0;
+			st->taken &= ~bit;
+			if (DIRECTIVE_IS("if") && cond == 0) {
+				st->off = 1;
+				st->dead = 0;
+			} else if (DIRECTIVE_IS("if") && cond == 1) {
+				st->taken |= bit;
+			}
+		}
+	} else if (DIRECTIVE_IS("elif") || DIRECTIVE_IS("else")) {
+		if (!st->off) {
+			if (st->taken & bit) {		//	a constant-true branch was live
+				st->off = 1;
+				st->dead = 1;
+			} else if (DIRECTIVE_IS("elif") && cond == 0) {
+				st->off = 1;
+				st->dead = 0;
+			}
+		} else if (st->off == 1 && !st->dead && !(DIRECTIVE_IS("elif") && cond == 0)) {
+			st->off = 0;
+			if (cond == 1) st->taken |= bit;
+		}
+	} else if (DIRECTIVE_IS("endif")) {
+		if (st->off > 1) {
+			st->off--;
+		} else {
+			st->off = 0;
+			if (st->level > 0) st->level--;
+		}
+	}
+#undef DIRECTIVE_IS
+	return p;
+}
+/**
+ * @brief Tests whether only indentation precedes a position on its line.
+ * @param base Start of the buffer.
+ * @param p Position.
+ */
+static int at_line_start(const char* base, const char* p) {
+	while (p > base && (p[-1] == ' ' || p[-1] == '\t')) p--;
+	return p == base || p[-1] == '\n';
+}
+/**
+ * @brief Names an instruction set.
+ */
+static const char* scan_name(SCANISA isa) {
+	switch (isa) {
+		case SCAN_SCALAR: return "scalar";
+		case SCAN_SSE2: return "sse2";
+		case SCAN_AVX2: return "avx2";
+		default: return "auto";
+	}
+}
+
+const IScan Scan = {
+	.findOpen = find_open,
+	.findClose = find_close,
+	.nextBlock = next_block,
+	.select = scan_select,
+	.name = scan_name
+};
@@ -0,0 +1,651 @@
+// serve.c
+#define _POSIX_C_SOURCE 200809L
+#include "serve.h"
+#include "docset.h"
+#include "md_generator.h"
+#include "symbols.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+/* structure representing the running server */
+struct server_s {
+	doxy_config* config;	/**< Configuration */
+	list names;				/**< Served targets, or NULL for all */
+	docset set;				/**< Resident targets */
+	pthread_rwlock_t lock;	/**< Shared for reading the targets, exclusive for changing them */
+	symtab symbols;			/**< Index over every source, built on first use; NULL after a change */
+	list indexed;			/**< Units the index views into */
+	pthread_mutex_t symbols_lock;	/**< Serializes building the index under a shared lock */
+	int* queue;				/**< Accepted connections waiting for a worker (ring) */
+	int head;				/**< Next connection to hand out */
+	int waiting;			/**< Connections in the queue */
+	int capacity;			/**< Slots in the queue */
+	int stopping;			/**< Set when the workers must exit */
+	pthread_mutex_t queue_lock;		/**< Guards the queue and stopping */
+	pthread_cond_t queue_ready;		/**< Signalled when a connection is queued or on stop */
+	int wake[2];			/**< Pipe written once to stop: wakes the accept loop */
+	int returned[2];		/**< Pipe carrying answered connections back to the accept loop */
+	struct pollfd* idle;	/**< Accept loop's poll set: listener, pipes, then idle connections */
+	int idle_count;			/**< Entries in the poll set */
+	int idle_capacity;		/**< Slots in the poll set */
+};
+typedef struct server_s* server;
+
+static int WAKE_FD = -1;		//	write end of the running server's pipe, for signals
+
+//	Forward declarations / Function prototypes
+static int serve_run(doxy_config*, list, const string);
+static int serve_request(const string, const string);
+static int open_socket(const string);
+static int connect_socket(const string);
+static void enqueue(server, int);
+static int watch_idle(server, int);
+static void* serve_worker(void*);
+static int serve_connection(server, int);
+static int handle(server, const char*, const char*, sink, int*);
+static int do_render(server, const char*, sink);
+static int do_symbol(server, const char*, sink);
+static int do_invalidate(server, const char*, sink);
+static int do_reload(server, sink);
+static symtab ensure_symbols(server);
+static void drop_symbols(server);
+static char* read_frame(int, size_t, size_t*);
+static int write_frame(int, const char*, size_t);
+static int read_full(int, char*, size_t);
+static int write_full(int, const char*, size_t);
+static double now_ms(void);
+static void wake(server);
+static void on_signal(int);
+
+/**
+ * @brief Loads the targets, binds the socket and serves until stopped.
+ * @details The socket is bound only once the targets are loaded, so a client
+ *			that sees it gets answers from warm state. The calling thread
+ *			accepts connections and polls them while idle; a connection is
+ *			queued for the workers only once its request arrives, and comes
+ *			back to the poll set when answered, so idle clients hold no worker.
+ * @return 0 on a clean stop, non-zero if serving failed.
+ */
+static int serve_run(doxy_config* config, list names, const string path) {
+	struct server_s srv;
+	memset(&srv, 0, sizeof(srv));
+	srv.config = config;
+	srv.names = names;
+	srv.wake[0] = srv.wake[1] = -1;
+	srv.returned[0] = srv.returned[1] = -1;
+	pthread_rwlock_init(&srv.lock, NULL);
+	pthread_mutex_init(&srv.symbols_lock, NULL);
+	pthread_mutex_init(&srv.queue_lock, NULL);
+	pthread_cond_init(&srv.queue_ready, NULL);
+
+	int workers = config->jobs > 0 ? config->jobs : (int)sysconf(_SC_NPROCESSORS_ONLN);
+	if (workers < 1) workers = 1;
+	pthread_t* threads = Mem.alloc(workers * sizeof(pthread_t));
+	int started = 0;
+	int fd = -1;
+	int ret = 1;
+
+	if (pipe(srv.wake) != 0 || pipe(srv.returned) != 0) {
+		fprintf(stderr, "Failed to start serving (pipe)\n");
+		goto cleanup;
+	}
+	//	a worker never blocks handing a connection back, and cleanup drains the pipe
+	fcntl(srv.returned[0], F_SETFL, O_NONBLOCK);
+	fcntl(srv.returned[1], F_SETFL, O_NONBLOCK);
+	srv.set = DocSet.load(config, names);
+	if (!srv.set) goto cleanup;
+	if (List.count(DocSet.documents(srv.set)) == 0) {
+		printf("Configuration '%s' was empty\n", config->file);
+		goto cleanup;
+	}
+	if ((fd = open_socket(path)) < 0) goto cleanup;
+
+	struct sigaction sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = SIG_IGN;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGPIPE, &sa, NULL);		//	a client may go away mid-response
+	WAKE_FD = srv.wake[1];
+	sa.sa_handler = on_signal;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+
+	while (started < workers && pthread_create(&threads[started], NULL, serve_worker, &srv) == 0) started++;
+	if (started == 0) {
+		fprintf(stderr, "Failed to start serving (threads)\n");
+		goto cleanup;
+	}
+	printf("Serving %d target(s) on %s with %d worker(s)\n", List.count(DocSet.documents(srv.set)), path, started);
+	fflush(stdout);
+
+	if (watch_idle(&srv, fd) != 0 || watch_idle(&srv, srv.wake[0]) != 0 || watch_idle(&srv, srv.returned[0]) != 0) goto cleanup;
+	//	a request that stalls once started drops its connection instead of a worker
+	struct timeval timeout = { SERVE_TIMEOUT_MS / 1000, (SERVE_TIMEOUT_MS % 1000) * 1000 };
+	while (1) {
+		if (poll(srv.idle, srv.idle_count, -1) < 0) {
+			if (errno == EINTR) continue;
+			break;
+		}
+		if (srv.idle[1].revents) {
+			ret = 0;
+			break;
+		}
+		//	a readable connection has a request (or has closed): hand it to a worker
+		for (int i = srv.idle_count - 1; i >= 3; i--) {
+			if (!srv.idle[i].revents) continue;
+			enqueue(&srv, srv.idle[i].fd);
+			srv.idle[i] = srv.idle[--srv.idle_count];
+		}
+		if (srv.idle[2].revents & POLLIN) {
+			int client;
+			while (read(srv.returned[0], &client, sizeof(client)) == sizeof(client)) {
+				if (watch_idle(&srv, client) != 0) close(client);
+			}
+		}
+		if (srv.idle[0].revents & POLLIN) {
+			int client = accept(fd, NULL, NULL);
+			if (client < 0) continue;
+			setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+			setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+			if (watch_idle(&srv, client) != 0) close(client);
+		}
+	}
+
+cleanup:
+	pthread_mutex_lock(&srv.queue_lock);
+	srv.stopping = 1;
+	pthread_cond_broadcast(&srv.queue_ready);
+	pthread_mutex_unlock(&srv.queue_lock);
+	for (int i = 0; i < started; i++) pthread_join(threads[i], NULL);
+	Mem.free(threads);
+	for (int i = 0; i < srv.waiting; i++) close(srv.queue[(srv.head + i) % srv.capacity]);
+	if (srv.queue) Mem.free(srv.queue);
+	for (int i = 3; i < srv.idle_count; i++) close(srv.idle[i].fd);
+	if (srv.idle) Mem.free(srv.idle);
+	if (srv.returned[0] >= 0) {
+		int client;
+		while (read(srv.returned[0], &client, sizeof(client)) == sizeof(client)) close(client);
+		close(srv.returned[0]);
+	}
+	if (srv.returned[1] >= 0) close(srv.returned[1]);
+
+	WAKE_FD = -1;
+	if (fd >= 0) {
+		close(fd);
+		unlink(path);
+	}
+	drop_symbols(&srv);
+	DocSet.free(srv.set);
+	if (srv.wake[0] >= 0) close(srv.wake[0]);
+	if (srv.wake[1] >= 0) close(srv.wake[1]);
+	pthread_cond_destroy(&srv.queue_ready);
+	pthread_mutex_destroy(&srv.queue_lock);
+	pthread_mutex_destroy(&srv.symbols_lock);
+	pthread_rwlock_destroy(&srv.lock);
+	return ret;
+}
+/**
+ * @brief Sends one request and prints the response.
+ * @return 0 if the server answered `ok`, non-zero otherwise.
+ */
+static int serve_request(const string path, const string request) {
+	int fd = connect_socket(path);
+	if (fd < 0) {
+		fprintf(stderr, "Failed to connect to '%s'\n", path);
+		return 1;
+	}
+	size_t len = 0;
+	char* response = write_frame(fd, request, strlen(request)) == 0 ? read_frame(fd, SERVE_MAX_RESPONSE, &len) : NULL;
+	close(fd);
+	if (!response) {
+		fprintf(stderr, "No response from '%s'\n", path);
+		return 1;
+	}
+
+	char* nl = memchr(response, '\n', len);
+	size_t status = nl ? (size_t)(nl - response) : len;
+	int ret = !(status == 2 && memcmp(response, "ok", 2) == 0);
+	if (ret) {
+		fprintf(stderr, "%.*s\n", (int)status, response);
+	} else if (nl) {
+		fwrite(nl + 1, 1, len - status - 1, stdout);
+	}
+	Mem.free(response);
+	return ret;
+}
+/**
+ * @brief Binds and listens on a Unix domain socket, replacing a stale one.
+ * @return Listening descriptor, or -1 on failure.
+ */
+static int open_socket(const string path) {
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		fprintf(stderr, "Socket path '%s' is too long\n", path);
+		return -1;
+	}
+	strcpy(addr.sun_path, path);
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) {
+		fprintf(stderr, "Failed to create socket '%s'\n", path);
+		return -1;
+	}
+	int bound = bind(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0;
+	if (!bound && errno == EADDRINUSE) {
+		int probe = connect_socket(path);
+		if (probe >= 0) {
+			close(probe);
+			fprintf(stderr, "A server is already listening on '%s'\n", path);
+			close(fd);
+			return -1;
+		}
+		unlink(path);					//	left behind by a server that died
+		bound = bind(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0;
+	}
+	if (!bound || listen(fd, SERVE_BACKLOG) != 0) {
+		fprintf(stderr, "Failed to listen on '%s'\n", path);
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+/**
+ * @brief Connects to a Unix domain socket.
+ * @return Connected descriptor, or -1 on failure.
+ */
+static int connect_socket(const string path) {
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(addr.sun_path)) return -1;
+	strcpy(addr.sun_path, path);
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) return -1;
+	if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+/**
+ * @brief Queues a connection with a request for the workers, growing the ring as needed.
+ */
+static void enqueue(server srv, int fd) {
+	pthread_mutex_lock(&srv->queue_lock);
+	if (srv->waiting == srv->capacity) {
+		int capacity = srv->capacity ? srv->capacity * 2 : SERVE_BACKLOG;
+		int* queue = Mem.alloc(capacity * sizeof(int));
+		if (!queue) {
+			pthread_mutex_unlock(&srv->queue_lock);
+			close(fd);
+			return;
+		}
+		for (int i = 0; i < srv->waiting; i++) queue[i] = srv->queue[(srv->head + i) % srv->capacity];
+		if (srv->queue) Mem.free(srv->queue);
+		srv->queue = queue;
+		srv->capacity = capacity;
+		srv->head = 0;
+	}
+	srv->queue[(srv->head + srv->waiting) % srv->capacity] = fd;
+	srv->waiting++;
+	pthread_cond_signal(&srv->queue_ready);
+	pthread_mutex_unlock(&srv->queue_lock);
+}
+/**
+ * @brief Adds a descriptor to the accept loop's poll set, growing it as needed.
+ * @return 0 on success, non-zero if the set cannot grow.
+ */
+static int watch_idle(server srv, int fd) {
+	if (srv->idle_count == srv->idle_capacity) {
+		int capacity = srv->idle_capacity ? srv->idle_capacity * 2 : SERVE_BACKLOG;
+		struct pollfd* idle = Mem.alloc(capacity * sizeof(struct pollfd));
+		if (!idle) return 1;
+		if (srv->idle) {
+			memcpy(idle, srv->idle, srv->idle_count * sizeof(struct pollfd));
+			Mem.free(srv->idle);
+		}
+		srv->idle = idle;
+		srv->idle_capacity = capacity;
+	}
+	srv->idle[srv->idle_count].fd = fd;
+	srv->idle[srv->idle_count].events = POLLIN;
+	srv->idle[srv->idle_count].revents = 0;
+	srv->idle_count++;
+	return 0;
+}
+/**
+ * @brief Takes queued connections, answers one request of each and hands
+ *			them back to the accept loop, until the server stops.
+ * @param arg The server.
+ * @return NULL.
+ */
+static void* serve_worker(void* arg) {
+	server srv = arg;
+	while (1) {
+		pthread_mutex_lock(&srv->queue_lock);
+		while (!srv->waiting && !srv->stopping) pthread_cond_wait(&srv->queue_ready, &srv->queue_lock);
+		if (srv->stopping) {
+			pthread_mutex_unlock(&srv->queue_lock);
+			return NULL;
+		}
+		int fd = srv->queue[srv->head];
+		srv->head = (srv->head + 1) % srv->capacity;
+		srv->waiting--;
+		pthread_mutex_unlock(&srv->queue_lock);
+
+		//	a full pipe only happens at stop, with the accept loop gone
+		if (!serve_connection(srv, fd) || write(srv->returned[1], &fd, sizeof(fd)) != sizeof(fd)) close(fd);
+	}
+}
+/**
+ * @brief Answers the request that has arrived on a connection.
+ * @return Non-zero to keep the connection for its next request, 0 once the
+ *			client has closed it, a read or write failed or timed out, or
+ *			the request stopped the server.
+ */
+static int serve_connection(server srv, int fd) {
+	size_t len;
+	char* request = read_frame(fd, SERVE_MAX_REQUEST, &len);
+	if (!request) return 0;
+
+	//	"command argument": the argument is the rest of the request
+	char* arg = strchr(request, ' ');
+	if (arg) *arg++ = '\0';
+
+	string_builder sb = StringBuilder.new(1024);
+	sink body = Sink.toBuilder(sb);
+	int stop = 0;
+	int failed = handle(srv, request, arg ? arg : "", body, &stop);
+	Sink.close(body);
+	string text = StringBuilder.toString(sb);
+	StringBuilder.free(sb);
+	Mem.free(request);
+
+	//	the status line, then the body; a failure's reason is its status line
+	size_t tlen = strlen(text);
+	int sent;
+	if (failed) {
+		string response = Mem.alloc(tlen + 9);
+		memcpy(response, "error: ", 7);
+		memcpy(response + 7, text, tlen);
+		response[7 + tlen] = '\n';
+		sent = write_frame(fd, response, tlen + 8);
+		Mem.free(response);
+	} else {
+		string response = Mem.alloc(tlen + 4);
+		memcpy(response, "ok\n", 3);
+		memcpy(response + 3, text, tlen);
+		sent = write_frame(fd, response, tlen + 3);
+		Mem.free(response);
+	}
+	Mem.free(text);
+	if (stop) wake(srv);
+	return sent == 0 && !stop;
+}
+/**
+ * @brief Runs one request.
+ * @param srv Server.
+ * @param cmd Command.
+ * @param arg Argument ("" if none).
+ * @param body Output: response body, or the reason of a failure.
+ * @param stop Output: set when the server must stop after responding.
+ * @return 0 on success, non-zero on failure.
+ */
+static int handle(server srv, const char* cmd, const char* arg, sink body, int* stop) {
+	if (strcmp(cmd, "ping") == 0) {
+		Sink.append(body, "pong\n");
+		return 0;
+	}
+	if (strcmp(cmd, "targets") == 0) {
+		pthread_rwlock_rdlock(&srv->lock);
+		list documents = DocSet.documents(srv->set);
+		for (int i = 0; i < List.count(documents); i++) {
+			document d = List.getAt(documents, i);
+			Sink.appendf(body, "%s %s\n", d->name, d->output);
+		}
+		pthread_rwlock_unlock(&srv->lock);
+		return 0;
+	}
+	if (strcmp(cmd, "render") == 0) return do_render(srv, arg, body);
+	if (strcmp(cmd, "symbol") == 0) return do_symbol(srv, arg, body);
+	if (strcmp(cmd, "invalidate") == 0) return do_invalidate(srv, arg, body);
+	if (strcmp(cmd, "reload") == 0) return do_reload(srv, body);
+	if (strcmp(cmd, "stop") == 0) {
+		*stop = 1;
+		return 0;
+	}
+	Sink.appendf(body, "unknown command '%s'", cmd);
+	return 1;
+}
+/**
+ * @brief Writes a target's document from the resident text.
+ * @return 0 on success, non-zero if the target is unknown or writing failed.
+ */
+static int do_render(server srv, const char* name, sink body) {
+	double start = now_ms();
+	pthread_rwlock_rdlock(&srv->lock);
+	document d = DocSet.target(srv->set, name);
+	int ret = 1;
+	if (!d) {
+		Sink.appendf(body, "unknown target '%s'", name);
+	} else {
+		list one = List.new(1);
+		List.add(one, d);
+		ret = DocSet.write(srv->set, one, NULL);
+		List.free(one);
+		if (ret) {
+			Sink.appendf(body, "failed to write '%s'", d->output);
+		} else {
+			Sink.appendf(body, "%s\n", d->output);
+		}
+	}
+	pthread_rwlock_unlock(&srv->lock);
+	if (srv->config->is_debug) printf("render %s: %.2f ms\n", name, now_ms() - start);
+	return ret;
+}
+/**
+ * @brief Renders the comment documenting a name.
+ * @return 0 on success, non-zero if no served comment documents the name.
+ */
+static int do_symbol(server srv, const char* name, sink body) {
+	pthread_rwlock_rdlock(&srv->lock);
+	symtab st = ensure_symbols(srv);
+	symbol* sym = st ? Symbols.find(st, name, strlen(name)) : NULL;
+	if (sym) {
+		//	a one-comment view of the unit
+		struct unit_s one = { sym->c->src, NULL, sym->c, 1, 0 };
+		MDGenerator.render(body, &one, NULL, srv->config->layout);
+	} else {
+		Sink.appendf(body, st ? "no documentation for '%s'" : "failed to index symbols", name);
+	}
+	pthread_rwlock_unlock(&srv->lock);
+	return sym == NULL;
+}
+/**
+ * @brief Re-parses one source; a removed source reloads every target.
+ * @return 0 on success, non-zero if the path is not served or cannot be parsed.
+ */
+static int do_invalidate(server srv, const char* path, sink body) {
+	pthread_rwlock_wrlock(&srv->lock);
+	docset_source ds = DocSet.find(srv->set, path);
+	int ret = 1;
+	if (!ds) {
+		Sink.appendf(body, "'%s' is not a source of the served targets", path);
+	} else if (access(path, F_OK) != 0) {
+		pthread_rwlock_unlock(&srv->lock);
+		return do_reload(srv, body);
+	} else if (DocSet.refresh(srv->set, ds) != 0) {
+		Sink.appendf(body, "failed to parse '%s'", path);
+	} else {
+		drop_symbols(srv);
+		for (int i = 0; i < List.count(ds->documents); i++) {
+			document d = List.getAt(ds->documents, i);
+			Sink.appendf(body, "%s\n", d->name);
+		}
+		ret = 0;
+	}
+	pthread_rwlock_unlock(&srv->lock);
+	return ret;
+}
+/**
+ * @brief Reads the configuration again and rebuilds every target; on
+ *			failure the current targets are kept.
+ * @return 0 on success, non-zero if the targets cannot be built.
+ */
+static int do_reload(server srv, sink body) {
+	pthread_rwlock_wrlock(&srv->lock);
+	docset set = DocSet.load(srv->config, srv->names);
+	if (set && List.count(DocSet.documents(set)) == 0) {
+		DocSet.free(set);			//	an emptied configuration keeps the current targets
+		set = NULL;
+	}
+	if (set) {
+		drop_symbols(srv);
+		DocSet.free(srv->set);
+		srv->set = set;
+		list documents = DocSet.documents(set);
+		for (int i = 0; i < List.count(documents); i++) {
+			document d = List.getAt(documents, i);
+			Sink.appendf(body, "%s\n", d->name);
+		}
+	} else {
+		Sink.appendf(body, "failed to reload '%s'", srv->config->file);
+	}
+	pthread_rwlock_unlock(&srv->lock);
+	return set == NULL;
+}
+/**
+ * @brief Returns the symbol index of every served source, building it on
+ *			first use; the caller holds the targets lock (shared).
+ * @return Index, or NULL on failure.
+ */
+static symtab ensure_symbols(server srv) {
+	pthread_mutex_lock(&srv->symbols_lock);
+	if (!srv->symbols) {
+		list sources = DocSet.sources(srv->set);
+		srv->indexed = List.new(List.count(sources) + 1);
+		for (int i = 0; i < List.count(sources); i++) {
+			docset_source ds = List.getAt(sources, i);
+			if (ds->u && ds->u->count > 0) List.add(srv->indexed, ds->u);
+		}
+		srv->symbols = Symbols.build(srv->indexed);
+		if (!srv->symbols) {
+			List.free(srv->indexed);
+			srv->indexed = NULL;
+		}
+	}
+	symtab st = srv->symbols;
+	pthread_mutex_unlock(&srv->symbols_lock);
+	return st;
+}
+/**
+ * @brief Frees the symbol index; the caller holds the targets lock (exclusive).
+ */
+static void drop_symbols(server srv) {
+	Symbols.free(srv->symbols);
+	if (srv->indexed) List.free(srv->indexed);
+	srv->symbols = NULL;
+	srv->indexed = NULL;
+}
+/**
+ * @brief Reads one frame.
+ * @param fd Connected descriptor.
+ * @param max Largest payload accepted.
+ * @param len Output: payload length.
+ * @return Allocated, NUL-terminated payload (caller frees), or NULL at end of
+ *			stream, on error or when the frame is too large.
+ */
+static char* read_frame(int fd, size_t max, size_t* len) {
+	uint32_t header;
+	if (read_full(fd, (char*)&header, sizeof(header)) != 0) return NULL;
+	*len = ntohl(header);
+	if (*len > max) return NULL;
+
+	char* payload = Mem.alloc(*len + 1);
+	if (!payload) return NULL;
+	if (read_full(fd, payload, *len) != 0) {
+		Mem.free(payload);
+		return NULL;
+	}
+	payload[*len] = '\0';
+	return payload;
+}
+/**
+ * @brief Writes one frame.
+ * @return 0 on success, non-zero on failure.
+ */
+static int write_frame(int fd, const char* data, size_t len) {
+	uint32_t header = htonl((uint32_t)len);
+	if (write_full(fd, (const char*)&header, sizeof(header)) != 0) return 1;
+	return write_full(fd, data, len);
+}
+/**
+ * @brief Reads exactly len bytes.
+ * @return 0 on success, non-zero at end of stream or on error.
+ */
+static int read_full(int fd, char* buf, size_t len) {
+	while (len > 0) {
+		ssize_t n = read(fd, buf, len);
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) return 1;
+		buf += n;
+		len -= n;
+	}
+	return 0;
+}
+/**
+ * @brief Writes exactly len bytes, without raising SIGPIPE.
+ * @return 0 on success, non-zero on error.
+ */
+static int write_full(int fd, const char* buf, size_t len) {
+	while (len > 0) {
+		ssize_t n = send(fd, buf, len, MSG_NOSIGNAL);
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) return 1;
+		buf += n;
+		len -= n;
+	}
+	return 0;
+}
+/**
+ * @brief Monotonic clock in milliseconds.
+ */
+static double now_ms(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+/**
+ * @brief Makes the stop pipe readable; it is never drained, so every poll
+ *			on it returns from then on.
+ */
+static void wake(server srv) {
+	char b = 1;
+	if (write(srv->wake[1], &b, 1) < 0) return;
+}
+/**
+ * @brief Stops the server on SIGINT/SIGTERM.
+ */
+static void on_signal(int sig) {
+	(void)sig;
+	char b = 1;
+	if (WAKE_FD >= 0 && write(WAKE_FD, &b, 1) < 0) return;
+}
+
+const IServe Serve = {
+	.run = serve_run,
+	.request = serve_request
+};
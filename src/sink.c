@@ -0,0 +1,234 @@
+// sink.c
+#define _POSIX_C_SOURCE 200809L
+#include "sink.h"
+#include "writer.h"
+#include "stats.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/* structure representing a buffered sink */
+struct sink_s {
+	FILE* out;				/**< Temporary file; NULL for a builder sink */
+	string path;			/**< Destination path */
+	string temp;			/**< Temporary file path */
+	string_builder sb;		/**< Destination builder; NULL for a file sink */
+	size_t used;			/**< Bytes in buf */
+	size_t total;			/**< Bytes written */
+	int failed;				/**< Set when a write failed */
+	char buf[SINK_BUFFER];	/**< Pending output */
+	sink_fn fn;				/**< Destination function; NULL unless a callback sink */
+	object arg;				/**< Context passed to fn */
+};
+
+/**
+ * @brief Allocates a sink.
+ */
+static sink new_sink(void) {
+	sink s = Mem.alloc(sizeof(struct sink_s));
+	if (!s) return NULL;
+	s->out = NULL;
+	s->path = NULL;
+	s->temp = NULL;
+	s->sb = NULL;
+	s->used = 0;
+	s->total = 0;
+	s->failed = 0;
+	s->fn = NULL;
+	s->arg = NULL;
+	return s;
+}
+/**
+ * @brief Opens a sink writing to a temporary file next to the destination.
+ * @param path Destination file path.
+ * @return Sink, or NULL if the temporary file cannot be created.
+ */
+static sink sink_open(const string path) {
+	sink s = new_sink();
+	if (!s) return NULL;
+
+	s->out = FileWriter.begin(path, &s->temp);
+	if (!s->out) {
+		Mem.free(s);
+		return NULL;
+	}
+	s->path = Mem.alloc(strlen(path) + 1);
+	strcpy(s->path, path);
+
+	return s;
+}
+/**
+ * @brief Opens a sink appending to a StringBuilder.
+ * @param sb StringBuilder to append to.
+ * @return Sink, or NULL on failure.
+ */
+static sink sink_to_builder(string_builder sb) {
+	sink s = new_sink();
+	if (s) s->sb = sb;
+	return s;
+}
+/**
+ * @brief Opens a sink handing its output to a function.
+ * @param fn Function receiving the bytes.
+ * @param arg Context passed to fn.
+ * @return Sink, or NULL on failure.
+ */
+static sink sink_to_callback(sink_fn fn, object arg) {
+	if (!fn) return NULL;
+	sink s = new_sink();
+	if (!s) return NULL;
+	s->fn = fn;
+	s->arg = arg;
+	return s;
+}
+/**
+ * @brief Hands bytes to a callback sink's function; a failure is kept.
+ */
+static void call_fn(sink s, const char* data, size_t len) {
+	if (!s->failed && s->fn(data, len, s->arg) != 0) s->failed = 1;
+}
+/**
+ * @brief Moves buffered bytes to the destination.
+ */
+static void flush(sink s) {
+	if (s->used == 0) return;
+	if (s->out) {
+		if (fwrite(s->buf, 1, s->used, s->out) != s->used) s->failed = 1;
+	} else if (s->fn) {
+		call_fn(s, s->buf, s->used);
+	} else {
+		s->buf[s->used] = '\0';
+		StringBuilder.append(s->sb, s->buf);
+	}
+	s->used = 0;
+}
+/**
+ * @brief Writes bytes to a sink.
+ * @param s Sink to write to.
+ * @param data Bytes to write.
+ * @param len Number of bytes.
+ */
+static void sink_write(sink s, const char* data, size_t len) {
+	s->total += len;
+	if ((s->out || s->fn) && len >= SINK_BUFFER) {
+		//	large blocks skip the buffer
+		flush(s);
+		if (s->fn) {
+			call_fn(s, data, len);
+		} else if (fwrite(data, 1, len, s->out) != len) {
+			s->failed = 1;
+		}
+		return;
+	}
+	while (len > 0) {
+		//	one byte is kept free for the builder's terminator
+		size_t room = SINK_BUFFER - 1 - s->used;
+		size_t n = len < room ? len : room;
+		memcpy(s->buf + s->used, data, n);
+		s->used += n;
+		data += n;
+		len -= n;
+		if (s->used == SINK_BUFFER - 1) flush(s);
+	}
+}
+/**
+ * @brief Writes a NUL-terminated string to a sink.
+ */
+static void sink_append(sink s, const char* str) {
+	sink_write(s, str, strlen(str));
+}
+/**
+ * @brief Writes printf-style formatted text to a sink.
+ * @details Formats straight into the buffer when it fits.
+ */
+static void sink_appendf(sink s, const char* format, ...) {
+	va_list args;
+	va_start(args, format);
+	size_t room = SINK_BUFFER - 1 - s->used;
+	int n = vsnprintf(s->buf + s->used, room, format, args);
+	va_end(args);
+	if (n < 0) return;
+
+	if ((size_t)n < room) {
+		s->used += n;
+		s->total += n;
+		return;
+	}
+
+	//	too long for the free space: format on the heap
+	char* text = Mem.alloc(n + 1);
+	if (!text) return;
+	va_start(args, format);
+	vsnprintf(text, n + 1, format, args);
+	va_end(args);
+	sink_write(s, text, n);
+	Mem.free(text);
+}
+/**
+ * @brief Releases a sink's memory.
+ */
+static void free_sink(sink s) {
+	Mem.free(s->temp);
+	Mem.free(s->path);
+	Mem.free(s);
+}
+/**
+ * @brief Flushes and closes a sink; a file sink replaces its destination
+ *			unless the content is unchanged.
+ * @param s Sink to close.
+ * @return 0 on success, non-zero if any write failed.
+ */
+static int sink_close(sink s) {
+	if (!s) return 1;
+	long begin = Stats.now();
+	flush(s);
+
+	int ret = 0;
+	if (s->out) {
+		if (fclose(s->out) != 0) s->failed = 1;
+		if (s->failed) {
+			fprintf(stderr, "Failed to write '%s'\n", s->path);
+			unlink(s->temp);
+			ret = 1;
+		} else {
+			ret = FileWriter.commit(s->temp, s->path);
+		}
+		Stats.span("write", s->path, begin);
+	} else if (s->fn) {
+		ret = s->failed;
+	}
+
+	free_sink(s);
+	return ret;
+}
+/**
+ * @brief Closes a sink and discards its output.
+ * @param s Sink to abort.
+ */
+static void sink_abort(sink s) {
+	if (!s) return;
+	if (s->out) {
+		fclose(s->out);
+		unlink(s->temp);
+	}
+	free_sink(s);
+}
+/**
+ * @brief Returns the number of bytes written so far.
+ */
+static size_t sink_length(sink s) {
+	return s->total;
+}
+
+const ISink Sink = {
+	.open = sink_open,
+	.toBuilder = sink_to_builder,
+	.toCallback = sink_to_callback,
+	.write = sink_write,
+	.append = sink_append,
+	.appendf = sink_appendf,
+	.close = sink_close,
+	.abort = sink_abort,
+	.length = sink_length
+};
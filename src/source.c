@@ -0,0 +1,174 @@
+// source.c
+#define _POSIX_C_SOURCE 200809L
+#include "source.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//	Forward declarations / Function prototypes
+static source new_source(const string);
+static void source_release(source);
+
+/**
+ * @brief Reads a file that cannot be mapped into a heap buffer.
+ * @param fd Open file descriptor.
+ * @param size Out: number of bytes read; 0 on failure.
+ * @return Allocated buffer, or NULL if reading or allocating failed (a
+ *			partial read is never returned).
+ */
+static char* read_fallback(int fd, size_t* size) {
+	size_t cap = 4096, len = 0;
+	char* buf = Mem.alloc(cap);
+	*size = 0;
+	if (!buf) return NULL;
+
+	for (;;) {
+		ssize_t n = read(fd, buf + len, cap - len);
+		if (n == 0) break;
+		if (n < 0) {
+			if (errno == EINTR) continue;
+			goto fail;
+		}
+		len += n;
+		if (len == cap) {
+			char* grown = Mem.alloc(cap * 2);
+			if (!grown) goto fail;
+			memcpy(grown, buf, len);
+			Mem.free(buf);
+			buf = grown;
+			cap *= 2;
+		}
+	}
+
+	*size = len;
+	return buf;
+
+fail:
+	Mem.free(buf);
+	return NULL;
+}
+/**
+ * @brief Allocates a source with its own copy of the path, in one block.
+ * @param path Source path.
+ * @return Source with no data, or NULL on failure.
+ */
+static source new_source(const string path) {
+	size_t len = strlen(path);
+	source s = Mem.alloc(sizeof(struct source_s) + len + 1);
+	if (!s) return NULL;
+	s->path = (string)(s + 1);
+	memcpy(s->path, path, len + 1);
+	return s;
+}
+/**
+ * @brief Maps a source file into memory.
+ * @param path Source file to map.
+ * @return Source with one reference, or NULL on failure.
+ */
+static source source_open(const string path) {
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) return NULL;
+
+	struct stat st;
+	source s = NULL;
+	if (fstat(fd, &st) != 0) goto cleanup;
+
+	s = new_source(path);
+	if (!s) goto cleanup;
+	s->data = NULL;
+	s->size = 0;
+	s->is_mapped = 0;
+	s->refs = 1;
+
+	if (S_ISREG(st.st_mode) && st.st_size > 0) {
+		void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map != MAP_FAILED) {
+			posix_madvise(map, st.st_size, POSIX_MADV_SEQUENTIAL);
+			s->data = map;
+			s->size = st.st_size;
+			s->is_mapped = 1;
+			goto cleanup;
+		}
+	}
+
+	//	pipes, procfs and friends: read what is there
+	s->data = read_fallback(fd, &s->size);
+	if (!s->data) {
+		//	a short read must not pass for the whole file
+		source_release(s);
+		s = NULL;
+	}
+
+cleanup:
+	if (s && s->size > SPAN_MAX) {
+		fprintf(stderr, "Source '%s' is larger than %u bytes\n", path, SPAN_MAX);
+		source_release(s);
+		s = NULL;
+	}
+	close(fd);
+	return s;
+}
+/**
+ * @brief Wraps a heap buffer as a source, taking ownership of it.
+ * @param path Path reported for the source.
+ * @param data Buffer allocated with Mem.alloc.
+ * @param size Number of bytes in data.
+ * @return Source with one reference, or NULL on failure.
+ */
+static source source_from_buffer(const string path, char* data, size_t size) {
+	source s = new_source(path);
+	if (!s) return NULL;
+	s->data = data;
+	s->size = size;
+	s->is_mapped = 0;
+	s->refs = 1;
+	return s;
+}
+/**
+ * @brief Reads the size and modification time of a file.
+ * @param path File to stat.
+ * @param stamp Output stamp.
+ * @return 0 on success, non-zero on failure.
+ */
+static int source_stat(const string path, source_stamp* stamp) {
+	struct stat st;
+	if (stat(path, &st) != 0) return 1;
+	stamp->size = st.st_size;
+	stamp->mtime_sec = st.st_mtim.tv_sec;
+	stamp->mtime_nsec = st.st_mtim.tv_nsec;
+	return 0;
+}
+/**
+ * @brief Adds a reference to a source.
+ * @param s Source to retain.
+ * @return The same source.
+ */
+static source source_retain(source s) {
+	if (s) ++s->refs;
+	return s;
+}
+/**
+ * @brief Drops a reference; unmaps the source when none remain.
+ * @param s Source to release.
+ */
+static void source_release(source s) {
+	if (!s || --s->refs > 0) return;
+
+	if (s->is_mapped) {
+		munmap((void*)s->data, s->size);
+	} else if (s->data) {
+		Mem.free((object)s->data);
+	}
+	Mem.free(s);
+}
+
+const ISource Source = {
+	.open = source_open,
+	.fromBuffer = source_from_buffer,
+	.stat = source_stat,
+	.retain = source_retain,
+	.release = source_release
+};
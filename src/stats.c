@@ -0,0 +1,310 @@
+// stats.c
+#define _POSIX_C_SOURCE 200809L
+#include "stats.h"
+#include "arena.h"
+#include "sink.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+/* structure representing one recorded span */
+struct stat_event_s {
+	const char* stage;	/**< Stage name (static) */
+	string file;		/**< File worked on (copy), or NULL */
+	long begin;			/**< Start, microseconds since Stats.start */
+	long dur;			/**< Duration in microseconds */
+	int tid;			/**< Recording thread (1 = first thread seen) */
+	int is_file;		/**< 1 for a parse record with the fields below */
+	size_t bytes;		/**< Bytes read */
+	int kept;			/**< Comment blocks kept */
+	int dropped;		/**< Comment blocks dropped */
+	int cached;			/**< Served by the parse cache */
+};
+typedef struct stat_event_s* stat_event;
+/* structure representing the totals of one stage */
+struct stage_total_s {
+	const char* name;	/**< Stage name */
+	long first;			/**< Earliest span start */
+	long last;			/**< Latest span end */
+	long busy;			/**< Sum of span durations */
+	int spans;			/**< Number of spans */
+};
+
+static int ENABLED = 0;
+static int SUMMARY = 0;
+static string TRACE = NULL;
+static struct timespec START;
+static list EVENTS = NULL;
+static int THREADS = 0;
+static long DROPPED = 0;	//	spans past STATS_MAX_EVENTS
+static pthread_mutex_t LOCK = PTHREAD_MUTEX_INITIALIZER;
+static __thread int TID = 0;
+
+static const char* STAGES[] = { "index", "parse", "generate", "write" };
+#define STAGE_COUNT (int)(sizeof(STAGES) / sizeof(STAGES[0]))
+
+//	Forward declarations / Function prototypes
+static void stats_start(int, const string);
+static long stats_now(void);
+static void stats_span(const char*, const char*, long);
+static void stats_file(const char*, size_t, int, int, int, long);
+static int stats_finish(void);
+static stat_event add_event(const char*, const char*, long);
+static void print_summary(long);
+static int write_trace(const string);
+static void append_json(sink, const char*);
+static int by_duration(const void*, const void*);
+
+/**
+ * @brief Turns recording on.
+ * @param summary Print a summary from finish.
+ * @param trace Chrome trace-event file written by finish, or NULL.
+ */
+static void stats_start(int summary, const string trace) {
+	if (!summary && !trace) return;
+	SUMMARY = summary;
+	if (trace) {
+		TRACE = Mem.alloc(strlen(trace) + 1);
+		strcpy(TRACE, trace);
+	}
+	EVENTS = List.new(256);
+	clock_gettime(CLOCK_MONOTONIC, &START);
+	ENABLED = 1;
+	TID = ++THREADS;		//	the starting thread is "main"
+}
+/**
+ * @brief Returns the current time for a span start.
+ * @return Microseconds since start, or 0 when recording is off.
+ */
+static long stats_now(void) {
+	if (!ENABLED) return 0;
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec - START.tv_sec) * 1000000L + (ts.tv_nsec - START.tv_nsec) / 1000;
+}
+/**
+ * @brief Appends a span ending now; the caller fills in file details.
+ * @return The event, or NULL when recording is off or the list is full.
+ */
+static stat_event add_event(const char* stage, const char* file, long begin) {
+	if (!ENABLED) return NULL;
+	long end = stats_now();
+	stat_event e = Mem.alloc(sizeof(struct stat_event_s));
+	if (!e) return NULL;
+	memset(e, 0, sizeof(struct stat_event_s));
+	e->stage = stage;
+	e->begin = begin;
+	e->dur = end - begin;
+	if (file) {
+		e->file = Mem.alloc(strlen(file) + 1);
+		strcpy(e->file, file);
+	}
+
+	pthread_mutex_lock(&LOCK);
+	if (!TID) TID = ++THREADS;
+	e->tid = TID;
+	int full = List.count(EVENTS) >= STATS_MAX_EVENTS;
+	if (full) {
+		DROPPED++;
+	} else {
+		List.add(EVENTS, e);
+	}
+	pthread_mutex_unlock(&LOCK);
+	if (full) {
+		if (e->file) Mem.free(e->file);
+		Mem.free(e);
+		return NULL;
+	}
+	return e;
+}
+/**
+ * @brief Records a stage span from begin until now on the calling thread.
+ * @param stage Stage name (static string).
+ * @param file File the span worked on, or NULL.
+ * @param begin Value of now at the start of the span.
+ */
+static void stats_span(const char* stage, const char* file, long begin) {
+	add_event(stage, file, begin);
+}
+/**
+ * @brief Records the parse of one source file.
+ * @param path Source file.
+ * @param bytes Bytes read.
+ * @param kept Comment blocks kept.
+ * @param dropped Comment blocks dropped.
+ * @param cached 1 if the parse cache served the file.
+ * @param begin Value of now at the start of the parse.
+ */
+static void stats_file(const char* path, size_t bytes, int kept, int dropped, int cached, long begin) {
+	stat_event e = add_event("parse", path, begin);
+	if (!e) return;
+	//	written before any reader: the list is only read after the workers joined
+	e->is_file = 1;
+	e->bytes = bytes;
+	e->kept = kept;
+	e->dropped = dropped;
+	e->cached = cached;
+}
+/**
+ * @brief Prints the summary and writes the trace, then turns recording off.
+ * @return 0 on success, non-zero if the trace file cannot be written.
+ */
+static int stats_finish(void) {
+	if (!ENABLED) return 0;
+	long wall = stats_now();
+	ENABLED = 0;			//	writing the trace must not record itself
+
+	int ret = 0;
+	if (SUMMARY) print_summary(wall);
+	if (TRACE) {
+		ret = write_trace(TRACE);
+		if (ret == 0) printf("Trace written to %s\n", TRACE);
+		Mem.free(TRACE);
+		TRACE = NULL;
+	}
+
+	for (int i = 0; i < List.count(EVENTS); i++) {
+		stat_event e = List.getAt(EVENTS, i);
+		if (e->file) Mem.free(e->file);
+		Mem.free(e);
+	}
+	List.free(EVENTS);
+	EVENTS = NULL;
+	DROPPED = 0;
+	return ret;
+}
+/**
+ * @brief Prints stage times, per-file comment counts (slowest first) and arena memory.
+ * @param wall Microseconds since start.
+ */
+static void print_summary(long wall) {
+	struct stage_total_s totals[STAGE_COUNT];
+	memset(totals, 0, sizeof(totals));
+	for (int s = 0; s < STAGE_COUNT; s++) totals[s].name = STAGES[s];
+
+	int count = List.count(EVENTS);
+	int files = 0, cached = 0;
+	long kept = 0, dropped = 0;
+	size_t bytes = 0;
+	stat_event* parsed = Mem.alloc((count ? count : 1) * sizeof(stat_event));
+	for (int i = 0; i < count; i++) {
+		stat_event e = List.getAt(EVENTS, i);
+		for (int s = 0; s < STAGE_COUNT; s++) {
+			struct stage_total_s* t = &totals[s];
+			if (strcmp(e->stage, t->name) != 0) continue;
+			if (t->spans == 0 || e->begin < t->first) t->first = e->begin;
+			if (e->begin + e->dur > t->last) t->last = e->begin + e->dur;
+			t->busy += e->dur;
+			t->spans++;
+		}
+		if (!e->is_file) continue;
+		parsed[files++] = e;
+		bytes += e->bytes;
+		kept += e->kept;
+		dropped += e->dropped;
+		cached += e->cached;
+	}
+
+	printf("Stats: %.1f ms wall, %d files, %.2f MB read, %d thread(s)\n",
+			wall / 1000.0, files, bytes / (1024.0 * 1024.0), THREADS);
+	printf("   %-10s %10s %10s %8s\n", "stage", "wall ms", "busy ms", "spans");
+	for (int s = 0; s < STAGE_COUNT; s++) {
+		struct stage_total_s* t = &totals[s];
+		if (t->spans == 0) continue;
+		printf("   %-10s %10.1f %10.1f %8d\n", t->name, (t->last - t->first) / 1000.0, t->busy / 1000.0, t->spans);
+	}
+	printf("Comments: %ld kept, %ld dropped (%d file(s) from cache)\n", kept, dropped, cached);
+	if (DROPPED) printf("   %ld later span(s) not recorded (limit %d)\n", DROPPED, STATS_MAX_EVENTS);
+
+	if (files > 0) {
+		qsort(parsed, files, sizeof(stat_event), by_duration);
+		printf("Files, slowest first:\n");
+		printf("   %10s %10s %6s %8s  %s\n", "ms", "KB", "kept", "dropped", "file");
+		for (int i = 0; i < files; i++) {
+			stat_event e = parsed[i];
+			printf("   %10.2f %10.1f %6d %8d  %s%s\n", e->dur / 1000.0, e->bytes / 1024.0,
+					e->kept, e->dropped, e->file, e->cached ? " (cached)" : "");
+		}
+	}
+	Mem.free(parsed);
+
+	//	parse results are counted by the arenas; other Mem calls are not counted
+	arena_stats st = Arena.stats();
+	printf("Arena memory: %ld arenas, %ld blocks, %ld allocations, peak %zu bytes\n",
+			st.arenas, st.blocks, st.allocs, st.peak);
+	struct rusage ru;
+	if (getrusage(RUSAGE_SELF, &ru) == 0) printf("Peak RSS: %ld KB\n", ru.ru_maxrss);
+}
+/**
+ * @brief Orders parse records slowest first, then by path.
+ */
+static int by_duration(const void* a, const void* b) {
+	stat_event x = *(stat_event*)a;
+	stat_event y = *(stat_event*)b;
+	if (x->dur != y->dur) return x->dur < y->dur ? 1 : -1;
+	return strcmp(x->file, y->file);
+}
+/**
+ * @brief Writes all spans as Chrome trace-event JSON ("X" complete events).
+ * @param path Trace file.
+ * @return 0 on success, non-zero on failure.
+ */
+static int write_trace(const string path) {
+	sink out = Sink.open(path);
+	if (!out) {
+		fprintf(stderr, "Failed to write trace '%s'\n", path);
+		return 1;
+	}
+
+	Sink.append(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	for (int t = 1; t <= THREADS; t++) {
+		Sink.appendf(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s",
+				t, t == 1 ? "main" : "worker");
+		if (t > 1) Sink.appendf(out, " %d", t - 1);
+		Sink.append(out, "\"}},\n");
+	}
+	for (int i = 0; i < List.count(EVENTS); i++) {
+		stat_event e = List.getAt(EVENTS, i);
+		Sink.append(out, "{\"name\":\"");
+		append_json(out, e->file ? e->file : e->stage);
+		Sink.appendf(out, "\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%ld,\"dur\":%ld,\"pid\":1,\"tid\":%d",
+				e->stage, e->begin, e->dur, e->tid);
+		if (e->is_file) {
+			Sink.appendf(out, ",\"args\":{\"bytes\":%zu,\"kept\":%d,\"dropped\":%d,\"cached\":%d}",
+					e->bytes, e->kept, e->dropped, e->cached);
+		}
+		Sink.append(out, i + 1 < List.count(EVENTS) ? "},\n" : "}\n");
+	}
+	Sink.append(out, "]}\n");
+
+	return Sink.close(out);
+}
+/**
+ * @brief Writes a string escaped for a JSON string literal.
+ */
+static void append_json(sink out, const char* str) {
+	const char* run = str;
+	for (const char* p = str; *p; p++) {
+		unsigned char ch = (unsigned char)*p;
+		if (ch != '"' && ch != '\\' && ch >= 0x20) continue;
+		Sink.write(out, run, p - run);
+		if (ch == '"' || ch == '\\') {
+			Sink.appendf(out, "\\%c", ch);
+		} else {
+			Sink.appendf(out, "\\u%04x", ch);
+		}
+		run = p + 1;
+	}
+	Sink.append(out, run);
+}
+
+const IStats Stats = {
+	.start = stats_start,
+	.now = stats_now,
+	.span = stats_span,
+	.file = stats_file,
+	.finish = stats_finish
+};
@@ -0,0 +1,143 @@
+// strmap.c
+#include "strmap.h"
+#include <stdint.h>
+#include <string.h>
+
+/* structure representing one slot of the table */
+struct slot_s {
+	const char* key;	/**< Key bytes; NULL for an empty slot */
+	size_t len;			/**< Key length */
+	uint64_t hash;		/**< Cached key hash */
+	object value;		/**< Mapped value */
+};
+/* structure representing the map */
+struct strmap_s {
+	struct slot_s* slots;	/**< Power-of-two sized table */
+	size_t mask;			/**< Table size - 1 */
+	int count;				/**< Occupied slots */
+};
+
+/**
+ * @brief FNV-1a hash of a key.
+ */
+static uint64_t hash_key(const char* key, size_t len) {
+	uint64_t h = 0xcbf29ce484222325ULL;
+	while (len--) h = (h ^ (unsigned char)*key++) * 0x100000001b3ULL;
+	return h;
+}
+/**
+ * @brief Finds the slot of a key, or the empty slot where it belongs.
+ */
+static struct slot_s* find_slot(strmap m, const char* key, size_t len, uint64_t hash) {
+	size_t i = hash & m->mask;
+	while (m->slots[i].key) {
+		struct slot_s* s = &m->slots[i];
+		if (s->hash == hash && s->len == len && memcmp(s->key, key, len) == 0) return s;
+		i = (i + 1) & m->mask;
+	}
+	return &m->slots[i];
+}
+/**
+ * @brief Allocates a zeroed table of the given size.
+ */
+static struct slot_s* new_slots(size_t size) {
+	struct slot_s* slots = Mem.alloc(size * sizeof(struct slot_s));
+	if (slots) memset(slots, 0, size * sizeof(struct slot_s));
+	return slots;
+}
+/**
+ * @brief Creates a map.
+ * @param capacity Expected number of entries.
+ * @return Allocated map or NULL on failure.
+ */
+static strmap strmap_new(int capacity) {
+	size_t size = 16;
+	while (size < (size_t)capacity * 2) size <<= 1;
+	
+	strmap m = Mem.alloc(sizeof(struct strmap_s));
+	if (!m) return NULL;
+	m->slots = new_slots(size);
+	m->mask = size - 1;
+	m->count = 0;
+	if (!m->slots) {
+		Mem.free(m);
+		return NULL;
+	}
+	return m;
+}
+/**
+ * @brief Frees the map (not the keys or values).
+ */
+static void strmap_free(strmap m) {
+	if (!m) return;
+	Mem.free(m->slots);
+	Mem.free(m);
+}
+/**
+ * @brief Doubles the table, keeping the load factor under one half.
+ */
+static void grow(strmap m) {
+	size_t size = (m->mask + 1) * 2;
+	struct slot_s* slots = new_slots(size);
+	if (!slots) return;
+	
+	struct slot_s* old = m->slots;
+	size_t old_size = m->mask + 1;
+	m->slots = slots;
+	m->mask = size - 1;
+	for (size_t i = 0; i < old_size; i++) {
+		if (old[i].key) *find_slot(m, old[i].key, old[i].len, old[i].hash) = old[i];
+	}
+	Mem.free(old);
+}
+/**
+ * @brief Inserts or replaces the value of a (pointer, length) key.
+ */
+static void strmap_putn(strmap m, const char* key, size_t len, object value) {
+	if ((size_t)(m->count + 1) * 2 > m->mask + 1) grow(m);
+	
+	uint64_t hash = hash_key(key, len);
+	struct slot_s* s = find_slot(m, key, len, hash);
+	if (!s->key) {
+		s->key = key;
+		s->len = len;
+		s->hash = hash;
+		m->count++;
+	}
+	s->value = value;
+}
+/**
+ * @brief Returns the value of a (pointer, length) key, or NULL.
+ */
+static object strmap_getn(strmap m, const char* key, size_t len) {
+	struct slot_s* s = find_slot(m, key, len, hash_key(key, len));
+	return s->key ? s->value : NULL;
+}
+/**
+ * @brief Inserts or replaces the value of a NUL-terminated key.
+ */
+static void strmap_put(strmap m, const char* key, object value) {
+	strmap_putn(m, key, strlen(key), value);
+}
+/**
+ * @brief Returns the value of a NUL-terminated key, or NULL.
+ */
+static object strmap_get(strmap m, const char* key) {
+	return strmap_getn(m, key, strlen(key));
+}
+/**
+ * @brief Returns the number of entries.
+ */
+static int strmap_count(strmap m) {
+	return m->count;
+}
+
+const IStrMap StrMap = {
+	.new = strmap_new,
+	.free = strmap_free,
+	.put = strmap_put,
+	.get = strmap_get,
+	.putn = strmap_putn,
+	.getn = strmap_getn,
+	.count = strmap_count
+};
@@ -0,0 +1,264 @@
+// symbols.c
+#include "symbols.h"
+#include "strmap.h"
+#include <stdint.h>
+#include <string.h>
+
+/* structure representing the symbol index of a document */
+struct symtab_s {
+	strmap map;			/**< Name view -> symbol */
+	symbol* items;		/**< Symbols in document order */
+	int count;			/**< Symbols in use */
+	symbol** refs;		/**< Referrer lists of all symbols, back to back */
+	uint64_t first[256];	/**< Name lengths (bit len & 63) by first byte */
+	uint64_t last[256];		/**< Name lengths by last byte */
+	uint64_t* bloom;	/**< Two bits per name in one word; most other words miss here */
+	uint64_t mask;		/**< Bloom filter size in words - 1 */
+};
+/* structure representing one reference found while building */
+struct ref_s {
+	int to;				/**< Index of the symbol mentioned */
+	int from;			/**< Index of the symbol whose text mentions it */
+};
+/* structure representing the references found while building */
+struct ref_buf_s {
+	struct ref_s* items;
+	int count;
+	int capacity;
+};
+
+/*	identifier byte: letter, digit or underscore */
+#define IS_IDENT(c) ((unsigned)(((c) | 0x20) - 'a') < 26 || (unsigned)((c) - '0') < 10 || (c) == '_')
+/*	one step of the word hash, taken while a word is scanned */
+#define WORD_HASH(h, c) (((h) ^ (unsigned char)(c)) * 0x100000001b3ULL)
+/*	Bloom filter bits per symbol */
+#define BLOOM_BITS 16
+/*	the two bits of a word hash, both in the word picked by its high half */
+#define BLOOM_BITS_OF(h) ((1ULL << ((h) & 63)) | (1ULL << (((h) >> 6) & 63)))
+#define BLOOM_WORD(st, h) (st)->bloom[((h) >> 32) & (st)->mask]
+/*	length bit of a word in the first/last byte tables */
+#define LEN_BIT(n) (1ULL << ((n) & 63))
+
+//	Forward declarations / Function prototypes
+static symtab symbols_build(list);
+static void symbols_free(symtab);
+static symbol* symbols_find(symtab, const char*, size_t);
+static symbol* symbols_of(symtab, comment);
+static symbol* symbols_next(symtab, const char**, const char*, const char**);
+static int symbols_count(symtab);
+static int collect_refs(symtab, int, struct ref_buf_s*);
+static int scan_refs(symtab, int, const char*, const char*, struct ref_buf_s*);
+
+/**
+ * @brief Indexes the named declarations of a document and their references.
+ * @param units Units in source order.
+ * @return Index, or NULL on failure.
+ */
+static symtab symbols_build(list units) {
+	int total = 0;
+	for (int i = 0; i < List.count(units); i++) {
+		total += ((unit)List.getAt(units, i))->count;
+	}
+
+	struct ref_buf_s buf = { 0 };
+	symtab st = Mem.alloc(sizeof(struct symtab_s));
+	if (!st) return NULL;
+	memset(st, 0, sizeof(struct symtab_s));
+	st->map = StrMap.new(total + 1);
+	st->items = Mem.alloc((total ? total : 1) * sizeof(symbol));
+	size_t words = 64;
+	while (words * 64 < (size_t)total * BLOOM_BITS) words <<= 1;
+	st->mask = words - 1;
+	st->bloom = Mem.alloc(words * sizeof(uint64_t));
+	if (!st->map || !st->items || !st->bloom) goto fail;
+	memset(st->bloom, 0, words * sizeof(uint64_t));
+
+	//	names first: a reference may point forward
+	for (int i = 0; i < List.count(units); i++) {
+		unit u = List.getAt(units, i);
+		for (int j = 0; j < u->count; j++) {
+			comment c = &u->comments[j];
+			if (c->is_file || c->kind == DECL_NONE || !c->func_name.length) continue;
+			const char* name = SPAN_PTR(c->src, c->func_name);
+			if (StrMap.getn(st->map, name, c->func_name.length)) continue;	//	first declaration wins
+
+			symbol* s = &st->items[st->count++];
+			memset(s, 0, sizeof(symbol));
+			s->name = name;
+			s->length = c->func_name.length;
+			s->c = c;
+			StrMap.putn(st->map, name, s->length, s);
+			uint64_t h = 0;
+			for (size_t k = 0; k < s->length; k++) h = WORD_HASH(h, name[k]);
+			BLOOM_WORD(st, h) |= BLOOM_BITS_OF(h);
+			st->first[(unsigned char)name[0]] |= LEN_BIT(s->length);
+			st->last[(unsigned char)name[s->length - 1]] |= LEN_BIT(s->length);
+		}
+	}
+
+	//	then one scan of each symbol's text
+	for (int i = 0; i < st->count; i++) {
+		if (collect_refs(st, i, &buf) != 0) goto fail;
+	}
+
+	//	group the references by target; referrers stay in document order
+	st->refs = Mem.alloc((buf.count ? buf.count : 1) * sizeof(symbol*));
+	if (!st->refs) goto fail;
+	for (int i = 0; i < buf.count; i++) st->items[buf.items[i].to].ref_count++;
+	int next = 0;
+	for (int i = 0; i < st->count; i++) {
+		st->items[i].refs = st->refs + next;
+		next += st->items[i].ref_count;
+		st->items[i].ref_count = 0;
+	}
+	for (int i = 0; i < buf.count; i++) {
+		symbol* to = &st->items[buf.items[i].to];
+		to->refs[to->ref_count++] = &st->items[buf.items[i].from];
+	}
+	if (buf.items) Mem.free(buf.items);
+	return st;
+
+fail:
+	if (buf.items) Mem.free(buf.items);
+	symbols_free(st);
+	return NULL;
+}
+/**
+ * @brief Frees an index (not the units).
+ */
+static void symbols_free(symtab st) {
+	if (!st) return;
+	if (st->map) StrMap.free(st->map);
+	if (st->items) Mem.free(st->items);
+	if (st->refs) Mem.free(st->refs);
+	if (st->bloom) Mem.free(st->bloom);
+	Mem.free(st);
+}
+/**
+ * @brief Looks up a name.
+ * @return Symbol, or NULL if the name is not documented.
+ */
+static symbol* symbols_find(symtab st, const char* name, size_t len) {
+	return st ? StrMap.getn(st->map, name, len) : NULL;
+}
+/**
+ * @brief Returns the symbol a comment defines, or NULL.
+ */
+static symbol* symbols_of(symtab st, comment c) {
+	if (!st || c->is_file || c->kind == DECL_NONE || !c->func_name.length) return NULL;
+	symbol* s = StrMap.getn(st->map, SPAN_PTR(c->src, c->func_name), c->func_name.length);
+	return s && s->c == c ? s : NULL;
+}
+/**
+ * @brief Finds the next identifier in a text that names a symbol.
+ * @param st Index.
+ * @param p In/out: scan position; moved past the identifier found.
+ * @param end End of the text.
+ * @param at Output: start of the identifier found.
+ * @return Symbol, or NULL when the rest of the text names none.
+ */
+static symbol* symbols_next(symtab st, const char** p, const char* end, const char** at) {
+	const char* q = *p;
+	while (q < end) {
+		char ch = *q;
+		if (ch == '`') {
+			//	inline code is left as written
+			const char* close = memchr(q + 1, '`', end - q - 1);
+			q = close ? close + 1 : end;
+			continue;
+		}
+		if (!IS_IDENT(ch)) {
+			q++;
+			continue;
+		}
+		const char* word = q;
+		uint64_t h = 0;
+		while (q < end && IS_IDENT(*q)) {
+			h = WORD_HASH(h, *q);
+			q++;
+		}
+		if (*word >= '0' && *word <= '9') continue;
+		if (word > *p && (word[-1] == '@' || word[-1] == '\\')) continue;	//	command word
+		//	cheap tests first: length by first and last byte (in cache), then the filter
+		uint64_t len = LEN_BIT(q - word);
+		if (!(st->first[(unsigned char)*word] & len) || !(st->last[(unsigned char)q[-1]] & len)) continue;
+		uint64_t bits = BLOOM_BITS_OF(h);
+		if ((BLOOM_WORD(st, h) & bits) != bits) continue;
+
+		symbol* s = StrMap.getn(st->map, word, q - word);
+		if (s) {
+			*p = q;
+			*at = word;
+			return s;
+		}
+	}
+	*p = end;
+	return NULL;
+}
+/**
+ * @brief Returns the number of symbols.
+ */
+static int symbols_count(symtab st) {
+	return st ? st->count : 0;
+}
+/**
+ * @brief Records the symbols mentioned by one symbol's brief, details, see
+ *			lines and signature.
+ * @return 0 on success, non-zero if the buffer cannot grow.
+ */
+static int collect_refs(symtab st, int from, struct ref_buf_s* buf) {
+	comment c = st->items[from].c;
+	const tag* brief = NULL;		//	only the last @brief is rendered
+	for (int i = 0; i < c->tags.count; i++) {
+		const tag* t = &c->tags.items[i];
+		if (t->kind == TAG_BRIEF && t->count) brief = t;
+	}
+	for (int i = 0; i < c->tags.count; i++) {
+		const tag* t = &c->tags.items[i];
+		if (t != brief && t->kind != TAG_DETAILS && t->kind != TAG_SEE) continue;
+		for (int j = 0; j < t->count; j++) {
+			span line = c->lines.items[t->first + j];
+			const char* p = SPAN_PTR(c->src, line);
+			if (scan_refs(st, from, p, p + line.length, buf) != 0) return 1;
+		}
+	}
+	const char* sig = SPAN_PTR(c->src, c->signature);
+	return scan_refs(st, from, sig, sig + c->signature.length, buf);
+}
+/**
+ * @brief Records each symbol named in a text once per referrer.
+ * @return 0 on success, non-zero if the buffer cannot grow.
+ */
+static int scan_refs(symtab st, int from, const char* p, const char* end, struct ref_buf_s* buf) {
+	const char* at;
+	symbol* s;
+	while ((s = symbols_next(st, &p, end, &at))) {
+		int to = s - st->items;
+		if (to == from || s->last == from + 1) continue;
+		s->last = from + 1;
+		if (buf->count == buf->capacity) {
+			int capacity = buf->capacity ? buf->capacity * 2 : 256;
+			struct ref_s* items = Mem.alloc(capacity * sizeof(struct ref_s));
+			if (!items) return 1;
+			if (buf->items) {
+				memcpy(items, buf->items, buf->count * sizeof(struct ref_s));
+				Mem.free(buf->items);
+			}
+			buf->items = items;
+			buf->capacity = capacity;
+		}
+		buf->items[buf->count].to = to;
+		buf->items[buf->count].from = from;
+		buf->count++;
+	}
+	return 0;
+}
+
+const ISymbols Symbols = {
+	.build = symbols_build,
+	.free = symbols_free,
+	.find = symbols_find,
+	.of = symbols_of,
+	.next = symbols_next,
+	.count = symbols_count
+};
@@ -0,0 +1,317 @@
+// template.c
+#include "template.h"
+#include <stdarg.h>
+#include <string.h>
+
+/*	scopes a name can be used in */
+#define SCOPE_DOC 1
+#define SCOPE_COMMENT 2
+#define SCOPE_ITEM 4
+
+/* structure representing the instructions of one template part */
+struct tmpl_prog_s {
+	tmpl_op* ops;
+	int count;
+	int capacity;
+};
+/* structure representing a compiled template */
+struct tmpl_s {
+	source src;							/**< Template file the literals view into, or NULL */
+	struct tmpl_prog_s parts[3];		/**< Body, header and footer */
+};
+/* structure representing a name templates can use */
+struct tmpl_name_s {
+	const char* name;
+	int scope;			/**< SCOPE_* bits */
+	int field;			/**< tmpl_field written by {{name}}, or -1 for a list */
+	int list;			/**< tmpl_field iterated by {{#name}}, or -1 */
+	tag_kind tag;		/**< Tag kind of TF_TAG and TL_TAG */
+};
+/* structure representing an open section while compiling */
+struct tmpl_open_s {
+	int op;				/**< Index of the opening op, or -1 for a header/footer block */
+	const char* key;	/**< Name as written */
+	size_t len;
+};
+
+static const struct tmpl_name_s NAMES[] = {
+	{ "title", SCOPE_DOC, TF_TITLE, -1, TAG_NONE },
+	{ "name", SCOPE_ITEM, TF_ITEM_NAME, -1, TAG_NONE },
+	{ "text", SCOPE_ITEM, TF_ITEM_TEXT, -1, TAG_NONE },
+	{ "dir", SCOPE_ITEM, TF_ITEM_DIR, -1, TAG_NONE },
+	{ "first", SCOPE_ITEM, TF_FIRST, -1, TAG_NONE },
+	{ "last", SCOPE_ITEM, TF_LAST, -1, TAG_NONE },
+	{ "name", SCOPE_COMMENT, TF_NAME, -1, TAG_NONE },
+	{ "file", SCOPE_COMMENT, TF_FILE, -1, TAG_NONE },
+	{ "kind", SCOPE_COMMENT, TF_KIND, -1, TAG_NONE },
+	{ "type", SCOPE_COMMENT, TF_TYPE, -1, TAG_NONE },
+	{ "signature", SCOPE_COMMENT, TF_SIGNATURE, -1, TAG_NONE },
+	{ "is_file", SCOPE_COMMENT, TF_IS_FILE, -1, TAG_NONE },
+	{ "brief", SCOPE_COMMENT, TF_TAG, -1, TAG_BRIEF },
+	{ "details", SCOPE_COMMENT, TF_TAG, -1, TAG_DETAILS },
+	{ "return", SCOPE_COMMENT, TF_TAG, -1, TAG_RETURN },
+	{ "note", SCOPE_COMMENT, TF_TAG, -1, TAG_NOTE },
+	{ "warning", SCOPE_COMMENT, TF_TAG, -1, TAG_WARNING },
+	{ "author", SCOPE_COMMENT, TF_TAG, -1, TAG_AUTHOR },
+	{ "since", SCOPE_COMMENT, TF_TAG, -1, TAG_SINCE },
+	{ "version", SCOPE_COMMENT, TF_TAG, -1, TAG_VERSION },
+	{ "deprecated", SCOPE_COMMENT, TF_TAG, -1, TAG_DEPRECATED },
+	{ "todo", SCOPE_COMMENT, TF_TAG, -1, TAG_TODO },
+	{ "pre", SCOPE_COMMENT, TF_TAG, -1, TAG_PRE },
+	{ "post", SCOPE_COMMENT, TF_TAG, -1, TAG_POST },
+	{ "see", SCOPE_COMMENT, TF_TAG, TL_TAG, TAG_SEE },
+	{ "params", SCOPE_COMMENT, -1, TL_TAG, TAG_PARAM },
+	{ "tparams", SCOPE_COMMENT, -1, TL_TAG, TAG_TPARAM },
+	{ "retvals", SCOPE_COMMENT, -1, TL_TAG, TAG_RETVAL },
+	{ "throws", SCOPE_COMMENT, -1, TL_TAG, TAG_THROWS },
+	{ "args", SCOPE_COMMENT, -1, TL_ARGS, TAG_NONE },
+	{ "refs", SCOPE_COMMENT, -1, TL_REFS, TAG_NONE }
+};
+
+//	Forward declarations / Function prototypes
+static tmpl template_compile(const string, const char*, size_t);
+static tmpl template_load(const string);
+static const tmpl_op* template_program(tmpl, tmpl_part, int*);
+static void template_free(tmpl);
+static const struct tmpl_name_s* lookup_name(const char*, size_t, int);
+static int push_op(struct tmpl_prog_s*, tmpl_op);
+static int is_blank(const char*, const char*);
+static void compile_error(const string, int, const char*, ...);
+
+/**
+ * @brief Compiles template text into instructions.
+ * @param name Name used in error messages.
+ * @param text Template text; must outlive the template.
+ * @param len Length of the text.
+ * @return Template, or NULL after printing an error.
+ */
+static tmpl template_compile(const string name, const char* text, size_t len) {
+	tmpl t = Mem.alloc(sizeof(struct tmpl_s));
+	if (!t) return NULL;
+	memset(t, 0, sizeof(struct tmpl_s));
+
+	struct tmpl_open_s open[TMPL_MAX_DEPTH];
+	int depth = 0;
+	int loop = -1;					//	depth of the open loop, if any
+	tmpl_part part = TMPL_BODY;
+	const char* end = text + len;
+	const char* p = text;			//	scan position
+	const char* lit = text;			//	start of the pending literal
+	const char* line_start = text;
+	int line = 1;
+
+	while (p < end) {
+		const char* tag = p;
+		while ((tag = memchr(tag, '{', end - tag)) && (tag + 1 >= end || tag[1] != '{')) tag++;
+		for (const char* nl = p; (nl = memchr(nl, '\n', (tag ? tag : end) - nl)); nl++) {
+			line++;
+			line_start = nl + 1;
+		}
+		if (!tag) break;
+
+		const char* close = NULL;
+		for (const char* q = tag + 2; q + 1 < end; q++) {
+			if (q[0] == '}' && q[1] == '}') { close = q; break; }
+		}
+		if (!close) {
+			compile_error(name, line, "unclosed tag");
+			goto fail;
+		}
+		char sigil = tag[2] == '#' || tag[2] == '^' || tag[2] == '/' || tag[2] == '!' ? tag[2] : 0;
+		const char* key = tag + 2 + (sigil != 0);
+		const char* key_end = close;
+		while (key < key_end && (*key == ' ' || *key == '\t')) key++;
+		while (key_end > key && (key_end[-1] == ' ' || key_end[-1] == '\t')) key_end--;
+		size_t key_len = key_end - key;
+
+		//	a section tag or comment alone on its line takes the line with it
+		const char* next = close + 2;
+		const char* lit_end = tag;
+		if (sigil && line_start >= lit && is_blank(line_start, tag)) {
+			const char* q = next;
+			while (q < end && (*q == ' ' || *q == '\t' || *q == '\r')) q++;
+			if (q == end || *q == '\n') {
+				lit_end = line_start;
+				next = q < end ? q + 1 : end;
+			}
+		}
+		if (lit_end > lit) {
+			tmpl_op op = { TOP_TEXT, 0, TAG_NONE, lit, lit_end - lit, -1 };
+			if (push_op(&t->parts[part], op) != 0) goto fail;
+		}
+
+		if (sigil == '!') {
+			//	comment
+		} else if (sigil == '/') {
+			if (depth == 0 || open[depth - 1].len != key_len || memcmp(open[depth - 1].key, key, key_len) != 0) {
+				compile_error(name, line, "unexpected {{/%.*s}}", (int)key_len, key);
+				goto fail;
+			}
+			struct tmpl_open_s* o = &open[--depth];
+			if (o->op < 0) {
+				part = TMPL_BODY;
+			} else {
+				struct tmpl_prog_s* prog = &t->parts[part];
+				tmpl_op op = { TOP_END, prog->ops[o->op].field, TAG_NONE, NULL, 0, o->op };
+				if (push_op(prog, op) != 0) goto fail;
+				prog->ops[o->op].jump = prog->count - 1;
+			}
+			if (loop == depth) loop = -1;
+		} else {
+			if ((sigil == '#' || sigil == '^') && depth == TMPL_MAX_DEPTH) {
+				compile_error(name, line, "sections nested too deep");
+				goto fail;
+			}
+			if (sigil == '#' && depth == 0 && part == TMPL_BODY &&
+					((key_len == 6 && memcmp(key, "header", 6) == 0) || (key_len == 6 && memcmp(key, "footer", 6) == 0))) {
+				part = key[0] == 'h' ? TMPL_HEADER : TMPL_FOOTER;
+				if (t->parts[part].count > 0) {
+					compile_error(name, line, "second {{#%.*s}} block", (int)key_len, key);
+					goto fail;
+				}
+				open[depth++] = (struct tmpl_open_s){ -1, key, key_len };
+				goto next;
+			}
+
+			int scope = part != TMPL_BODY ? SCOPE_DOC : loop >= 0 ? SCOPE_ITEM | SCOPE_COMMENT : SCOPE_COMMENT;
+			const struct tmpl_name_s* n = lookup_name(key, key_len, scope);
+			if (!n) {
+				compile_error(name, line, "unknown field '%.*s'", (int)key_len, key);
+				goto fail;
+			}
+			tmpl_op op = { TOP_FIELD, n->field, n->tag, NULL, 0, -1 };
+			if (sigil == 0) {
+				if (n->field < 0 || n->field == TF_IS_FILE || n->field == TF_FIRST || n->field == TF_LAST) {
+					compile_error(name, line, "'%.*s' can only be used as a section", (int)key_len, key);
+					goto fail;
+				}
+			} else if (n->list >= 0) {
+				if (sigil == '#' && loop >= 0) {
+					compile_error(name, line, "list '%.*s' inside another list", (int)key_len, key);
+					goto fail;
+				}
+				op.op = sigil == '#' ? TOP_LOOP : TOP_INVERTED;
+				op.field = n->list;
+				if (sigil == '#') loop = depth;
+			} else {
+				op.op = sigil == '#' ? TOP_SECTION : TOP_INVERTED;
+			}
+			if (push_op(&t->parts[part], op) != 0) goto fail;
+			if (sigil) open[depth++] = (struct tmpl_open_s){ t->parts[part].count - 1, key, key_len };
+		}
+
+	next:
+		if (next > close + 2) {
+			line++;
+			line_start = next;
+		}
+		p = lit = next;
+	}
+	if (depth > 0) {
+		compile_error(name, line, "unclosed {{#%.*s}}", (int)open[depth - 1].len, open[depth - 1].key);
+		goto fail;
+	}
+	if (end > lit) {
+		tmpl_op op = { TOP_TEXT, 0, TAG_NONE, lit, end - lit, -1 };
+		if (push_op(&t->parts[TMPL_BODY], op) != 0) goto fail;
+	}
+	return t;
+
+fail:
+	template_free(t);
+	return NULL;
+}
+/**
+ * @brief Reads and compiles a template file.
+ * @param path Template file.
+ * @return Template owning the file's text, or NULL after printing an error.
+ */
+static tmpl template_load(const string path) {
+	source src = Source.open(path);
+	if (!src) {
+		fprintf(stderr, "failed to open template: %s\n", path);
+		return NULL;
+	}
+	tmpl t = template_compile(path, src->data, src->size);
+	if (!t) {
+		Source.release(src);
+		return NULL;
+	}
+	t->src = src;
+	return t;
+}
+/**
+ * @brief Returns the instructions of a template part.
+ */
+static const tmpl_op* template_program(tmpl t, tmpl_part part, int* count) {
+	*count = t->parts[part].count;
+	return t->parts[part].ops;
+}
+/**
+ * @brief Frees a template and releases its file.
+ */
+static void template_free(tmpl t) {
+	if (!t) return;
+	for (int i = 0; i < 3; i++) {
+		if (t->parts[i].ops) Mem.free(t->parts[i].ops);
+	}
+	if (t->src) Source.release(t->src);
+	Mem.free(t);
+}
+/**
+ * @brief Looks up a name; item names shadow comment names inside a list.
+ * @return Name entry, or NULL if the name is unknown in the scope.
+ */
+static const struct tmpl_name_s* lookup_name(const char* key, size_t len, int scope) {
+	for (size_t i = 0; i < sizeof(NAMES) / sizeof(NAMES[0]); i++) {
+		const struct tmpl_name_s* n = &NAMES[i];
+		if ((n->scope & scope) && strlen(n->name) == len && memcmp(n->name, key, len) == 0) return n;
+	}
+	return NULL;
+}
+/**
+ * @brief Appends an instruction to a program.
+ * @return 0 on success, non-zero if the program cannot grow.
+ */
+static int push_op(struct tmpl_prog_s* prog, tmpl_op op) {
+	if (prog->count == prog->capacity) {
+		int capacity = prog->capacity ? prog->capacity * 2 : 16;
+		tmpl_op* ops = Mem.alloc(capacity * sizeof(tmpl_op));
+		if (!ops) return 1;
+		if (prog->ops) {
+			memcpy(ops, prog->ops, prog->count * sizeof(tmpl_op));
+			Mem.free(prog->ops);
+		}
+		prog->ops = ops;
+		prog->capacity = capacity;
+	}
+	prog->ops[prog->count++] = op;
+	return 0;
+}
+/**
+ * @brief Tests whether a view holds only spaces and tabs.
+ */
+static int is_blank(const char* p, const char* end) {
+	for (; p < end; p++) {
+		if (*p != ' ' && *p != '\t') return 0;
+	}
+	return 1;
+}
+/**
+ * @brief Prints a compile error as `name:line: message`.
+ */
+static void compile_error(const string name, int line, const char* fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	fprintf(stderr, "%s:%d: ", name, line);
+	vfprintf(stderr, fmt, args);
+	fputc('\n', stderr);
+	va_end(args);
+}
+
+const ITemplate Template = {
+	.compile = template_compile,
+	.load = template_load,
+	.program = template_program,
+	.free = template_free
+};
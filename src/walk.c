@@ -0,0 +1,386 @@
+// walk.c
+#define _DEFAULT_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#include "walk.h"
+#include <dirent.h>
+#include <fnmatch.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*	any number of directories */
+#define GLOBSTAR "**"
+
+/* structure representing a directory waiting to be read */
+struct walk_item_s {
+	string dir;			/**< Directory path ("" for the current directory) */
+	int comp;			/**< Pattern component its entries are matched against */
+};
+typedef struct walk_item_s* walk_item;
+/* structure representing the expansion of one pattern */
+struct walk_s {
+	string* comps;		/**< Pattern components after the base directory */
+	int count;			/**< Number of components */
+	int c_only;			/**< Last component is `*`: match .c and .h files only */
+	walk_item* queue;	/**< Directories to read (a stack) */
+	int queued;			/**< Items in queue */
+	int capacity;		/**< Slots in queue */
+	list found;			/**< Matched paths */
+	int busy;			/**< Workers reading a directory */
+	pthread_mutex_t lock;	/**< Guards queue, found and busy */
+	pthread_cond_t more;	/**< Signals queued directories or the end of the walk */
+};
+typedef struct walk_s* walk;
+
+//	Forward declarations / Function prototypes
+static int walk_is_pattern(const string);
+static int walk_expand(const string, list);
+static int walk_match(const string, const string);
+static int match_parts(const char*, const char*);
+static int match_component(const char*, size_t, const char*, size_t);
+static void* walk_worker(void*);
+static void read_dir(walk, walk_item, list, list);
+static void match_entry(walk, const string, const char*, int, int, list, list);
+static walk_item new_item(const string, const char*, int);
+static void push_item(walk, walk_item);
+static string join_path(const string, const char*);
+static int is_c_source(const char*);
+static int by_path(const void*, const void*);
+
+/**
+ * @brief Tests whether a path token is a pattern.
+ * @param token Path from a target line.
+ * @return 1 if it holds `*`, `?` or `[`, 0 otherwise.
+ */
+static int walk_is_pattern(const string token) {
+	return strpbrk(token, "*?[") != NULL;
+}
+/**
+ * @brief Expands a pattern into the files it matches, sorted and unique.
+ * @param pattern Pattern to expand.
+ * @param out List receiving allocated paths (caller frees).
+ * @return Number of paths added, or -1 if the base directory cannot be read.
+ */
+static int walk_expand(const string pattern, list out) {
+	string copy = Mem.alloc(strlen(pattern) + 1);
+	strcpy(copy, pattern);
+
+	//	split into components; the literal ones up front form the base directory
+	int parts = 1;
+	for (const char* p = copy; *p; p++) parts += *p == '/';
+	string* comps = Mem.alloc((parts + 1) * sizeof(string));
+	int count = 0;
+	string save = NULL;
+	for (string c = strtok_r(copy, "/", &save); c; c = strtok_r(NULL, "/", &save)) {
+		if (count > 0 && strcmp(c, GLOBSTAR) == 0 && strcmp(comps[count - 1], GLOBSTAR) == 0) continue;
+		comps[count++] = c;
+	}
+	int base = 0;
+	while (base < count - 1 && !walk_is_pattern(comps[base])) base++;
+
+	string_builder sb = StringBuilder.new(strlen(pattern) + 2);
+	if (pattern[0] == '/') StringBuilder.append(sb, "/");
+	for (int i = 0; i < base; i++) StringBuilder.appendf(sb, i ? "/%s" : "%s", comps[i]);
+	string dir = StringBuilder.toString(sb);
+	StringBuilder.free(sb);
+
+	struct walk_s w;
+	w.comps = comps + base;
+	w.count = count - base;
+	int ret = -1;
+	DIR* probe = opendir(dir[0] ? dir : ".");
+	if (!probe || w.count == 0) {
+		if (probe) closedir(probe);
+		goto cleanup;
+	}
+	closedir(probe);
+
+	//	a trailing `**` means every file below
+	string all = "*";
+	if (strcmp(w.comps[w.count - 1], GLOBSTAR) == 0) {
+		comps[count++] = all;
+		w.count++;
+	}
+	w.c_only = strcmp(w.comps[w.count - 1], "*") == 0;
+	w.queue = NULL;
+	w.queued = 0;
+	w.capacity = 0;
+	w.found = List.new(64);
+	w.busy = 0;
+	pthread_mutex_init(&w.lock, NULL);
+	pthread_cond_init(&w.more, NULL);
+	push_item(&w, new_item(dir, NULL, 0));
+
+	//	only recursive patterns are worth more than one thread
+	int recursive = 0;
+	for (int i = 0; i < w.count; i++) recursive |= strcmp(w.comps[i], GLOBSTAR) == 0;
+	int threads = recursive ? (int)sysconf(_SC_NPROCESSORS_ONLN) : 1;
+	if (threads > WALK_THREADS) threads = WALK_THREADS;
+	if (threads < 1) threads = 1;
+
+	pthread_t workers[WALK_THREADS];
+	int started = 0;
+	while (started < threads - 1 && pthread_create(&workers[started], NULL, walk_worker, &w) == 0) started++;
+	walk_worker(&w);
+	for (int i = 0; i < started; i++) pthread_join(workers[i], NULL);
+
+	//	sorted and unique, so documents do not depend on directory order
+	int found = List.count(w.found);
+	string* paths = Mem.alloc((found ? found : 1) * sizeof(string));
+	for (int i = 0; i < found; i++) paths[i] = List.getAt(w.found, i);
+	qsort(paths, found, sizeof(string), by_path);
+	ret = 0;
+	for (int i = 0; i < found; i++) {
+		if (i > 0 && strcmp(paths[i], paths[i - 1]) == 0) {
+			Mem.free(paths[i]);
+			continue;
+		}
+		List.add(out, paths[i]);
+		ret++;
+	}
+	Mem.free(paths);
+	List.free(w.found);
+	if (w.queue) Mem.free(w.queue);
+	pthread_cond_destroy(&w.more);
+	pthread_mutex_destroy(&w.lock);
+
+cleanup:
+	Mem.free(dir);
+	Mem.free(comps);
+	Mem.free(copy);
+	return ret;
+}
+/**
+ * @brief Worker loop: reads queued directories until none are left and no
+ *			other worker can queue more.
+ * @param arg The shared walk.
+ * @return NULL.
+ */
+static void* walk_worker(void* arg) {
+	walk w = arg;
+	list dirs = List.new(16);
+	list files = List.new(64);
+
+	pthread_mutex_lock(&w->lock);
+	while (1) {
+		while (w->queued == 0 && w->busy > 0) pthread_cond_wait(&w->more, &w->lock);
+		if (w->queued == 0) break;
+		walk_item item = w->queue[--w->queued];
+		w->busy++;
+		pthread_mutex_unlock(&w->lock);
+
+		read_dir(w, item, dirs, files);
+		Mem.free(item->dir);
+		Mem.free(item);
+
+		pthread_mutex_lock(&w->lock);
+		for (int i = 0; i < List.count(dirs); i++) push_item(w, List.getAt(dirs, i));
+		for (int i = 0; i < List.count(files); i++) List.add(w->found, List.getAt(files, i));
+		List.clear(dirs);
+		List.clear(files);
+		w->busy--;
+		pthread_cond_broadcast(&w->more);
+	}
+	pthread_mutex_unlock(&w->lock);
+
+	List.free(dirs);
+	List.free(files);
+	return NULL;
+}
+/**
+ * @brief Matches the entries of one directory against the item's component.
+ * @param w Walk.
+ * @param item Directory and component index.
+ * @param dirs Output: directories to read next.
+ * @param files Output: matched files.
+ */
+static void read_dir(walk w, walk_item item, list dirs, list files) {
+	DIR* d = opendir(item->dir[0] ? item->dir : ".");
+	if (!d) return;
+
+	int globstar = strcmp(w->comps[item->comp], GLOBSTAR) == 0;
+	struct dirent* entry;
+	while ((entry = readdir(d)) != NULL) {
+		const char* name = entry->d_name;
+		if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) continue;
+
+		//	d_type is DT_UNKNOWN on some filesystems; links count only as files
+		int type = entry->d_type;
+		if (type == DT_UNKNOWN || type == DT_LNK) {
+			struct stat st;
+			string path = join_path(item->dir, name);
+			if (type == DT_UNKNOWN && lstat(path, &st) == 0) {
+				type = S_ISDIR(st.st_mode) ? DT_DIR : S_ISREG(st.st_mode) ? DT_REG : S_ISLNK(st.st_mode) ? DT_LNK : DT_UNKNOWN;
+			}
+			if (type == DT_LNK && stat(path, &st) == 0 && S_ISREG(st.st_mode)) type = DT_REG;
+			Mem.free(path);
+		}
+
+		if (globstar) {
+			//	`**` takes this directory too, then matches the component after it
+			if (type == DT_DIR && name[0] != '.') List.add(dirs, new_item(item->dir, name, item->comp));
+			match_entry(w, item->dir, name, type, item->comp + 1, dirs, files);
+		} else {
+			match_entry(w, item->dir, name, type, item->comp, dirs, files);
+		}
+	}
+	closedir(d);
+}
+/**
+ * @brief Matches one directory entry against a pattern component.
+ * @param w Walk.
+ * @param dir Directory holding the entry.
+ * @param name Entry name.
+ * @param type Entry type (DT_DIR, DT_REG, ...).
+ * @param comp Component index.
+ * @param dirs Output: directories to read next.
+ * @param files Output: matched files.
+ */
+static void match_entry(walk w, const string dir, const char* name, int type, int comp, list dirs, list files) {
+	if (fnmatch(w->comps[comp], name, FNM_PERIOD) != 0) return;
+
+	if (comp == w->count - 1) {
+		if (type == DT_REG && (!w->c_only || is_c_source(name))) List.add(files, join_path(dir, name));
+	} else if (type == DT_DIR) {
+		List.add(dirs, new_item(dir, name, comp + 1));
+	}
+}
+/**
+ * @brief Creates a queue item for a directory.
+ * @param dir Parent directory.
+ * @param name Entry name, or NULL to use dir itself.
+ * @param comp Component index.
+ * @return Allocated item.
+ */
+static walk_item new_item(const string dir, const char* name, int comp) {
+	walk_item item = Mem.alloc(sizeof(struct walk_item_s));
+	if (name) {
+		item->dir = join_path(dir, name);
+	} else {
+		item->dir = Mem.alloc(strlen(dir) + 1);
+		strcpy(item->dir, dir);
+	}
+	item->comp = comp;
+	return item;
+}
+/**
+ * @brief Pushes a directory onto the walk's queue (lock held or single thread).
+ */
+static void push_item(walk w, walk_item item) {
+	if (w->queued == w->capacity) {
+		int capacity = w->capacity ? w->capacity * 2 : 64;
+		walk_item* queue = Mem.alloc(capacity * sizeof(walk_item));
+		if (w->queue) {
+			memcpy(queue, w->queue, w->queued * sizeof(walk_item));
+			Mem.free(w->queue);
+		}
+		w->queue = queue;
+		w->capacity = capacity;
+	}
+	w->queue[w->queued++] = item;
+}
+/**
+ * @brief Joins a directory and an entry name.
+ * @return Allocated path (caller frees); just the name when dir is "".
+ */
+static string join_path(const string dir, const char* name) {
+	size_t dlen = strlen(dir);
+	size_t len = dlen + strlen(name) + 2;
+	string path = Mem.alloc(len);
+	if (dlen == 0) snprintf(path, len, "%s", name);
+	else snprintf(path, len, dir[dlen - 1] == '/' ? "%s%s" : "%s/%s", dir, name);
+	return path;
+}
+/**
+ * @brief Tests for a C source or header name (exactly `.c` or `.h` at the end).
+ */
+static int is_c_source(const char* name) {
+	size_t len = strlen(name);
+	return len > 2 && name[len - 2] == '.' && (name[len - 1] == 'c' || name[len - 1] == 'h');
+}
+/**
+ * @brief Orders paths bytewise.
+ */
+static int by_path(const void* a, const void* b) {
+	return strcmp(*(const string*)a, *(const string*)b);
+}
+/**
+ * @brief Matches a path against a pattern.
+ * @param pattern Pattern; without `/` it matches the last component.
+ * @param path Path to test.
+ * @return 1 on a match, 0 otherwise.
+ */
+static int walk_match(const string pattern, const string path) {
+	if (!strchr(pattern, '/')) {
+		const char* name = strrchr(path, '/');
+		return fnmatch(pattern, name ? name + 1 : path, FNM_PERIOD) == 0;
+	}
+	return match_parts(pattern, path);
+}
+/**
+ * @brief Matches component by component; `**` consumes any number of them.
+ * @param p Remaining pattern.
+ * @param s Remaining path.
+ * @return 1 on a match, 0 otherwise.
+ */
+static int match_parts(const char* p, const char* s) {
+	while (*p == '/') p++;
+	while (*s == '/') s++;
+	if (!*p) return !*s;
+
+	const char* pend = strchr(p, '/');
+	size_t plen = pend ? (size_t)(pend - p) : strlen(p);
+	if (plen == 2 && p[0] == '*' && p[1] == '*') {
+		const char* rest = p + plen;
+		while (*rest == '/') rest++;
+		if (!*rest) return *s != '\0';		//	a trailing `**` takes everything below
+		while (1) {
+			if (match_parts(rest, s)) return 1;
+			const char* next = strchr(s, '/');
+			if (!next) return 0;
+			s = next + 1;
+		}
+	}
+
+	const char* send = strchr(s, '/');
+	size_t slen = send ? (size_t)(send - s) : strlen(s);
+	if (!*s) return 0;
+	if (!match_component(p, plen, s, slen)) return 0;
+	return match_parts(p + plen, s + slen);
+}
+/**
+ * @brief Matches one path component against one pattern component.
+ * @details Both are views; they are copied to NUL-terminated buffers for
+ *			fnmatch, on the stack unless longer than a file name.
+ * @param p Pattern component.
+ * @param plen Length of p.
+ * @param s Path component.
+ * @param slen Length of s.
+ * @return 1 on a match, 0 otherwise.
+ */
+static int match_component(const char* p, size_t plen, const char* s, size_t slen) {
+	char part[NAME_MAX + 1], name[NAME_MAX + 1];
+	char* pat = plen < sizeof(part) ? part : Mem.alloc(plen + 1);
+	char* str = slen < sizeof(name) ? name : Mem.alloc(slen + 1);
+	int ret = 0;
+	if (pat && str) {
+		memcpy(pat, p, plen);
+		pat[plen] = '\0';
+		memcpy(str, s, slen);
+		str[slen] = '\0';
+		ret = fnmatch(pat, str, FNM_PERIOD) == 0;
+	}
+	if (pat && pat != part) Mem.free(pat);
+	if (str && str != name) Mem.free(str);
+	return ret;
+}
+
+const IWalk Walk = {
+	.isPattern = walk_is_pattern,
+	.expand = walk_expand,
+	.match = walk_match
+};
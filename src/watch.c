@@ -0,0 +1,334 @@
+// watch.c
+#define _POSIX_C_SOURCE 200809L
+#include "watch.h"
+#include "docset.h"
+#include "strmap.h"
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <time.h>
+#include <unistd.h>
+
+#define WATCH_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE)
+#define EVENT_BUFFER 65536
+
+/* structure representing a watched directory */
+struct watched_dir_s {
+	int wd;				/**< inotify watch descriptor */
+	string path;		/**< Directory path ("." for the working directory) */
+};
+typedef struct watched_dir_s* watched_dir;
+/* structure representing the watch session */
+struct watch_s {
+	doxy_config* config;	/**< Configuration */
+	list names;				/**< Requested targets, or NULL for all */
+	docset set;				/**< Targets and their sources, resident */
+	list dirs;				/**< watched_dir entries */
+	strmap by_dir;			/**< Directory path -> watched_dir */
+	int fd;					/**< inotify descriptor */
+};
+typedef struct watch_s* watch;
+
+static volatile sig_atomic_t STOP = 0;
+
+//	Forward declarations / Function prototypes
+static int watch_load(watch);
+static void watch_unload(watch);
+static void write_documents(watch, list);
+static void watch_dir(watch, const string);
+static watched_dir find_dir(watch, int);
+static string dir_of(const string);
+static int read_burst(watch, list, int*);
+static void on_event(watch, struct inotify_event*, list, int*);
+static int is_source_name(const char*);
+static double now_ms(void);
+static void on_signal(int);
+
+/**
+ * @brief Builds the targets, then regenerates them on change until interrupted.
+ * @param config Configuration (file, workers, cache, debug).
+ * @param names Target names, or NULL for every target except `default`.
+ * @return 0 on a clean stop, non-zero if watching failed.
+ */
+static int watch_run(doxy_config* config, list names) {
+	struct watch_s w = { config, names, NULL, List.new(16), StrMap.new(16), -1 };
+	int ret = 1;
+
+	w.fd = inotify_init1(IN_CLOEXEC);
+	if (w.fd < 0) {
+		fprintf(stderr, "Failed to start watching (inotify)\n");
+		goto cleanup;
+	}
+
+	struct sigaction sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = on_signal;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+
+	if (watch_load(&w) != 0) goto cleanup;
+	write_documents(&w, DocSet.documents(w.set));
+	printf("Watching %d sources in %d directories (Ctrl-C to stop)\n", List.count(DocSet.sources(w.set)), List.count(w.dirs));
+	fflush(stdout);
+
+	ret = 0;
+	while (!STOP) {
+		struct pollfd pfd = { w.fd, POLLIN, 0 };
+		if (poll(&pfd, 1, -1) <= 0) continue;
+
+		list changed = List.new(16);
+		int reload = 0;
+		if (read_burst(&w, changed, &reload) != 0) {
+			List.free(changed);
+			break;
+		}
+
+		double start = now_ms();
+		list affected = List.new(8);
+		for (int i = 0; i < List.count(changed) && !reload; i++) {
+			docset_source ds = List.getAt(changed, i);
+			if (access(ds->path, F_OK) != 0) {
+				//	removed: the targets no longer hold
+				reload = 1;
+				break;
+			}
+
+			if (DocSet.refresh(w.set, ds) != 0) continue;
+			if (config->is_debug) printf("Changed: %s\n", ds->path);
+
+			for (int j = 0; j < List.count(ds->documents); j++) {
+				object d = List.getAt(ds->documents, j);
+				if (List.indexOf(affected, d) < 0) List.add(affected, d);
+			}
+		}
+
+		int count = List.count(affected);
+		if (!reload && count == 0) {
+			//	nothing of ours changed (e.g. our own output being replaced)
+			List.free(affected);
+			List.free(changed);
+			continue;
+		}
+		if (reload) {
+			printf("Reloading '%s'\n", config->file);
+			watch_unload(&w);
+			if (watch_load(&w) != 0) {
+				ret = 1;
+				List.free(affected);
+				List.free(changed);
+				break;
+			}
+			count = List.count(DocSet.documents(w.set));
+			write_documents(&w, DocSet.documents(w.set));
+		} else {
+			write_documents(&w, affected);
+		}
+		printf("Regenerated %d target(s) in %.1f ms\n", count, now_ms() - start);
+		fflush(stdout);
+
+		List.free(affected);
+		List.free(changed);
+	}
+
+cleanup:
+	watch_unload(&w);
+	for (int i = 0; i < List.count(w.dirs); i++) {
+		watched_dir wd = List.getAt(w.dirs, i);
+		Mem.free(wd->path);
+		Mem.free(wd);
+	}
+	List.free(w.dirs);
+	StrMap.free(w.by_dir);
+	if (w.fd >= 0) close(w.fd);
+	return ret;
+}
+/**
+ * @brief Loads the targets and watches the directories of their sources.
+ * @param w Watch session.
+ * @return 0 on success, non-zero if the targets cannot be built.
+ */
+static int watch_load(watch w) {
+	w->set = DocSet.load(w->config, w->names);
+	if (!w->set) return 1;
+	if (List.count(DocSet.documents(w->set)) == 0) {
+		printf("Configuration '%s' was empty\n", w->config->file);
+		return 1;
+	}
+
+	list sources = DocSet.sources(w->set);
+	for (int i = 0; i < List.count(sources); i++) {
+		docset_source ds = List.getAt(sources, i);
+		string dir = dir_of(ds->path);
+		watch_dir(w, dir);
+		Mem.free(dir);
+	}
+
+	string dir = dir_of(w->config->file);
+	watch_dir(w, dir);
+	Mem.free(dir);
+	return 0;
+}
+/**
+ * @brief Releases the targets; directory watches are kept.
+ * @param w Watch session.
+ */
+static void watch_unload(watch w) {
+	DocSet.free(w->set);
+	w->set = NULL;
+}
+/**
+ * @brief Writes documents of the set, reporting failed ones (every one with --debug).
+ * @param w Watch session.
+ * @param documents Documents to write.
+ */
+static void write_documents(watch w, list documents) {
+	int count = List.count(documents);
+	int* failed = Mem.alloc((count + 1) * sizeof(int));
+	DocSet.write(w->set, documents, failed);
+	for (int i = 0; i < count; i++) {
+		document d = List.getAt(documents, i);
+		if (failed[i] || w->config->is_debug) {
+			printf("Document '%s' generated [%s]\n", d->output, failed[i] ? "FALSE" : "TRUE");
+		}
+	}
+	Mem.free(failed);
+}
+/**
+ * @brief Adds an inotify watch for a directory, once.
+ * @param w Watch session.
+ * @param path Directory path.
+ */
+static void watch_dir(watch w, const string path) {
+	if (StrMap.get(w->by_dir, path)) return;
+
+	int wd = inotify_add_watch(w->fd, path, WATCH_EVENTS);
+	if (wd < 0) {
+		fprintf(stderr, "Failed to watch directory '%s'\n", path);
+		return;
+	}
+
+	watched_dir d = Mem.alloc(sizeof(struct watched_dir_s));
+	d->wd = wd;
+	d->path = Mem.alloc(strlen(path) + 1);
+	strcpy(d->path, path);
+	List.add(w->dirs, d);
+	StrMap.put(w->by_dir, d->path, d);
+}
+/**
+ * @brief Finds a watched directory by watch descriptor.
+ * @return Directory, or NULL if unknown.
+ */
+static watched_dir find_dir(watch w, int wd) {
+	for (int i = 0; i < List.count(w->dirs); i++) {
+		watched_dir d = List.getAt(w->dirs, i);
+		if (d->wd == wd) return d;
+	}
+	return NULL;
+}
+/**
+ * @brief Returns the directory part of a path as written ("." if there is none).
+ * @return Allocated path (caller frees).
+ */
+static string dir_of(const string path) {
+	const char* slash = strrchr(path, '/');
+	size_t len = slash ? (size_t)(slash - path) : 1;
+	if (slash == path) len = 1;		//	"/file"
+	string dir = Mem.alloc(len + 1);
+	memcpy(dir, slash ? path : ".", len);
+	dir[len] = '\0';
+	return dir;
+}
+/**
+ * @brief Reads a burst of events: keeps reading until the directories have
+ *			been quiet for WATCH_DEBOUNCE_MS, or WATCH_MAX_DELAY_MS has passed.
+ * @param w Watch session.
+ * @param changed Output: changed sources, each once.
+ * @param reload Output: set when the targets must be rebuilt.
+ * @return 0 on success, non-zero if reading failed.
+ */
+static int read_burst(watch w, list changed, int* reload) {
+	char buf[EVENT_BUFFER] __attribute__((aligned(__alignof__(struct inotify_event))));
+	double start = now_ms();
+
+	while (1) {
+		ssize_t n = read(w->fd, buf, sizeof(buf));
+		if (n < 0 && errno != EINTR && errno != EAGAIN) return 1;
+		for (char* p = buf; n > 0 && p < buf + n; ) {
+			struct inotify_event* ev = (struct inotify_event*)p;
+			on_event(w, ev, changed, reload);
+			p += sizeof(struct inotify_event) + ev->len;
+		}
+
+		int wait = WATCH_MAX_DELAY_MS - (int)(now_ms() - start);
+		if (wait > WATCH_DEBOUNCE_MS) wait = WATCH_DEBOUNCE_MS;
+		struct pollfd pfd = { w->fd, POLLIN, 0 };
+		if (STOP || wait <= 0 || poll(&pfd, 1, wait) <= 0) break;
+	}
+	return 0;
+}
+/**
+ * @brief Classifies one inotify event.
+ * @param w Watch session.
+ * @param ev Event.
+ * @param changed Changed sources, each once.
+ * @param reload Set when the targets must be rebuilt.
+ */
+static void on_event(watch w, struct inotify_event* ev, list changed, int* reload) {
+	if (ev->mask & IN_Q_OVERFLOW) {
+		*reload = 1;
+		return;
+	}
+	watched_dir d = find_dir(w, ev->wd);
+	if (!d || ev->len == 0) return;
+
+	//	rebuild the path the way the targets spell it
+	size_t len = strlen(d->path) + strlen(ev->name) + 2;
+	string path = Mem.alloc(len);
+	if (strcmp(d->path, ".") == 0) {
+		snprintf(path, len, "%s", ev->name);
+	} else {
+		snprintf(path, len, "%s%s%s", d->path, strcmp(d->path, "/") == 0 ? "" : "/", ev->name);
+	}
+
+	docset_source ds = w->set ? DocSet.find(w->set, path) : NULL;
+	if (strcmp(path, w->config->file) == 0) {
+		if (ev->mask & (IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE)) *reload = 1;
+	} else if (ds) {
+		//	saved in place, replaced or removed: settled when the burst ends
+		if (List.indexOf(changed, ds) < 0) List.add(changed, ds);
+	} else if ((ev->mask & (IN_CREATE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM)) && is_source_name(ev->name)) {
+		//	may belong to a `dir/*` wildcard
+		*reload = 1;
+	}
+
+	Mem.free(path);
+}
+/**
+ * @brief Tests whether a file name has a C source or header extension.
+ */
+static int is_source_name(const char* name) {
+	size_t len = strlen(name);
+	return len > 2 && name[len - 2] == '.' && (name[len - 1] == 'c' || name[len - 1] == 'h');
+}
+/**
+ * @brief Monotonic clock in milliseconds.
+ */
+static double now_ms(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+/**
+ * @brief Stops the watch loop on SIGINT/SIGTERM.
+ */
+static void on_signal(int sig) {
+	(void)sig;
+	STOP = 1;
+}
+
+const IWatch Watch = {
+	.run = watch_run
+};
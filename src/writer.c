@@ -1,18 +1,213 @@
 // writer.c
+#define _POSIX_C_SOURCE 200809L
 #include "writer.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-static int write_file(const string data, const string filepath) {
-	FILE* out = fopen(filepath, "w");
+#define COMPARE_BLOCK 65536
+
+static writer_stats STATS = { 0, 0 };
+static mode_t FILE_MODE = 0644;
+static pthread_once_t MODE_ONCE = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Reads the process umask once; temporary files get the mode fopen would.
+ */
+static void mode_init(void) {
+	mode_t mask = umask(022);
+	umask(mask);
+	FILE_MODE = 0666 & ~mask;
+}
+/**
+ * @brief Reads up to len bytes, retrying short reads.
+ * @return Bytes read; less than len only at end of file or on error.
+ */
+static size_t read_full(int fd, char* buf, size_t len) {
+	size_t total = 0;
+	while (total < len) {
+		ssize_t n = read(fd, buf + total, len - total);
+		if (n <= 0) break;
+		total += n;
+	}
+	return total;
+}
+/**
+ * @brief Tests whether a file holds exactly the given bytes.
+ * @details The sizes are compared first; only same-size files are read, one
+ *			block at a time.
+ * @return 1 if the content matches, 0 otherwise (or if the file cannot be read).
+ */
+static int same_as_data(const string filepath, const char* data, size_t len) {
+	struct stat st;
+	if (stat(filepath, &st) != 0 || !S_ISREG(st.st_mode) || (size_t)st.st_size != len) return 0;
+
+	int fd = open(filepath, O_RDONLY);
+	if (fd < 0) return 0;
+
+	char* block = Mem.alloc(COMPARE_BLOCK);
+	int same = block != NULL;
+	size_t offset = 0;
+	while (same && offset < len) {
+		size_t want = len - offset < COMPARE_BLOCK ? len - offset : COMPARE_BLOCK;
+		same = read_full(fd, block, want) == want && memcmp(block, data + offset, want) == 0;
+		offset += want;
+	}
+
+	Mem.free(block);
+	close(fd);
+	return same;
+}
+/**
+ * @brief Tests whether two files have the same content.
+ * @details The sizes are compared first; only same-size files are read, one
+ *			block of each at a time.
+ * @return 1 if the content matches, 0 otherwise (or if either cannot be read).
+ */
+static int same_as_file(const string a, const string b) {
+	struct stat sa, sb;
+	if (stat(a, &sa) != 0 || stat(b, &sb) != 0 || !S_ISREG(sb.st_mode) || sa.st_size != sb.st_size) return 0;
+
+	int fa = open(a, O_RDONLY);
+	int fb = open(b, O_RDONLY);
+	char* block = Mem.alloc(2 * COMPARE_BLOCK);
+	int same = fa >= 0 && fb >= 0 && block != NULL;
+	size_t left = sa.st_size;
+	while (same && left > 0) {
+		size_t want = left < COMPARE_BLOCK ? left : COMPARE_BLOCK;
+		same = read_full(fa, block, want) == want &&
+		       read_full(fb, block + COMPARE_BLOCK, want) == want &&
+		       memcmp(block, block + COMPARE_BLOCK, want) == 0;
+		left -= want;
+	}
+
+	Mem.free(block);
+	if (fa >= 0) close(fa);
+	if (fb >= 0) close(fb);
+	return same;
+}
+/**
+ * @brief Prepares a finished temporary file for the rename: gives it the
+ *			mode of the file it replaces, if any, and flushes it to disk so a
+ *			crash cannot leave an empty or truncated file under the final name.
+ * @param fd Descriptor of the temporary file.
+ * @param filepath Destination file path.
+ * @return 0 on success, non-zero if the data cannot be synced.
+ */
+static int sync_file(int fd, const string filepath) {
+	struct stat st;
+	if (stat(filepath, &st) == 0) fchmod(fd, st.st_mode & 07777);
+	while (fsync(fd) != 0) {
+		if (errno != EINTR) return 1;
+	}
+	return 0;
+}
+/**
+ * @brief Creates a temporary file next to a destination.
+ * @param filepath Destination file path.
+ * @param temp Output: allocated temporary file path (caller frees).
+ * @return Stream open for writing, or NULL on failure.
+ */
+static FILE* begin_file(const string filepath, string* temp) {
+	pthread_once(&MODE_ONCE, mode_init);
+	*temp = NULL;
+
+	FILE* out = NULL;
+	string path = NULL;
+	int fd = -1;
+	if (filepath) {
+		size_t len = strlen(filepath) + 8;
+		path = Mem.alloc(len);
+		snprintf(path, len, "%s.XXXXXX", filepath);
+		fd = mkstemp(path);
+	}
+	if (fd >= 0) {
+		fchmod(fd, FILE_MODE);
+		out = fdopen(fd, "w");
+		if (!out) {
+			close(fd);
+			unlink(path);
+		}
+	}
 	if (!out) {
-		fprintf(stderr, "Failed to open '%s' for writing\n", filepath);
+		fprintf(stderr, "Failed to open '%s' for writing\n", filepath ? filepath : "(null)");
+		if (path) Mem.free(path);
+		return NULL;
+	}
+
+	*temp = path;
+	return out;
+}
+/**
+ * @brief Moves a finished temporary file into place, or discards it when the
+ *			destination is unchanged.
+ * @param temp Temporary file path (closed).
+ * @param filepath Destination file path.
+ * @return 0 on success, non-zero on failure.
+ */
+static int commit_file(const string temp, const string filepath) {
+	if (same_as_file(temp, filepath)) {
+		unlink(temp);
+		__atomic_add_fetch(&STATS.skipped, 1, __ATOMIC_RELAXED);
+		return 0;
+	}
+	int fd = open(temp, O_RDONLY);
+	int synced = fd >= 0 && sync_file(fd, filepath) == 0;
+	if (fd >= 0) close(fd);
+	if (!synced || rename(temp, filepath) != 0) {
+		fprintf(stderr, "Failed to replace '%s'\n", filepath);
+		unlink(temp);
 		return 1;
 	}
-	
-	fprintf(out, "%s", data);
-	fclose(out);
+	__atomic_add_fetch(&STATS.written, 1, __ATOMIC_RELAXED);
 	return 0;
 }
+/**
+ * @brief Writes data to a destination unless it already holds the same bytes.
+ * @param data String to write.
+ * @param filepath Destination file path.
+ * @return 0 on success, non-zero on failure.
+ */
+static int write_file(const string data, const string filepath) {
+	size_t len = strlen(data);
+	if (filepath && same_as_data(filepath, data, len)) {
+		__atomic_add_fetch(&STATS.skipped, 1, __ATOMIC_RELAXED);
+		return 0;
+	}
+
+	string temp = NULL;
+	FILE* out = begin_file(filepath, &temp);
+	if (!out) return 1;
+
+	int failed = fwrite(data, 1, len, out) != len || fflush(out) != 0 || sync_file(fileno(out), filepath) != 0;
+	if (fclose(out) != 0) failed = 1;
+	if (failed || rename(temp, filepath) != 0) {
+		fprintf(stderr, "Failed to write '%s'\n", filepath);
+		unlink(temp);
+		Mem.free(temp);
+		return 1;
+	}
+
+	__atomic_add_fetch(&STATS.written, 1, __ATOMIC_RELAXED);
+	Mem.free(temp);
+	return 0;
+}
+/**
+ * @brief Returns a snapshot of the written/skipped counters.
+ */
+static writer_stats writer_get_stats(void) {
+	writer_stats s;
+	s.written = __atomic_load_n(&STATS.written, __ATOMIC_RELAXED);
+	s.skipped = __atomic_load_n(&STATS.skipped, __ATOMIC_RELAXED);
+	return s;
+}
 
 const IWriter FileWriter = {
-    .write = write_file
+    .write = write_file,
+    .begin = begin_file,
+    .commit = commit_file,
+    .stats = writer_get_stats
 };
@@ -0,0 +1,48 @@
+#!/bin/sh
+# Renders the targets of test/fixtures/Doxy2MD and compares each document with
+# test/expected/<target>.md (run by `make fixturetest`).
+# Usage: test/fixture_test.sh [path/to/doxy]
+set -u
+
+BIN=${1:-bin/doxy}
+DOXY=$(cd "$(dirname "$BIN")" && pwd)/$(basename "$BIN")
+TEST=$(cd "$(dirname "$0")" && pwd)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+FAILED=0
+fail() {
+	echo "fixture test: FAIL: $*"
+	FAILED=1
+}
+
+cp -R "$TEST/fixtures/." "$WORK/" || exit 1
+cd "$WORK" || exit 1
+mkdir out
+
+# lexer: openers and closers in literals, `//` comments and nested `#if 0`, single-line blocks
+# decls: K&R definitions, functions returning function pointers, macro prefixes
+# globs: `**` sources and exclude= by name and by path
+for target in lexer decls globs; do
+	if ! "$DOXY" "$target" --no-cache > "$target.log" 2>&1; then
+		fail "$target: doxy failed"
+		cat "$target.log"
+	elif ! diff -u "$TEST/expected/$target.md" "out/$target.md"; then
+		fail "$target: output differs from test/expected/$target.md"
+	fi
+done
+
+# --all reads the configuration named on the command line
+mv Doxy2MD fixtures.cfg
+rm -f out/*.md
+if ! "$DOXY" --all fixtures.cfg --no-cache > all.log 2>&1; then
+	fail "--all fixtures.cfg: doxy failed"
+	cat all.log
+else
+	for target in lexer decls globs; do
+		cmp -s "$TEST/expected/$target.md" "out/$target.md" || fail "--all fixtures.cfg: $target differs"
+	done
+fi
+
+[ $FAILED -eq 0 ] || exit 1
+echo "fixture test: OK"
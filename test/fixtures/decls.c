@@ -0,0 +1,29 @@
+// decls.c: declaration kinds read after comment blocks
+
+/**
+ * @brief Adds two numbers, K&R style.
+ * @param a First.
+ * @param b Second.
+ */
+int add(a, b)
+	int a;
+	int b;
+{
+	return a + b;
+}
+
+/**
+ * @brief Looks up a handler.
+ * @param name Handler name.
+ * @return Handler taking a code.
+ */
+void (*lookup(const char* name))(int code);
+
+/** @brief Old entry point. */
+DEPRECATED("use run") API int start(void);
+
+/** @brief Callback table. */
+typedef struct ops {
+	/** @brief Writes a buffer. */
+	int (*write)(const char* buf, int len);
+} ops;
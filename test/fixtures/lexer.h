@@ -0,0 +1,33 @@
+// lexer.h: comment openers and closers the lexer must not take at face value
+
+/** @brief Greeting whose text holds a closer. */
+static const char* GREETING = "*/ not a closer";
+
+// /** not an opener
+int plain_line;
+
+#if 0
+/** @brief Disabled. */
+#if 1
+/** @brief Disabled as well, inside a nested group. */
+#endif
+int disabled;
+#endif
+
+/** @brief Count of items. */ int count;
+
+/**
+ * @brief Closes a stream.
+ * @param fd Descriptor.
+ * @return 0 on success.
+ */
+int stream_close(int fd);
+
+/** @brief Followed directly by a conditional, which still disables the next block. */
+#if 0
+/** @brief Hidden behind the conditional. */
+int hidden;
+#endif
+
+/** @brief Object-like macro. */
+#define LEXER_LIMIT 16
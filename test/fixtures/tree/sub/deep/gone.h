@@ -0,0 +1,2 @@
+/** @brief Excluded by path. */
+int gone(void);
@@ -0,0 +1,2 @@
+/** @brief Nested two levels down. */
+int leaf(void);
@@ -0,0 +1,2 @@
+/** @brief Excluded by name. */
+int skipped(void);
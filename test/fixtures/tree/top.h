@@ -0,0 +1,2 @@
+/** @brief Top level. */
+int top(void);
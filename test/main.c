@@ -11,25 +11,6 @@
 
 #include <stdio.h>
 
-static void free_debug_comment(comment c) {
-	if (!c) return;
-	if (c->brief) Mem.free(c->brief);
-	if (c->details) StringBuilder.free(c->details);
-	if (c->params) {
-		for (int i = 0; i < List.count(c->params); i++) {
-			Mem.free(List.getAt(c->params, i));
-		}
-		List.free(c->params);
-	}
-	if (c->ret) Mem.free(c->ret);
-	if (c->signature) Mem.free(c->signature);
-	if (c->func_name) Mem.free(c->func_name);
-	if (c->ret_type) Mem.free(c->ret_type);
-	if (c->filename) Mem.free(c->filename);
-	
-	Mem.free(c);
-}
-
 /**
  * @brief Main entry for the `doxy` command 
  * @detail `<target>` to specify target configuration
@@ -50,11 +31,11 @@ int main(int argc, string* argv) {
 	List.add(config.sources, "include/md_generator.h");
 	List.add(config.sources, "include/writer.h");
 	
-	list comments = Parser.parseDoxy(&config);
-	printf("Parsed %d comments\n", List.count(comments));
+	list units = Parser.parseDoxy(&config);
+	printf("Parsed %d files\n", List.count(units));
 
 	string_builder sb = StringBuilder.new(1024);
-	MDGenerator.generate(sb, comments, NULL); // No template yet
+	MDGenerator.generate(sb, units, NULL, NULL); // No links or template yet
 	
 	string output = StringBuilder.toString(sb);
 	if (FileWriter.write(output, config.output) == 0) {
@@ -65,13 +46,7 @@ int main(int argc, string* argv) {
 	
 	Mem.free(output);
 	StringBuilder.free(sb);
-	//	clean up comments list
-	iterator it = Array.getIterator(comments, LIST);
-	while (Iterator.hasNext(it)) {
-		free_debug_comment(Iterator.next(it));
-	}
-	Iterator.free(it);
-	List.free(comments);
+	Parser.release(units);
 	List.free(config.sources);
 	
 	return 0;
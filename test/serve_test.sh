@@ -0,0 +1,111 @@
+#!/bin/sh
+# End-to-end test of `doxy --serve` and `doxy --connect` (run by `make servetest`).
+# Usage: test/serve_test.sh [path/to/doxy]
+set -u
+
+BIN=${1:-bin/doxy}
+DOXY=$(cd "$(dirname "$BIN")" && pwd)/$(basename "$BIN")
+WORK=$(mktemp -d)
+SOCK=$WORK/doxy.sock
+PID=
+trap '[ -n "$PID" ] && kill $PID 2>/dev/null; rm -rf "$WORK"' EXIT
+
+fail() {
+	echo "serve test: FAIL: $*"
+	[ -f "$WORK/serve.log" ] && cat "$WORK/serve.log"
+	exit 1
+}
+ask() {
+	"$DOXY" --connect "$SOCK" "$@"
+}
+
+cd "$WORK" || exit 1
+mkdir src docs
+cat > src/math.h <<'EOF'
+/** @brief Adds two numbers. */
+int add(int a, int b);
+/**
+ * @brief Subtracts two numbers.
+ * @param a Minuend.
+ * @param b Subtrahend.
+ */
+int sub(int a, int b);
+EOF
+cat > src/io.h <<'EOF'
+/** @brief Prints a number. */
+void print(int n);
+EOF
+cat > Doxy2MD <<'EOF'
+math: src/math.h outdir=docs
+all: src/math.h src/io.h outdir=docs
+EOF
+
+"$DOXY" --serve "$SOCK" --no-cache -j 4 > serve.log 2>&1 &
+PID=$!
+i=0
+while [ ! -S "$SOCK" ]; do
+	kill -0 $PID 2>/dev/null || fail "server exited"
+	i=$((i + 1))
+	[ $i -lt 100 ] || fail "server did not start"
+	sleep 0.05
+done
+
+[ "$(ask ping)" = pong ] || fail "ping"
+ask targets | grep -q "^all docs/all.md$" || fail "targets"
+
+out=$(ask render math) || fail "render"
+[ "$out" = docs/math.md ] || fail "render answered '$out'"
+grep -q "Adds two numbers" docs/math.md || fail "rendered document"
+ask render nothing 2>/dev/null && fail "unknown target accepted"
+
+ask symbol sub | grep -q "int sub(int a, int b)" || fail "symbol"
+ask symbol missing 2>/dev/null && fail "unknown symbol accepted"
+
+# an edit is picked up after invalidate, for every target that includes the file
+sed -i 's/Adds two numbers/Adds two integers/' src/math.h
+[ "$(ask invalidate src/math.h | sort | tr '\n' ' ')" = "all math " ] || fail "invalidate"
+ask render all > /dev/null || fail "render after invalidate"
+grep -q "Adds two integers" docs/all.md || fail "invalidated source not re-parsed"
+grep -q "Prints a number" docs/all.md || fail "other source lost"
+ask symbol add | grep -q "Adds two integers" || fail "symbol after invalidate"
+ask invalidate src/none.h 2>/dev/null && fail "unknown source accepted"
+
+# concurrent clients
+CLIENTS=
+for n in 1 2 3 4 5 6 7 8; do
+	(ask render math > "out.$n" && ask symbol print >> "out.$n") &
+	CLIENTS="$CLIENTS $!"
+done
+for c in $CLIENTS; do wait $c; done
+for n in 1 2 3 4 5 6 7 8; do
+	grep -q "Prints a number" "out.$n" || fail "concurrent client $n"
+done
+
+# more idle and half-sent connections than workers leave the server answering
+if command -v perl > /dev/null; then
+	perl -MIO::Socket::UNIX -e '
+		my @held;
+		for (1 .. 6) { push @held, IO::Socket::UNIX->new(Peer => $ARGV[0]) or die }
+		my $half = IO::Socket::UNIX->new(Peer => $ARGV[0]) or die;
+		syswrite $half, "\0\0";
+		push @held, $half;
+		open my $ready, ">", $ARGV[1]; close $ready;
+		sleep 30;' "$SOCK" held.ready &
+	HELD=$!
+	i=0
+	while [ ! -e held.ready ]; do
+		i=$((i + 1))
+		[ $i -lt 100 ] || fail "idle clients did not connect"
+		sleep 0.05
+	done
+	[ "$(timeout 3 "$DOXY" --connect "$SOCK" ping)" = pong ] || fail "idle clients block the workers"
+	kill $HELD 2>/dev/null
+	wait $HELD 2>/dev/null
+fi
+
+ask reload > /dev/null || fail "reload"
+ask stop > /dev/null || fail "stop"
+wait $PID || fail "server exit status"
+PID=
+[ ! -e "$SOCK" ] || fail "socket left behind"
+echo "serve test: OK"